@@ -59,6 +59,43 @@ namespace vsgUnity.Editor
             {
                 _settings.autoAddCullNodes = false;
                 _settings.zeroRootTransform = false;
+                _settings.packMaterialMaps = false;
+
+                _settings.virtualTexturing = false;
+                _settings.virtualTextureMinSize = 8192;
+                _settings.virtualTexturePageSize = 128;
+                _settings.virtualTexturePageBorder = 4;
+
+                _settings.precompileShaders = true;
+                _settings.shaderOptimization = GraphBuilder.ExportSettings.ShaderOptimization.Performance;
+                _settings.shaderStripDebugInfo = true;
+                _settings.shaderCacheDirectory = Path.GetFullPath(Path.Combine(Application.dataPath, "..", "Library", "vsgUnityShaderCache"));
+                _settings.shaderCacheMaxSize = 256;
+                _settings.specializeShaderFeatures = false;
+
+                _settings.bindlessMaterials = false;
+                _settings.bindlessTextureCapacity = 4096;
+
+                _settings.depthOnlyPipelines = false;
+                _settings.sortStateGroups = true;
+                _settings.flattenHierarchy = true;
+                _settings.bakeStaticTransforms = false;
+                _settings.cullHierarchy = true;
+                _settings.cullHierarchyLeafSize = 8;
+                _settings.tiledOutput = false;
+                _settings.tileSize = 256.0f;
+                _settings.tileScreenHeightRatio = 0.1f;
+                _settings.hierarchicalLODs = false;
+                _settings.hlodClusterSize = 64.0f;
+                _settings.hlodScreenHeightRatio = 0.05f;
+                _settings.hlodProxyResolution = 32;
+                _settings.potentiallyVisibleSet = false;
+                _settings.pvsCellSize = 8.0f;
+                _settings.pvsResolution = 64;
+                _settings.streamLeafData = false;
+                _settings.packLeafData = false;
+                _settings.compressOutput = false;
+                _settings.compressionLevel = 3;
 
                 _settings.standardTerrainShaderMappingPath = PathForShaderAsset("standardTerrain-ShaderMapping");
 
@@ -162,6 +199,75 @@ namespace vsgUnity.Editor
 
             _settings.autoAddCullNodes = EditorGUILayout.Toggle("Add Cull Nodes", _settings.autoAddCullNodes);
             _settings.zeroRootTransform = EditorGUILayout.Toggle("Zero Root Transform", _settings.zeroRootTransform);
+            _settings.packMaterialMaps = EditorGUILayout.Toggle("Pack Material Maps", _settings.packMaterialMaps);
+
+            _settings.virtualTexturing = EditorGUILayout.BeginToggleGroup("Virtual Texturing", _settings.virtualTexturing);
+            {
+                _settings.virtualTextureMinSize = EditorGUILayout.IntField("Min Texture Size", _settings.virtualTextureMinSize);
+                _settings.virtualTexturePageSize = EditorGUILayout.IntField("Page Size", _settings.virtualTexturePageSize);
+                _settings.virtualTexturePageBorder = EditorGUILayout.IntField("Page Border", _settings.virtualTexturePageBorder);
+            }
+            EditorGUILayout.EndToggleGroup();
+
+            _settings.precompileShaders = EditorGUILayout.BeginToggleGroup("Precompile Shaders", _settings.precompileShaders);
+            {
+                _settings.shaderOptimization = (GraphBuilder.ExportSettings.ShaderOptimization)EditorGUILayout.EnumPopup("Optimization", _settings.shaderOptimization);
+                _settings.shaderStripDebugInfo = EditorGUILayout.Toggle("Strip Debug Info", _settings.shaderStripDebugInfo);
+                _settings.shaderCacheDirectory = EditorGUILayout.TextField("Cache Directory", _settings.shaderCacheDirectory);
+                _settings.shaderCacheMaxSize = EditorGUILayout.IntField("Cache Size (MB)", _settings.shaderCacheMaxSize);
+            }
+            EditorGUILayout.EndToggleGroup();
+
+            _settings.specializeShaderFeatures = EditorGUILayout.Toggle("Specialize Shader Features", _settings.specializeShaderFeatures);
+
+            _settings.bindlessMaterials = EditorGUILayout.BeginToggleGroup("Bindless Materials", _settings.bindlessMaterials);
+            {
+                _settings.bindlessTextureCapacity = EditorGUILayout.IntField("Texture Capacity", _settings.bindlessTextureCapacity);
+            }
+            EditorGUILayout.EndToggleGroup();
+
+            _settings.depthOnlyPipelines = EditorGUILayout.Toggle("Depth Only Pipelines", _settings.depthOnlyPipelines);
+            _settings.sortStateGroups = EditorGUILayout.Toggle("Sort State Groups", _settings.sortStateGroups);
+
+            _settings.flattenHierarchy = EditorGUILayout.Toggle("Flatten Hierarchy", _settings.flattenHierarchy);
+            _settings.bakeStaticTransforms = EditorGUILayout.Toggle("Bake Static Transforms", _settings.bakeStaticTransforms);
+
+            _settings.cullHierarchy = EditorGUILayout.BeginToggleGroup("Cull Hierarchy", _settings.cullHierarchy);
+            {
+                _settings.cullHierarchyLeafSize = EditorGUILayout.IntField("Leaf Size", _settings.cullHierarchyLeafSize);
+            }
+            EditorGUILayout.EndToggleGroup();
+
+            _settings.tiledOutput = EditorGUILayout.BeginToggleGroup("Tiled Output", _settings.tiledOutput);
+            {
+                _settings.tileSize = EditorGUILayout.FloatField("Tile Size", _settings.tileSize);
+                _settings.tileScreenHeightRatio = EditorGUILayout.FloatField("Load Screen Ratio", _settings.tileScreenHeightRatio);
+            }
+            EditorGUILayout.EndToggleGroup();
+
+            _settings.hierarchicalLODs = EditorGUILayout.BeginToggleGroup("Hierarchical LODs", _settings.hierarchicalLODs);
+            {
+                _settings.hlodClusterSize = EditorGUILayout.FloatField("Cluster Size", _settings.hlodClusterSize);
+                _settings.hlodScreenHeightRatio = EditorGUILayout.FloatField("Proxy Screen Ratio", _settings.hlodScreenHeightRatio);
+                _settings.hlodProxyResolution = EditorGUILayout.IntField("Proxy Resolution", _settings.hlodProxyResolution);
+            }
+            EditorGUILayout.EndToggleGroup();
+
+            _settings.potentiallyVisibleSet = EditorGUILayout.BeginToggleGroup("Potentially Visible Set", _settings.potentiallyVisibleSet);
+            {
+                _settings.pvsCellSize = EditorGUILayout.FloatField("Cell Size", _settings.pvsCellSize);
+                _settings.pvsResolution = EditorGUILayout.IntField("Occluder Resolution", _settings.pvsResolution);
+            }
+            EditorGUILayout.EndToggleGroup();
+
+            _settings.streamLeafData = EditorGUILayout.Toggle("Stream Leaf Data", _settings.streamLeafData);
+            _settings.packLeafData = EditorGUILayout.Toggle("Pack Leaf Data", _settings.packLeafData);
+
+            _settings.compressOutput = EditorGUILayout.BeginToggleGroup("Compress Output", _settings.compressOutput);
+            {
+                _settings.compressionLevel = EditorGUILayout.IntSlider("Level", _settings.compressionLevel, 1, 9);
+            }
+            EditorGUILayout.EndToggleGroup();
 
             EditorGUILayout.LabelField(_settings.standardTerrainShaderMappingPath);
 
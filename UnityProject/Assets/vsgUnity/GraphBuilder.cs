@@ -10,6 +10,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 </editor-fold> */
 
+using System;
 using System.Collections.Generic;
 using UnityEngine;
 
@@ -28,8 +29,123 @@ namespace vsgUnity
         {
             public bool autoAddCullNodes;
             public bool zeroRootTransform;
+
+            // single channel maps whose shader mapping declares a packed binding are combined into one rgba texture. these maps,
+            // such as the default mapping's occlusion and metallic maps, aren't exported at all when this is off
+            public bool packMaterialMaps;
             public string standardShaderMappingPath;
             public string standardTerrainShaderMappingPath;
+
+            // virtual texturing, textures at or above virtualTextureMinSize are paged out to a tile store file
+            public bool virtualTexturing;
+            public int virtualTextureMinSize;
+            public int virtualTexturePageSize;
+            public int virtualTexturePageBorder;
+
+            // shader precompilation, shaders are compiled to spirv at export rather than when the exported file is loaded
+            public enum ShaderOptimization
+            {
+                None = 0,
+                Performance = 1,
+                Size = 2
+            }
+
+            public bool precompileShaders;
+            public ShaderOptimization shaderOptimization;
+            public bool shaderStripDebugInfo;
+            public string shaderCacheDirectory; // compiled shaders are cached here between exports, empty disables the cache
+            public int shaderCacheMaxSize; // megabytes
+
+            // shaders that support it read feature toggles like lighting and normal mapping from specialization constants, so every
+            // combination of them shares one module per stage
+            public bool specializeShaderFeatures;
+
+            // bindless materials, shaders that support it read every material's textures and uniforms from one shared descriptor set
+            // selected by a push constant, so draws of different materials can be batched. the texture array holds bindlessTextureCapacity textures
+            public bool bindlessMaterials;
+            public int bindlessTextureCapacity;
+
+            // opaque draws also get a depth only variant using a position only vertex stream, for renderers running depth prepasses and shadow passes
+            public bool depthOnlyPipelines;
+
+            // reorder the graph before writing so draws sharing a pipeline and descriptor set are adjacent and rebind less state
+            public bool sortStateGroups;
+
+            // collapse empty groups and identity or chained transforms before writing, and optionally bake the transforms of static
+            // objects into copies of their vertex data
+            public bool flattenHierarchy;
+            public bool bakeStaticTransforms;
+
+            // groups with more than cullHierarchyLeafSize children get a bounding volume hierarchy of cull groups built over them, so
+            // culling wide scene roots doesn't visit every child
+            public bool cullHierarchy;
+            public int cullHierarchyLeafSize;
+
+            // the scene is split into square tiles of tileSize written to their own files, which viewers page in once a tile covers
+            // tileScreenHeightRatio of the screen height
+            public bool tiledOutput;
+            public float tileSize;
+            public float tileScreenHeightRatio;
+
+            // static objects are clustered into cells of hlodClusterSize, each cluster drawing a single simplified proxy once it covers
+            // less than hlodScreenHeightRatio of the screen height. hlodProxyResolution is the number of cells across a cluster its
+            // proxy's vertices are merged within
+            public bool hierarchicalLODs;
+            public float hlodClusterSize;
+            public float hlodScreenHeightRatio;
+            public int hlodProxyResolution;
+
+            // precompute which cullgroups can be seen from each cell of a grid of pvsCellSize over the scene, rendering static opaque
+            // occluders into cube maps of pvsResolution, so viewers only draw what the camera's cell can see
+            public bool potentiallyVisibleSet;
+            public float pvsCellSize;
+            public int pvsResolution;
+
+            // write vertex, index and texture data to a file beside the scene as each object is converted rather than holding all of it
+            // until the export ends, bounding the memory large scenes need. bakes no static transforms and writes no tiles
+            public bool streamLeafData;
+
+            // write vertex, index and texture data once each, in the order it's drawn, to a page aligned file beside the scene that the
+            // viewer maps in place rather than reading copies of. not written with tiles
+            public bool packLeafData;
+
+            // the scene file is compressed in chunks at compressionLevel, 1 fastest to 9 smallest, which are compressed and decompressed
+            // in parallel
+            public bool compressOutput;
+            public int compressionLevel;
+
+            public ExportSettingsData ToNative()
+            {
+                ExportSettingsData data = new ExportSettingsData
+                {
+                    virtualTextureMinSize = virtualTexturing ? virtualTextureMinSize : 0,
+                    virtualTexturePageSize = virtualTexturePageSize,
+                    virtualTexturePageBorder = virtualTexturePageBorder,
+                    precompileShaders = precompileShaders ? 1 : 0,
+                    shaderOptimization = (int)shaderOptimization,
+                    shaderStripDebugInfo = shaderStripDebugInfo ? 1 : 0,
+                    shaderCacheDirectory = string.IsNullOrEmpty(shaderCacheDirectory) ? IntPtr.Zero : NativeUtils.ToNative(shaderCacheDirectory),
+                    shaderCacheMaxSize = shaderCacheMaxSize,
+                    specializeShaderFeatures = specializeShaderFeatures ? 1 : 0,
+                    bindlessTextureCapacity = bindlessMaterials ? bindlessTextureCapacity : 0,
+                    depthOnlyPipelines = depthOnlyPipelines ? 1 : 0,
+                    sortStateGroups = sortStateGroups ? 1 : 0,
+                    flattenHierarchy = flattenHierarchy ? 1 : 0,
+                    bakeStaticTransforms = bakeStaticTransforms ? 1 : 0,
+                    cullHierarchyLeafSize = cullHierarchy ? cullHierarchyLeafSize : 0,
+                    tileSize = tiledOutput ? tileSize : 0.0f,
+                    tileScreenHeightRatio = tileScreenHeightRatio,
+                    hlodClusterSize = hierarchicalLODs ? hlodClusterSize : 0.0f,
+                    hlodScreenHeightRatio = hlodScreenHeightRatio,
+                    hlodProxyResolution = hlodProxyResolution,
+                    pvsCellSize = potentiallyVisibleSet ? pvsCellSize : 0.0f,
+                    pvsResolution = pvsResolution,
+                    streamLeafData = streamLeafData ? 1 : 0,
+                    packLeafData = packLeafData ? 1 : 0,
+                    compressionLevel = compressOutput ? compressionLevel : 0
+                };
+                return data;
+            }
         }
 
         public static void Export(GameObject[] gameObjects, string saveFileName, ExportSettings settings)
@@ -39,7 +155,9 @@ namespace vsgUnity
             MaterialConverter.ClearCaches();
             ShaderMappingIO.ClearCaches();
 
-            GraphBuilderInterface.unity2vsg_BeginExport();
+            MaterialConverter.packMaterialMaps = settings.packMaterialMaps;
+
+            GraphBuilderInterface.unity2vsg_BeginExport(settings.ToNative());
 
             List<PipelineData> storePipelines = new List<PipelineData>();
 
@@ -171,11 +289,19 @@ namespace vsgUnity
             foreach(GameObject go in gameObjects)
             {
                 processGameObject(go);
+
+                // the native side has written out this object's meshes and textures, so their converted data isn't kept for objects still to come
+                if (settings.streamLeafData)
+                {
+                    MeshConverter.ReleaseMeshData();
+                    NativeUtils.FreeReleasedNativeData();
+                }
             }
 
             //GraphBuilderInterface.unity2vsg_EndNode(); // step out of convert coord system node
 
             GraphBuilderInterface.unity2vsg_EndExport(saveFileName);
+            NativeUtils.FreeNativePointers();
             NativeLog.PrintReport();
         }
 
@@ -199,6 +325,11 @@ namespace vsgUnity
                 GraphBuilderInterface.unity2vsg_AddDescriptorBufferFloat(t);
                 addedAny = true;
             }
+            foreach (DescriptorUniformBlockData t in materialInfo.blockDescriptors)
+            {
+                GraphBuilderInterface.unity2vsg_AddDescriptorBufferBlock(t);
+                addedAny = true;
+            }
             if (addedAny) GraphBuilderInterface.unity2vsg_CreateBindDescriptorSetCommand(addToStateGroup ? 1 : 0);
         }
 
@@ -235,7 +366,7 @@ namespace vsgUnity
                     if (mat == null) continue;
 
                     MaterialInfo matdata = MaterialConverter.GetOrCreateMaterialData(mat);
-                    int matshaderid = matdata.shaderStages.id;
+                    int matshaderid = NativeUtils.GetPipelineKeyForMaterial(matdata);
 
                     if (!meshMaterials.ContainsKey(matshaderid)) meshMaterials.Add(matshaderid, new Dictionary<MaterialInfo, List<int>>());
                     if (!meshMaterials[matshaderid].ContainsKey(matdata)) meshMaterials[matshaderid].Add(matdata, new List<int>());
@@ -259,7 +390,7 @@ namespace vsgUnity
                         PipelineData pipelineData = NativeUtils.CreatePipelineData(meshInfo); //WE NEED INFO ABOUT THE SHADER SO WE CAN BUILD A PIPLE LINE
                         pipelineData.descriptorBindings = NativeUtils.WrapArray(mds[0].descriptorBindings.ToArray());
                         pipelineData.shaderStages = mds[0].shaderStages.ToNative();
-                        pipelineData.useAlpha = mds[0].useAlpha;
+                        NativeUtils.SetPipelineState(ref pipelineData, mds[0]);
                         pipelineData.id = NativeUtils.ToNative(NativeUtils.GetIDForPipeline(pipelineData));
                         storePipelines.Add(pipelineData);
 
@@ -306,7 +437,7 @@ namespace vsgUnity
                             PipelineData pipelineData = NativeUtils.CreatePipelineData(meshInfo); //WE NEED INFO ABOUT THE SHADER SO WE CAN BUILD A PIPLE LINE
                             pipelineData.descriptorBindings = NativeUtils.WrapArray(mds[0].descriptorBindings.ToArray());
                             pipelineData.shaderStages = mds[0].shaderStages.ToNative();
-                            pipelineData.useAlpha = mds[0].useAlpha;
+                            NativeUtils.SetPipelineState(ref pipelineData, mds[0]);
                             pipelineData.id = NativeUtils.ToNative(NativeUtils.GetIDForPipeline(pipelineData));
                             storePipelines.Add(pipelineData);
 
@@ -349,6 +480,9 @@ namespace vsgUnity
             pipelineData.hasNormals = 1;
             pipelineData.uvChannelCount = 1;
             pipelineData.useAlpha = 0;
+            pipelineData.cullMode = (int)VkCullModeFlagBits.VK_CULL_MODE_BACK_BIT;
+            pipelineData.depthWrite = 1;
+            pipelineData.depthCompareOp = (int)VkCompareOp.VK_COMPARE_OP_LESS_OR_EQUAL;
 
             if (terrainInfo.customMaterial == null)
             {
@@ -396,6 +530,7 @@ namespace vsgUnity
             {
                 pipelineData.descriptorBindings = NativeUtils.WrapArray(terrainInfo.customMaterial.descriptorBindings.ToArray());
                 pipelineData.shaderStages = terrainInfo.customMaterial.shaderStages.ToNative();
+                NativeUtils.SetPipelineState(ref pipelineData, terrainInfo.customMaterial);
                 pipelineData.id = NativeUtils.ToNative(NativeUtils.GetIDForPipeline(pipelineData));
                 storePipelines.Add(pipelineData);
 
@@ -93,9 +93,13 @@ namespace vsgUnity
         public List<DescriptorImageData> imageDescriptors = new List<DescriptorImageData>();
         public List<DescriptorFloatUniformData> floatDescriptors = new List<DescriptorFloatUniformData>();
         public List<DescriptorVectorUniformData> vectorDescriptors = new List<DescriptorVectorUniformData>();
+        public List<DescriptorUniformBlockData> blockDescriptors = new List<DescriptorUniformBlockData>();
         public List<VkDescriptorSetLayoutBinding> descriptorBindings = new List<VkDescriptorSetLayoutBinding>();
         public List<string> customDefines = new List<string>();
         public int useAlpha;
+        public VkCullModeFlagBits cullMode = VkCullModeFlagBits.VK_CULL_MODE_BACK_BIT;
+        public int depthWrite = 1;
+        public VkCompareOp depthCompareOp = VkCompareOp.VK_COMPARE_OP_LESS_OR_EQUAL;
     }
 
     /// <summary>
@@ -110,6 +114,9 @@ namespace vsgUnity
         public static Dictionary<int, ShaderStageInfo> _shaderStageInfoCache = new Dictionary<int, ShaderStageInfo>();
         public static Dictionary<int, ShaderStagesInfo> _shaderStagesInfoCache = new Dictionary<int, ShaderStagesInfo>();
 
+        // set from the export settings, maps whose mapping declares a packed binding are only exported when packing
+        public static bool packMaterialMaps = false;
+
         public static void ClearCaches()
         {
             _materialDataCache.Clear();
@@ -310,11 +317,49 @@ namespace vsgUnity
             // process uniforms
             UniformMappedData[] uniformDatas = mapping.GetUniformDatasFromMaterial(material);
 
+            // packable maps grouped by the binding of the texture they pack into, these are processed after the other uniforms
+            Dictionary<int, List<UniformMappedData>> packedGroups = new Dictionary<int, List<UniformMappedData>>();
+
+            // float, vector and color uniforms are written into a single std140 block when the mapping has a uniform block binding
+            int blockSize;
+            int[] blockOffsets = mapping.GetUniformBlockOffsets(out blockSize);
+            float[] blockData = new float[blockSize];
+            VkShaderStageFlagBits blockStages = (VkShaderStageFlagBits)0;
+
             foreach (UniformMappedData uniData in uniformDatas)
             {
                 VkDescriptorType descriptorType = VkDescriptorType.VK_DESCRIPTOR_TYPE_MAX_ENUM;
                 uint descriptorCount = 1;
 
+                if (mapping.IsBlockUniform(uniData.mapping))
+                {
+                    int offset = blockOffsets[mapping.uniformMappings.IndexOf(uniData.mapping)];
+                    if (uniData.data is float)
+                    {
+                        blockData[offset] = (float)uniData.data;
+                    }
+                    else
+                    {
+                        Vector4 vector = uniData.data is Color ? (Vector4)(Color)uniData.data : (Vector4)uniData.data;
+                        for (int i = 0; i < 4; i++) blockData[offset + i] = vector[i];
+                    }
+                    blockStages |= uniData.mapping.stages;
+
+                    if (uniData.mapping.vsgDefines != null && uniData.mapping.vsgDefines.Count > 0) matdata.customDefines.AddRange(uniData.mapping.vsgDefines);
+                    continue;
+                }
+
+                // mappings gain packable maps without changing what's exported for their materials when packing is off
+                if (uniData.mapping.IsPackable() && !packMaterialMaps) continue;
+
+                Texture2D packableTex = uniData.data as Texture2D;
+                if (uniData.mapping.IsPackable() && packableTex != null && packableTex.isReadable)
+                {
+                    if (!packedGroups.ContainsKey(uniData.mapping.packedBindingIndex)) packedGroups[uniData.mapping.packedBindingIndex] = new List<UniformMappedData>();
+                    packedGroups[uniData.mapping.packedBindingIndex].Add(uniData);
+                    continue;
+                }
+
                 if (uniData.mapping.uniformType == UniformMapping.UniformType.Texture2DUniform)
                 {
                     Texture tex = uniData.data as Texture;
@@ -396,6 +441,80 @@ namespace vsgUnity
                 matdata.descriptorBindings.Add(descriptorBinding);
             }
 
+            if (blockStages != 0)
+            {
+                DescriptorUniformBlockData descriptorBlock = new DescriptorUniformBlockData
+                {
+                    id = material.GetInstanceID(),
+                    binding = mapping.uniformBlockBinding,
+                    value = NativeUtils.ToNative(NativeUtils.WrapArray(blockData))
+                };
+                matdata.blockDescriptors.Add(descriptorBlock);
+
+                VkDescriptorSetLayoutBinding descriptorBinding = new VkDescriptorSetLayoutBinding
+                {
+                    binding = (uint)mapping.uniformBlockBinding,
+                    descriptorType = VkDescriptorType.VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+                    descriptorCount = 1,
+                    stageFlags = blockStages,
+                    pImmutableSamplers = System.IntPtr.Zero
+                };
+                matdata.descriptorBindings.Add(descriptorBinding);
+            }
+
+            // combine the channels of each packed group into a single texture, a lone map gains nothing from packing so is bound as is
+            foreach (KeyValuePair<int, List<UniformMappedData>> group in packedGroups)
+            {
+                DescriptorImageData descriptorImage;
+                VkShaderStageFlagBits stages = (VkShaderStageFlagBits)0;
+                int binding;
+
+                if (group.Value.Count == 1)
+                {
+                    UniformMappedData uniData = group.Value[0];
+                    descriptorImage = GetOrCreateDescriptorImageData(TextureConverter.GetOrCreateImageData(uniData.data as Texture), uniData.mapping.vsgBindingIndex);
+                    if (uniData.mapping.vsgDefines != null) matdata.customDefines.AddRange(uniData.mapping.vsgDefines);
+                    stages = uniData.mapping.stages;
+                    binding = uniData.mapping.vsgBindingIndex;
+                }
+                else
+                {
+                    List<TextureConverter.PackedChannelSource> sources = new List<TextureConverter.PackedChannelSource>();
+                    foreach (UniformMappedData uniData in group.Value)
+                    {
+                        sources.Add(new TextureConverter.PackedChannelSource
+                        {
+                            texture = uniData.data as Texture2D,
+                            sourceChannel = uniData.mapping.sourceChannel,
+                            packedChannel = uniData.mapping.packedChannel
+                        });
+                        if (uniData.mapping.packedDefines != null)
+                        {
+                            foreach (string define in uniData.mapping.packedDefines)
+                            {
+                                if (!matdata.customDefines.Contains(define)) matdata.customDefines.Add(define);
+                            }
+                        }
+                        stages |= uniData.mapping.stages;
+                    }
+
+                    descriptorImage = GetOrCreateDescriptorImageData(TextureConverter.GetOrCreatePackedImageData(sources.ToArray()), group.Key);
+                    binding = group.Key;
+                }
+
+                matdata.imageDescriptors.Add(descriptorImage);
+
+                VkDescriptorSetLayoutBinding descriptorBinding = new VkDescriptorSetLayoutBinding
+                {
+                    binding = (uint)binding,
+                    descriptorType = VkDescriptorType.VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                    descriptorCount = 1,
+                    stageFlags = stages,
+                    pImmutableSamplers = System.IntPtr.Zero
+                };
+                matdata.descriptorBindings.Add(descriptorBinding);
+            }
+
             if (material != null)
             {
                 string rendertype = material.GetTag("RenderType", true, "Opaque");
@@ -406,6 +525,13 @@ namespace vsgUnity
                 if (lightmode != "Always") matdata.customDefines.Add("VSG_LIGHTING");
             }
 
+            if (mapping.pipelineState != null)
+            {
+                matdata.cullMode = mapping.pipelineState.GetCullMode(material);
+                matdata.depthWrite = mapping.pipelineState.GetDepthWrite(material, matdata.useAlpha == 1) ? 1 : 0;
+                matdata.depthCompareOp = mapping.pipelineState.GetDepthCompareOp(material);
+            }
+
             // lastly process shaders now we know the defines etc it will use
             string customDefinesStr = string.Join(",", matdata.customDefines.ToArray());
 
@@ -44,6 +44,18 @@ namespace vsgUnity
             }
         }
         public List<SubMesh> submeshs = new List<SubMesh>();
+
+        // drop the arrays but keep their lengths, the native side draws the mesh from what it converted under the mesh id
+        public void ReleaseArrays()
+        {
+            verticies.data = null;
+            normals.data = null;
+            tangents.data = null;
+            colors.data = null;
+            uv0.data = null;
+            uv1.data = null;
+            triangles.data = null;
+        }
         
 
         public bool Equals(MeshInfo b)
@@ -84,6 +96,27 @@ namespace vsgUnity
             _drawIndexedIDCount = 0;
         }
 
+        // drop the converted mesh arrays. the infos of meshes passed to the native side are kept without them so they aren't converted again
+        public static void ReleaseMeshData()
+        {
+            foreach (KeyValuePair<int, MeshInfo> cached in _meshInfoCache.ToList())
+            {
+                // infos released before were passed to the native side by an earlier object
+                int id = cached.Value.id;
+                if (_vertexBuffersDataCache.ContainsKey(id) || _vertexIndexDrawDataCache.ContainsKey(id))
+                {
+                    cached.Value.ReleaseArrays();
+                }
+                else if (cached.Value.verticies.data != null)
+                {
+                    _meshInfoCache.Remove(cached.Key);
+                }
+            }
+            _indexBufferDataCache.Clear();
+            _vertexIndexDrawDataCache.Clear();
+            _vertexBuffersDataCache.Clear();
+        }
+
         public static MeshInfo GetOrCreateMeshInfo(Mesh mesh)
         {
             if (_meshInfoCache.ContainsKey(mesh.GetInstanceID()))
@@ -17,11 +17,14 @@ namespace vsgUnity.Native
     public static class GraphBuilderInterface
     {
         [DllImport(Library.libraryName, EntryPoint = "unity2vsg_BeginExport")]
-        public static extern void unity2vsg_BeginExport();
+        public static extern void unity2vsg_BeginExport(ExportSettingsData settings);
 
         [DllImport(Library.libraryName, EntryPoint = "unity2vsg_EndExport")]
         public static extern void unity2vsg_EndExport([MarshalAs(UnmanagedType.LPStr)] string saveFileName);
 
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_TakeReleasedData")]
+        public static extern uint unity2vsg_TakeReleasedData([Out] System.IntPtr[] pointers, uint capacity);
+
         //
         // Nodes
         //
@@ -102,6 +105,9 @@ namespace vsgUnity.Native
         [DllImport(Library.libraryName, EntryPoint = "unity2vsg_AddDescriptorBufferVectorArray")]
         public static extern void unity2vsg_AddDescriptorBufferVectorArray(DescriptorVectorArrayUniformData data);
 
+        [DllImport(Library.libraryName, EntryPoint = "unity2vsg_AddDescriptorBufferBlock")]
+        public static extern void unity2vsg_AddDescriptorBufferBlock(DescriptorUniformBlockData data);
+
         //
         //
 
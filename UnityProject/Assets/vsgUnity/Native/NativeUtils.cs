@@ -248,11 +248,26 @@ namespace vsgUnity.Native
     // Image types
     //
 
+    // layout of the raw pixel bytes when they can't be uploaded as format directly and are converted by the native exporter
+    public enum ImageSourceFormat
+    {
+        Native = 0, // pixels are already in format
+        R8G8B8, // RGB24
+        B8G8R8,
+        A8R8G8B8, // ARGB32
+        B8G8R8A8, // BGRA32
+        A8, // Alpha8
+        R5G6B5_Pack16, // RGB565
+        R16G16B16_SFloat,
+        R32G32B32_SFloat
+    }
+
     public struct ImageData : IEquatable<ImageData>
     {
         public int id;
         public NativeArray pixels;
         public VkFormat format;
+        public ImageSourceFormat sourceFormat;
         public int width;
         public int height;
         public int depth;
@@ -266,6 +281,7 @@ namespace vsgUnity.Native
         public bool Equals(ImageData b)
         {
             return format == b.format &&
+                sourceFormat == b.sourceFormat &&
                 width == b.width &&
                 height == b.height &&
                 depth == b.depth &&
@@ -344,6 +360,20 @@ namespace vsgUnity.Native
         }
     }
 
+    // a material's float, vector and color uniforms packed into one std140 block
+
+    public struct DescriptorUniformBlockData : IEquatable<DescriptorUniformBlockData>
+    {
+        public int id;
+        public int binding;
+        public NativeArray value;
+
+        public bool Equals(DescriptorUniformBlockData b)
+        {
+            return binding == b.binding && value.Equals(b.value);
+        }
+    }
+
     //
     // Shader and pipeline types
     //
@@ -388,6 +418,9 @@ namespace vsgUnity.Native
         public int hasColors;
         public int uvChannelCount;
         public int useAlpha;
+        public int cullMode; // VkCullModeFlagBits
+        public int depthWrite;
+        public int depthCompareOp; // VkCompareOp
         public DescriptorSetLayoutBindingsArray descriptorBindings;
         public ShaderStagesData shaderStages;
 
@@ -398,6 +431,9 @@ namespace vsgUnity.Native
                 hasColors == b.hasColors &&
                 uvChannelCount == b.uvChannelCount &&
                 useAlpha == b.useAlpha &&
+                cullMode == b.cullMode &&
+                depthWrite == b.depthWrite &&
+                depthCompareOp == b.depthCompareOp &&
                 descriptorBindings.Equals(b.descriptorBindings) &&
                 shaderStages.Equals(b.shaderStages);
         }
@@ -410,6 +446,7 @@ namespace vsgUnity.Native
     public struct TransformData
     {
         public FloatArray matrix;
+        public int isStatic;
     }
 
     public struct CullData
@@ -433,6 +470,39 @@ namespace vsgUnity.Native
         public float farZ;
     }
 
+    //
+    // Export settings
+    //
+
+    public struct ExportSettingsData
+    {
+        public int virtualTextureMinSize; // textures with a width or height at or above this are exported as virtual textures, 0 disables
+        public int virtualTexturePageSize;
+        public int virtualTexturePageBorder;
+        public int precompileShaders; // compile shaders to spirv at export so they don't need compiling at load, 0 disables
+        public int shaderOptimization;
+        public int shaderStripDebugInfo;
+        public IntPtr shaderCacheDirectory; // directory compiled shaders are cached in between exports, null or empty disables
+        public int shaderCacheMaxSize; // megabytes, 0 is unbounded
+        public int specializeShaderFeatures; // shader feature toggles become specialization constants rather than defines
+        public int bindlessTextureCapacity; // 0 disables bindless materials
+        public int depthOnlyPipelines; // 0 disables
+        public int sortStateGroups; // 0 disables
+        public int flattenHierarchy; // 0 disables
+        public int bakeStaticTransforms; // 0 disables
+        public int cullHierarchyLeafSize; // 0 disables
+        public float tileSize; // 0 disables
+        public float tileScreenHeightRatio;
+        public float hlodClusterSize; // 0 disables
+        public float hlodScreenHeightRatio;
+        public int hlodProxyResolution;
+        public float pvsCellSize; // 0 disables
+        public int pvsResolution;
+        public int streamLeafData;
+        public int packLeafData;
+        public int compressionLevel; // 0 disables
+    }
+
     public static class NativeUtils
     {
         public static PipelineData CreatePipelineData(MeshInfo meshData)
@@ -444,9 +514,31 @@ namespace vsgUnity.Native
             pipeline.uvChannelCount = 0;
             pipeline.uvChannelCount += meshData.uv0.length > 0 ? 1 : 0;
             pipeline.uvChannelCount += meshData.uv1.length > 0 ? 1 : 0;
+            pipeline.cullMode = (int)VkCullModeFlagBits.VK_CULL_MODE_BACK_BIT;
+            pipeline.depthWrite = 1;
+            pipeline.depthCompareOp = (int)VkCompareOp.VK_COMPARE_OP_LESS_OR_EQUAL;
             return pipeline;
         }
 
+        public static void SetPipelineState(ref PipelineData pipeline, MaterialInfo material)
+        {
+            pipeline.useAlpha = material.useAlpha;
+            pipeline.cullMode = (int)material.cullMode;
+            pipeline.depthWrite = material.depthWrite;
+            pipeline.depthCompareOp = (int)material.depthCompareOp;
+        }
+
+        // materials sharing shaders can only share a pipeline if their rasterization and depth state match too
+        public static int GetPipelineKeyForMaterial(MaterialInfo material)
+        {
+            int key = material.shaderStages.id;
+            key = key * 31 + material.useAlpha;
+            key = key * 31 + (int)material.cullMode;
+            key = key * 31 + material.depthWrite;
+            key = key * 31 + (int)material.depthCompareOp;
+            return key;
+        }
+
         public static string GetIDForPipeline(PipelineData data)
         {
             string idstr = "";
@@ -455,6 +547,9 @@ namespace vsgUnity.Native
             idstr += data.hasColors == 1 ? "1" : "0";
             idstr += data.uvChannelCount.ToString();
             idstr += data.useAlpha == 1 ? "1" : "0";
+            idstr += data.cullMode.ToString();
+            idstr += data.depthWrite == 1 ? "1" : "0";
+            idstr += data.depthCompareOp.ToString();
             idstr += data.descriptorBindings.length.ToString(); // need better id for these
             idstr += data.shaderStages.id.ToString();
             return idstr;
@@ -551,12 +646,39 @@ namespace vsgUnity.Native
             return result;
         }
 
-        static List<IntPtr> _nativePointersCache = new List<IntPtr>();
+        // memory allocated to pass to the native side, freed once the native side lets go of it or the export ends
+        static HashSet<IntPtr> _nativePointersCache = new HashSet<IntPtr>();
+        static List<IntPtr> _nativeStringsCache = new List<IntPtr>();
+        static IntPtr[] _releasedPointers = new IntPtr[256];
+
+        // free the memory the native side has let go of during the export, pointers it reports that weren't allocated here are skipped
+        public static void FreeReleasedNativeData()
+        {
+            uint count;
+            do
+            {
+                count = GraphBuilderInterface.unity2vsg_TakeReleasedData(_releasedPointers, (uint)_releasedPointers.Length);
+                for (int i = 0; i < count; i++)
+                {
+                    if (_nativePointersCache.Remove(_releasedPointers[i])) Marshal.FreeCoTaskMem(_releasedPointers[i]);
+                }
+            }
+            while (count == _releasedPointers.Length);
+        }
+
+        // free all the memory passed to the native side, should only be called once the export has ended
+        public static void FreeNativePointers()
+        {
+            foreach (IntPtr ptr in _nativePointersCache) Marshal.FreeCoTaskMem(ptr);
+            foreach (IntPtr ptr in _nativeStringsCache) Marshal.FreeHGlobal(ptr);
+            _nativePointersCache.Clear();
+            _nativeStringsCache.Clear();
+        }
 
         public static IntPtr ToNative(string str)
         {
             IntPtr ptr = Marshal.StringToHGlobalAnsi(str);
-            _nativePointersCache.Add(ptr);
+            _nativeStringsCache.Add(ptr);
             return ptr;
         }
 
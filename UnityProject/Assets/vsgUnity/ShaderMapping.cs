@@ -108,6 +108,17 @@ namespace vsgUnity
 
         public List<string> vsgDefines = new List<string>(); // any custom defines in the vsg shader associated with the uniform
 
+        // channel packing, single channel texture maps sharing a packedBindingIndex are combined into one rgba texture
+        public int packedBindingIndex = -1; // the descriptor binding index of the packed texture in the vsg shader, -1 if the map is never packed
+        public int packedChannel = 0; // the channel of the packed texture the map is written to
+        public int sourceChannel = 0; // the channel of the unity texture the map is read from
+        public List<string> packedDefines = new List<string>(); // custom defines used instead of vsgDefines when the map is packed
+
+        public bool IsPackable()
+        {
+            return uniformType == UniformType.Texture2DUniform && packedBindingIndex >= 0;
+        }
+
         /// <summary>
         /// Get the data value from the passed material matching this uniform
         /// </summary>
@@ -234,6 +245,79 @@ namespace vsgUnity
         }
     }
 
+    /// <summary>
+    /// PipelineStateMapping
+    /// Map the unity material properties controlling culling and depth to vsg rasterization and depth stencil state,
+    /// the fixed values are used when a material doesn't have the property
+    /// </summary>
+
+    [Serializable]
+    public class PipelineStateMapping : ISerializationCallbackReceiver
+    {
+        public string cullModeProperty = "_Cull";
+        public string depthWriteProperty = "_ZWrite";
+        public string depthTestProperty = "_ZTest";
+
+        [NonSerialized]
+        public CullMode cullMode = CullMode.Back;
+
+        [SerializeField]
+        protected string cullModeString; // this is used for serialization so we can store enum as string in json
+
+        public bool depthWrite = true; // opaque materials only, transparent materials without the property don't write depth
+
+        [NonSerialized]
+        public CompareFunction depthTest = CompareFunction.LessEqual;
+
+        [SerializeField]
+        protected string depthTestString; // this is used for serialization so we can store enum as string in json
+
+        public VkCullModeFlagBits GetCullMode(Material material)
+        {
+            CullMode mode = cullMode;
+            if (material != null && !string.IsNullOrEmpty(cullModeProperty) && material.HasProperty(cullModeProperty)) mode = (CullMode)(int)material.GetFloat(cullModeProperty);
+
+            // unity's cull modes line up with vulkan's as the mesh winding is flipped on export
+            switch (mode)
+            {
+                case CullMode.Off: return VkCullModeFlagBits.VK_CULL_MODE_NONE;
+                case CullMode.Front: return VkCullModeFlagBits.VK_CULL_MODE_FRONT_BIT;
+                default: return VkCullModeFlagBits.VK_CULL_MODE_BACK_BIT;
+            }
+        }
+
+        public bool GetDepthWrite(Material material, bool transparent)
+        {
+            if (material != null && !string.IsNullOrEmpty(depthWriteProperty) && material.HasProperty(depthWriteProperty)) return material.GetFloat(depthWriteProperty) != 0.0f;
+            return depthWrite && !transparent;
+        }
+
+        public VkCompareOp GetDepthCompareOp(Material material)
+        {
+            CompareFunction func = depthTest;
+            if (material != null && !string.IsNullOrEmpty(depthTestProperty) && material.HasProperty(depthTestProperty)) func = (CompareFunction)(int)material.GetFloat(depthTestProperty);
+
+            // disabled has no vulkan equivalent, always passing the test keeps depth writes working the same
+            if (func <= CompareFunction.Disabled || func > CompareFunction.Always) return VkCompareOp.VK_COMPARE_OP_ALWAYS;
+            return (VkCompareOp)((int)func - 1);
+        }
+
+        //
+        // ISerializationCallbackReceiver implementations
+
+        public void OnBeforeSerialize()
+        {
+            cullModeString = cullMode.ToString();
+            depthTestString = depthTest.ToString();
+        }
+
+        public void OnAfterDeserialize()
+        {
+            if (!System.Enum.TryParse<CullMode>(cullModeString, out cullMode)) cullMode = CullMode.Back;
+            if (!System.Enum.TryParse<CompareFunction>(depthTestString, out depthTest)) depthTest = CompareFunction.LessEqual;
+        }
+    }
+
     /// <summary>
     /// ShaderMapping
     /// Map a unity shader to a vsg shader including its unifrom mappings, shader resources etc
@@ -250,6 +334,10 @@ namespace vsgUnity
 
         public List<UniformMapping> uniformMappings = new List<UniformMapping>(); // mappings of unity properties/uniforms to vsg descriptors/uniforms
 
+        public PipelineStateMapping pipelineState = new PipelineStateMapping(); // culling and depth state for materials using the shader
+
+        public int uniformBlockBinding = -1; // binding of the std140 uniform block the float, vector and color uniforms are packed into, -1 gives each its own buffer at its vsgBindingIndex
+
         public List<VertexAttributeDependancies> vertexDependancies = new List<VertexAttributeDependancies>(); // vertex inputs for this shader
 
         public VertexAttributeDependancies GetVertexDependanciesForAttributeType(VertexAttribute attributeType)
@@ -272,6 +360,56 @@ namespace vsgUnity
             return result.ToArray();
         }
 
+        // is the uniform packed into the uniform block rather than bound on its own
+        public bool IsBlockUniform(UniformMapping mapping)
+        {
+            if (uniformBlockBinding < 0) return false;
+            return mapping.uniformType == UniformMapping.UniformType.FloatUniform ||
+                mapping.uniformType == UniformMapping.UniformType.Vec4Uniform ||
+                mapping.uniformType == UniformMapping.UniformType.ColorUniform;
+        }
+
+        // std140 offset in floats of each uniform in the uniform block in uniformMappings order, -1 for uniforms outside the block.
+        // floats are 4 byte aligned and vectors 16, blockSize is the size in floats rounded up to a whole vec4
+        public int[] GetUniformBlockOffsets(out int blockSize)
+        {
+            int[] offsets = new int[uniformMappings.Count];
+            int offset = 0;
+            for (int i = 0; i < uniformMappings.Count; i++)
+            {
+                if (!IsBlockUniform(uniformMappings[i]))
+                {
+                    offsets[i] = -1;
+                    continue;
+                }
+
+                bool isFloat = uniformMappings[i].uniformType == UniformMapping.UniformType.FloatUniform;
+                if (!isFloat) offset = (offset + 3) / 4 * 4;
+                offsets[i] = offset;
+                offset += isFloat ? 1 : 4;
+            }
+            blockSize = (offset + 3) / 4 * 4;
+            return offsets;
+        }
+
+        // glsl declaration of the uniform block matching the layout from GetUniformBlockOffsets, members are named after the unity property without its leading underscore
+        public string GetUniformBlockDeclaration()
+        {
+            List<string> lines = new List<string>();
+            lines.Add("layout(set = 0, binding = " + uniformBlockBinding + ") uniform MaterialData");
+            lines.Add("{");
+            foreach (UniformMapping mapping in uniformMappings)
+            {
+                if (!IsBlockUniform(mapping)) continue;
+
+                string name = mapping.unityPropName.TrimStart('_');
+                if (name.Length > 0) name = char.ToLowerInvariant(name[0]) + name.Substring(1);
+                lines.Add("    " + (mapping.uniformType == UniformMapping.UniformType.FloatUniform ? "float " : "vec4 ") + name + "; // " + mapping.unityPropName);
+            }
+            lines.Add("} material;");
+            return string.Join("\n", lines.ToArray());
+        }
+
         public UniformMappedData[] GetUniformDatasFromMaterial(Material material)
         {
             // ensure the material and shader is valid
@@ -405,6 +543,7 @@ namespace vsgUnity
             ShaderMapping mapping = new ShaderMapping()
             {
                 unityShaderName = shader.name,
+                uniformBlockBinding = 0, // pack the float, vector and color properties into one block by default
                 shaders = new List<ShaderResource>()
                 {
                     new ShaderResource() { sourceFile = shader.name, stages = VkShaderStageFlagBits.VK_SHADER_STAGE_VERTEX_BIT | VkShaderStageFlagBits.VK_SHADER_STAGE_FRAGMENT_BIT }
@@ -470,6 +609,15 @@ namespace vsgUnity
             ShaderMapping mapping = CreateTemplateForShader(shader);
             string filePath = Path.Combine(Application.dataPath, GetFileNameForShaderMapping(shader.name) + "-Template.json");
             WriteToJsonFile(mapping, filePath);
+
+            // write the declaration of the uniform block the template packs its properties into so the vsg shader can match it
+            int blockSize;
+            mapping.GetUniformBlockOffsets(out blockSize);
+            if (blockSize > 0)
+            {
+                string blockPath = Path.Combine(Application.dataPath, GetFileNameForShaderMapping(shader.name) + "-Template.glsl");
+                File.WriteAllText(blockPath, mapping.GetUniformBlockDeclaration());
+            }
         }
     }
 }
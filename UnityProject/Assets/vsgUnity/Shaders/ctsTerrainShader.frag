@@ -7,20 +7,21 @@ layout(set = 0, binding = 1) uniform sampler2D splatMask1;
 layout(set = 0, binding = 2) uniform sampler2D splatMask2;
 
 
-layout(set = 0, binding = 3) uniform TextureIndex1 { float index; } diffuseTextureIndex1;
-layout(set = 0, binding = 4) uniform TextureIndex2 { float index; } diffuseTextureIndex2;
-layout(set = 0, binding = 5) uniform TextureIndex3 { float index; } diffuseTextureIndex3;
-layout(set = 0, binding = 6) uniform TextureIndex4 { float index; } diffuseTextureIndex4;
-layout(set = 0, binding = 7) uniform TextureIndex5 { float index; } diffuseTextureIndex5;
-layout(set = 0, binding = 8) uniform TextureIndex6 { float index; } diffuseTextureIndex6;
-
-
-layout(set = 0, binding = 9) uniform TextureScale1 { float scale; } diffuseTextureScale1;
-layout(set = 0, binding = 10) uniform TextureScale2 { float scale; } diffuseTextureScale2;
-layout(set = 0, binding = 11) uniform TextureScale3 { float scale; } diffuseTextureScale3;
-layout(set = 0, binding = 12) uniform TextureScale4 { float scale; } diffuseTextureScale4;
-layout(set = 0, binding = 13) uniform TextureScale5 { float scale; } diffuseTextureScale5;
-layout(set = 0, binding = 14) uniform TextureScale6 { float scale; } diffuseTextureScale6;
+layout(set = 0, binding = 3) uniform MaterialData
+{
+    float texture_1_Albedo_Index; // _Texture_1_Albedo_Index
+    float texture_2_Albedo_Index; // _Texture_2_Albedo_Index
+    float texture_3_Albedo_Index; // _Texture_3_Albedo_Index
+    float texture_4_Albedo_Index; // _Texture_4_Albedo_Index
+    float texture_5_Albedo_Index; // _Texture_5_Albedo_Index
+    float texture_6_Albedo_Index; // _Texture_6_Albedo_Index
+    float texture_1_Tiling; // _Texture_1_Tiling
+    float texture_2_Tiling; // _Texture_2_Tiling
+    float texture_3_Tiling; // _Texture_3_Tiling
+    float texture_4_Tiling; // _Texture_4_Tiling
+    float texture_5_Tiling; // _Texture_5_Tiling
+    float texture_6_Tiling; // _Texture_6_Tiling
+} material;
 
 
 #ifdef VSG_NORMAL
@@ -44,30 +45,30 @@ void main()
 	vec4 mask = texture(splatMask1, texCoord0.st);
 	
 	// tex 1
-	vec4 diffuse = texture(diffuseTextureArray[int(diffuseTextureIndex1.index)], (texCoord0.st) * diffuseTextureScale1.scale);
+	vec4 diffuse = texture(diffuseTextureArray[int(material.texture_1_Albedo_Index)], (texCoord0.st) * material.texture_1_Tiling);
 	base = mix(base, diffuse, mask[0]);
 	
 	// tex 2
-	diffuse = texture(diffuseTextureArray[int(diffuseTextureIndex2.index)], (texCoord0.st) * diffuseTextureScale2.scale);
+	diffuse = texture(diffuseTextureArray[int(material.texture_2_Albedo_Index)], (texCoord0.st) * material.texture_2_Tiling);
 	base = mix(base, diffuse, mask[1]);
 	
 	// tex 3
-	diffuse = texture(diffuseTextureArray[int(diffuseTextureIndex3.index)], (texCoord0.st) * diffuseTextureScale3.scale);
+	diffuse = texture(diffuseTextureArray[int(material.texture_3_Albedo_Index)], (texCoord0.st) * material.texture_3_Tiling);
 	base = mix(base, diffuse, mask[2]);
 	
 	// tex 4
-	diffuse = texture(diffuseTextureArray[int(diffuseTextureIndex4.index)], (texCoord0.st) * diffuseTextureScale4.scale);
+	diffuse = texture(diffuseTextureArray[int(material.texture_4_Albedo_Index)], (texCoord0.st) * material.texture_4_Tiling);
 	base = mix(base, diffuse, mask[3]);
 
 	// new mask
 	 mask = texture(splatMask2, texCoord0.st);
 
 	// tex 5
-	diffuse = texture(diffuseTextureArray[int(diffuseTextureIndex5.index)], (texCoord0.st) * diffuseTextureScale5.scale);
+	diffuse = texture(diffuseTextureArray[int(material.texture_5_Albedo_Index)], (texCoord0.st) * material.texture_5_Tiling);
 	base = mix(base, diffuse, mask[0]);
 	
 	// tex 6
-	diffuse = texture(diffuseTextureArray[int(diffuseTextureIndex6.index)], (texCoord0.st) * diffuseTextureScale6.scale);
+	diffuse = texture(diffuseTextureArray[int(material.texture_6_Albedo_Index)], (texCoord0.st) * material.texture_6_Tiling);
 	base = mix(base, diffuse, mask[1]);
 
 
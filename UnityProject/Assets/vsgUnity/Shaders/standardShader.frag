@@ -1,28 +1,78 @@
 #version 450
-#pragma import_defines ( VSG_NORMAL, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_ALBEDO_COLOR, VSG_DIFFUSE_MAP, VSG_OPACITY_MAP, VSG_AMBIENT_MAP, VSG_NORMAL_MAP, VSG_SPECULAR_MAP )
+#pragma import_defines ( VSG_NORMAL, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_ALBEDO_COLOR, VSG_DIFFUSE_MAP, VSG_OPACITY_MAP, VSG_AMBIENT_MAP, VSG_NORMAL_MAP, VSG_SPECULAR_MAP, VSG_PACKED_MAP, VSG_PACKED_AMBIENT, VSG_PACKED_SPECULAR, VSG_PACKED_OPACITY, VSG_SPECIALIZED, VSG_BINDLESS )
 #extension GL_ARB_separate_shader_objects : enable
-#ifdef VSG_DIFFUSE_MAP
+#ifdef VSG_SPECIALIZED
+// feature toggles are specialization constants so every combination of them shares one module, the exporter binds
+// a placeholder texture to any map a material doesn't have
+layout(constant_id = 100) const bool vsgLighting = false;
+layout(constant_id = 101) const bool vsgNormalMap = false;
+layout(constant_id = 102) const bool vsgDiffuseMap = false;
+layout(constant_id = 103) const bool vsgOpacityMap = false;
+#endif
+#ifdef VSG_BINDLESS
+// every texture and material record in the export, the push constant is the offset of this draw's record which holds the
+// texture index of bindings 0 to 15 followed by the material's uniform block. the array is sized by the exporter's texture
+// capacity, the index is uniform across a draw so only needs dynamic indexing of sampler arrays
+layout(constant_id = 110) const uint vsgBindlessTextureCapacity = 1;
+layout(set = 0, binding = 0) uniform sampler2D bindlessTextures[vsgBindlessTextureCapacity];
+layout(set = 0, binding = 1) readonly buffer BindlessMaterials
+{
+    uint values[];
+} bindlessMaterials;
+layout(push_constant) uniform BindlessMaterial
+{
+    layout(offset = 128) uint offset;
+} bindlessMaterial;
+
+#define BINDLESS_TEXTURE(binding) bindlessTextures[bindlessMaterials.values[bindlessMaterial.offset + binding]]
+#define BINDLESS_FLOAT(index) uintBitsToFloat(bindlessMaterials.values[bindlessMaterial.offset + 16 + index])
+
+#define diffuseMap BINDLESS_TEXTURE(0)
+#define opacityMap BINDLESS_TEXTURE(1)
+#define ambientMap BINDLESS_TEXTURE(4)
+#define normalMap BINDLESS_TEXTURE(5)
+#define specularMap BINDLESS_TEXTURE(6)
+#define packedMap BINDLESS_TEXTURE(7)
+
+struct MaterialData
+{
+    vec4 color; // _Color
+};
+
+MaterialData loadMaterial()
+{
+    return MaterialData(vec4(BINDLESS_FLOAT(0), BINDLESS_FLOAT(1), BINDLESS_FLOAT(2), BINDLESS_FLOAT(3)));
+}
+#define material loadMaterial()
+#else
+#if defined(VSG_DIFFUSE_MAP) || defined(VSG_SPECIALIZED)
 layout(binding = 0) uniform sampler2D diffuseMap;
 #endif
-#ifdef VSG_OPACITY_MAP
+#if defined(VSG_OPACITY_MAP) || defined(VSG_SPECIALIZED)
 layout(binding = 1) uniform sampler2D opacityMap;
 #endif
 #ifdef VSG_AMBIENT_MAP
 layout(binding = 4) uniform sampler2D ambientMap;
 #endif
-#ifdef VSG_NORMAL_MAP
+#if defined(VSG_NORMAL_MAP) || defined(VSG_SPECIALIZED)
 layout(binding = 5) uniform sampler2D normalMap;
 #endif
 #ifdef VSG_SPECULAR_MAP
 layout(binding = 6) uniform sampler2D specularMap;
 #endif
+#ifdef VSG_PACKED_MAP
+// single channel maps packed into one texture, r = ambient occlusion, g = specular, b = opacity
+layout(binding = 7) uniform sampler2D packedMap;
+#endif
 
 #ifdef VSG_ALBEDO_COLOR
-layout(binding = 10) uniform AlbedoData
+// the material's packed float, vector and color properties, see ShaderMapping.uniformBlockBinding
+layout(binding = 10) uniform MaterialData
 {
-    vec4 color;
-} albedo;
+    vec4 color; // _Color
+} material;
 #endif
+#endif // VSG_BINDLESS
 
 #ifdef VSG_NORMAL
 layout(location = 1) in vec3 normalDir;
@@ -33,7 +83,7 @@ layout(location = 3) in vec4 vertColor;
 #ifdef VSG_TEXCOORD0
 layout(location = 4) in vec2 texCoord0;
 #endif
-#ifdef VSG_LIGHTING
+#if defined(VSG_LIGHTING) || defined(VSG_SPECIALIZED)
 layout(location = 5) in vec3 viewDir;
 layout(location = 6) in vec3 lightDir;
 #endif
@@ -41,8 +91,12 @@ layout(location = 0) out vec4 outColor;
 
 void main()
 {
-#ifdef VSG_DIFFUSE_MAP
+#if defined(VSG_DIFFUSE_MAP) || (defined(VSG_SPECIALIZED) && defined(VSG_TEXCOORD0))
+#ifdef VSG_SPECIALIZED
+    vec4 base = vsgDiffuseMap ? texture(diffuseMap, texCoord0.st) : vec4(1.0,1.0,1.0,1.0);
+#else
     vec4 base = texture(diffuseMap, texCoord0.st);
+#endif
 #else
     vec4 base = vec4(1.0,1.0,1.0,1.0);
 #endif
@@ -51,7 +105,7 @@ void main()
 #endif
 #ifdef VSG_ALBEDO_COLOR
     vec3 ambientColor = vec3(0.1,0.1,0.1);
-    vec3 diffuseColor = albedo.color.rgb;
+    vec3 diffuseColor = material.color.rgb;
     vec3 specularColor = vec3(0.3,0.3,0.3);
     float shine = 16.0f;
 #else
@@ -60,40 +114,79 @@ void main()
     vec3 specularColor = vec3(0.3,0.3,0.3);
     float shine = 16.0;
 #endif
+#ifdef VSG_PACKED_MAP
+    vec4 packed = texture(packedMap, texCoord0.st);
+#endif
 #ifdef VSG_AMBIENT_MAP
     ambientColor *= texture(ambientMap, texCoord0.st).r;
+#elif defined(VSG_PACKED_AMBIENT)
+    ambientColor *= packed.r;
 #endif
 #ifdef VSG_SPECULAR_MAP
     specularColor = texture(specularMap, texCoord0.st).rrr;
+#elif defined(VSG_PACKED_SPECULAR)
+    specularColor = packed.ggg;
+#endif
+    vec4 color = base;
+#if defined(VSG_LIGHTING) || (defined(VSG_SPECIALIZED) && defined(VSG_NORMAL))
+#ifdef VSG_SPECIALIZED
+    if (vsgLighting)
 #endif
-#ifdef VSG_LIGHTING
-#ifdef VSG_NORMAL_MAP
-    vec3 nDir = texture(normalMap, texCoord0.st).xyz*2.0 - 1.0;
-    nDir.g = -nDir.g;
+    {
+#if defined(VSG_NORMAL_MAP) || (defined(VSG_SPECIALIZED) && defined(VSG_TEXCOORD0))
+#ifdef VSG_SPECIALIZED
+        vec3 nDir = normalDir;
+        if (vsgNormalMap)
+#else
+        vec3 nDir;
+#endif
+        {
+            nDir = texture(normalMap, texCoord0.st).xyz*2.0 - 1.0;
+            nDir.g = -nDir.g;
+        }
 #else
-    vec3 nDir = normalDir;
-#endif
-    vec3 nd = normalize(nDir);
-    vec3 ld = normalize(lightDir);
-    vec3 vd = normalize(viewDir);
-    vec4 color = vec4(0.01, 0.01, 0.01, 1.0);
-    color.rgb += ambientColor;
-    float diff = max(dot(ld, nd), 0.0);
-    color.rgb += diffuseColor * diff;
-    color *= base;
-    if (diff > 0.0)
+        vec3 nDir = normalDir;
+#endif
+        vec3 nd = normalize(nDir);
+        vec3 ld = normalize(lightDir);
+        vec3 vd = normalize(viewDir);
+        color = vec4(0.01, 0.01, 0.01, 1.0);
+        color.rgb += ambientColor;
+        float diff = max(dot(ld, nd), 0.0);
+        color.rgb += diffuseColor * diff;
+        color *= base;
+        if (diff > 0.0)
+        {
+            vec3 halfDir = normalize(ld + vd);
+            color.rgb += base.a * specularColor *
+                pow(max(dot(halfDir, nd), 0.0), shine);
+        }
+    }
+#endif
+#ifndef VSG_LIGHTING
+#if defined(VSG_SPECIALIZED) && defined(VSG_NORMAL)
+    if (!vsgLighting)
+#endif
     {
-        vec3 halfDir = normalize(ld + vd);
-        color.rgb += base.a * specularColor *
-            pow(max(dot(halfDir, nd), 0.0), shine);
+        color.rgb *= diffuseColor;
     }
-#else
-    vec4 color = base;
-    color.rgb *= diffuseColor;
 #endif
     outColor = color;
-#ifdef VSG_OPACITY_MAP
-    outColor.a *= texture(opacityMap, texCoord0.st).r;
+#if defined(VSG_OPACITY_MAP) || (defined(VSG_SPECIALIZED) && defined(VSG_TEXCOORD0))
+#ifdef VSG_SPECIALIZED
+    if (vsgOpacityMap)
+#endif
+    {
+        outColor.a *= texture(opacityMap, texCoord0.st).r;
+    }
+#endif
+#if defined(VSG_PACKED_OPACITY) && !defined(VSG_OPACITY_MAP)
+#ifdef VSG_SPECIALIZED
+    if (!vsgOpacityMap)
+#endif
+    {
+        outColor.a *= packed.b;
+    }
 #endif
 
     // crude version of AlphaFunc
@@ -1,6 +1,12 @@
 #version 450
-#pragma import_defines ( VSG_NORMAL, VSG_TANGENT, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_NORMAL_MAP, VSG_BILLBOARD )
+#pragma import_defines ( VSG_NORMAL, VSG_TANGENT, VSG_COLOR, VSG_TEXCOORD0, VSG_LIGHTING, VSG_NORMAL_MAP, VSG_BILLBOARD, VSG_SPECIALIZED )
 #extension GL_ARB_separate_shader_objects : enable
+#ifdef VSG_SPECIALIZED
+// feature toggles are specialization constants so every combination of them shares one module
+layout(constant_id = 100) const bool vsgLighting = false;
+layout(constant_id = 101) const bool vsgNormalMap = false;
+layout(constant_id = 104) const bool vsgBillboard = false;
+#endif
 layout(push_constant) uniform PushConstants {
     mat4 projection;
     mat4 modelView;
@@ -22,7 +28,7 @@ layout(location = 3) out vec4 vertColor;
 layout(location = 4) in vec2 osg_MultiTexCoord0;
 layout(location = 4) out vec2 texCoord0;
 #endif
-#ifdef VSG_LIGHTING
+#if defined(VSG_LIGHTING) || defined(VSG_SPECIALIZED)
 layout(location = 5) out vec3 viewDir;
 layout(location = 6) out vec3 lightDir;
 #endif
@@ -32,23 +38,28 @@ void main()
 {
     mat4 modelView = pc.modelView;
 
-#ifdef VSG_BILLBOARD
-    vec3 lookDir = vec3(-modelView[0][2], -modelView[1][2], -modelView[2][2]);
-
-    // rotate around local z axis
-    float l = length(lookDir.xy);
-    if (l>0.0)
+#if defined(VSG_BILLBOARD) || defined(VSG_SPECIALIZED)
+#ifdef VSG_SPECIALIZED
+    if (vsgBillboard)
+#endif
     {
-        float inv = 1.0/l;
-        float c = lookDir.y * inv;
-        float s = lookDir.x * inv;
+        vec3 lookDir = vec3(-modelView[0][2], -modelView[1][2], -modelView[2][2]);
 
-        mat4 rotation_z = mat4(c,   -s,  0.0, 0.0,
-                               s,   c,   0.0, 0.0,
-                               0.0, 0.0, 1.0, 0.0,
-                               0.0, 0.0, 0.0, 1.0);
+        // rotate around local z axis
+        float l = length(lookDir.xy);
+        if (l>0.0)
+        {
+            float inv = 1.0/l;
+            float c = lookDir.y * inv;
+            float s = lookDir.x * inv;
 
-        modelView = modelView * rotation_z;
+            mat4 rotation_z = mat4(c,   -s,  0.0, 0.0,
+                                   s,   c,   0.0, 0.0,
+                                   0.0, 0.0, 1.0, 0.0,
+                                   0.0, 0.0, 0.0, 1.0);
+
+            modelView = modelView * rotation_z;
+        }
     }
 #endif
 
@@ -61,29 +72,45 @@ void main()
     vec3 n = (modelView * vec4(osg_Normal, 0.0)).xyz;
     normalDir = n;
 #endif
-#ifdef VSG_LIGHTING
-    vec4 lpos = /*osg_LightSource.position*/ vec4(0.0, 0.25, 1.0, 0.0);
-#ifdef VSG_NORMAL_MAP
-    vec3 t = (modelView * vec4(osg_Tangent.xyz, 0.0)).xyz;
-    vec3 b = cross(n, t);
-    vec3 dir = -vec3(modelView * vec4(osg_Vertex, 1.0));
-    viewDir.x = dot(dir, t);
-    viewDir.y = dot(dir, b);
-    viewDir.z = dot(dir, n);
-    if (lpos.w == 0.0)
-        dir = lpos.xyz;
-    else
-        dir += lpos.xyz;
-    lightDir.x = dot(dir, t);
-    lightDir.y = dot(dir, b);
-    lightDir.z = dot(dir, n);
-#else
-    viewDir = -vec3(modelView * vec4(osg_Vertex, 1.0));
-    if (lpos.w == 0.0)
-        lightDir = lpos.xyz;
-    else
-        lightDir = lpos.xyz + viewDir;
+#if defined(VSG_LIGHTING) || (defined(VSG_SPECIALIZED) && defined(VSG_NORMAL))
+#ifdef VSG_SPECIALIZED
+    if (vsgLighting)
+#endif
+    {
+        vec4 lpos = /*osg_LightSource.position*/ vec4(0.0, 0.25, 1.0, 0.0);
+#if defined(VSG_NORMAL_MAP) || (defined(VSG_SPECIALIZED) && defined(VSG_TANGENT))
+#ifdef VSG_SPECIALIZED
+        if (vsgNormalMap)
+#endif
+        {
+            vec3 t = (modelView * vec4(osg_Tangent.xyz, 0.0)).xyz;
+            vec3 b = cross(n, t);
+            vec3 dir = -vec3(modelView * vec4(osg_Vertex, 1.0));
+            viewDir.x = dot(dir, t);
+            viewDir.y = dot(dir, b);
+            viewDir.z = dot(dir, n);
+            if (lpos.w == 0.0)
+                dir = lpos.xyz;
+            else
+                dir += lpos.xyz;
+            lightDir.x = dot(dir, t);
+            lightDir.y = dot(dir, b);
+            lightDir.z = dot(dir, n);
+        }
+#endif
+#ifndef VSG_NORMAL_MAP
+#if defined(VSG_SPECIALIZED) && defined(VSG_TANGENT)
+        if (!vsgNormalMap)
 #endif
+        {
+            viewDir = -vec3(modelView * vec4(osg_Vertex, 1.0));
+            if (lpos.w == 0.0)
+                lightDir = lpos.xyz;
+            else
+                lightDir = lpos.xyz + viewDir;
+        }
+#endif
+    }
 #endif
 #ifdef VSG_COLOR
     vertColor = osg_Color;
@@ -14,6 +14,7 @@ using System;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
 using UnityEngine;
+using UnityEngine.Experimental.Rendering;
 using UnityEngine.Rendering;
 
 using vsgUnity.Native;
@@ -28,17 +29,137 @@ namespace vsgUnity
     public static class TextureConverter
     {
         public static Dictionary<int, ImageData> _imageDataCache = new Dictionary<int, ImageData>();
-        public static List<Texture2D> _convertedTextures = new List<Texture2D>();
+        public static Dictionary<string, ImageData> _packedImageDataCache = new Dictionary<string, ImageData>();
+        public static List<Texture2D> _packedTextures = new List<Texture2D>();
 
         public static void ClearCaches()
         {
             _imageDataCache.Clear();
+            _packedImageDataCache.Clear();
 
-            foreach(Texture2D tex in _convertedTextures)
+            foreach (Texture2D tex in _packedTextures)
             {
                 Texture2D.DestroyImmediate(tex);
             }
-            _convertedTextures.Clear();
+            _packedTextures.Clear();
+        }
+
+        /// <summary>
+        /// A single channel of a texture to be written into a channel of a packed texture
+        /// </summary>
+
+        public struct PackedChannelSource
+        {
+            public Texture2D texture;
+            public int sourceChannel;
+            public int packedChannel;
+        }
+
+        /// <summary>
+        /// Either create a new ImageData packing the passed channels into a single rgba texture or if these
+        /// channels have already been packed return the ImageData from the cache
+        /// </summary>
+        /// <param name="sources"></param>
+        /// <returns>ImageData representing the packed texture</returns>
+
+        public static ImageData GetOrCreatePackedImageData(PackedChannelSource[] sources)
+        {
+            string key = string.Empty;
+            foreach (PackedChannelSource source in sources)
+            {
+                key += source.texture.GetInstanceID() + ":" + source.sourceChannel + ">" + source.packedChannel + ",";
+            }
+
+            if (_packedImageDataCache.ContainsKey(key))
+            {
+                return _packedImageDataCache[key];
+            }
+
+            // the packed texture takes the size of the largest source, smaller sources are resampled
+            int width = 1, height = 1;
+            foreach (PackedChannelSource source in sources)
+            {
+                width = Mathf.Max(width, source.texture.width);
+                height = Mathf.Max(height, source.texture.height);
+            }
+
+            Color32[] pixels = new Color32[width * height];
+            for (int i = 0; i < pixels.Length; i++) pixels[i] = new Color32(255, 255, 255, 255);
+
+            foreach (PackedChannelSource source in sources)
+            {
+                // read each source once and resample from the copy rather than sampling the texture per texel
+                Color32[] sourcePixels = source.texture.GetPixels32();
+                int sourceWidth = source.texture.width;
+                int sourceHeight = source.texture.height;
+                if (sourceWidth == width && sourceHeight == height)
+                {
+                    for (int i = 0; i < pixels.Length; i++)
+                    {
+                        pixels[i][source.packedChannel] = sourcePixels[i][source.sourceChannel];
+                    }
+                }
+                else
+                {
+                    int[] x0 = new int[width], x1 = new int[width];
+                    float[] fx = new float[width];
+                    for (int x = 0; x < width; x++)
+                    {
+                        GetBilinearTaps(x, width, sourceWidth, out x0[x], out x1[x], out fx[x]);
+                    }
+
+                    for (int y = 0; y < height; y++)
+                    {
+                        int y0, y1;
+                        float fy;
+                        GetBilinearTaps(y, height, sourceHeight, out y0, out y1, out fy);
+                        int row0 = y0 * sourceWidth, row1 = y1 * sourceWidth;
+                        for (int x = 0; x < width; x++)
+                        {
+                            float top = Mathf.Lerp(sourcePixels[row0 + x0[x]][source.sourceChannel], sourcePixels[row0 + x1[x]][source.sourceChannel], fx[x]);
+                            float bottom = Mathf.Lerp(sourcePixels[row1 + x0[x]][source.sourceChannel], sourcePixels[row1 + x1[x]][source.sourceChannel], fx[x]);
+                            pixels[y * width + x][source.packedChannel] = (byte)(Mathf.Lerp(top, bottom, fy) + 0.5f);
+                        }
+                    }
+                }
+            }
+
+            // the packed texture can only have one sampler, so warn if the sources disagree
+            foreach (PackedChannelSource source in sources)
+            {
+                if (source.texture.wrapMode != sources[0].texture.wrapMode || source.texture.filterMode != sources[0].texture.filterMode)
+                {
+                    NativeLog.WriteLine("TextureConverter: Packed texture sources '" + sources[0].texture.name + "' and '" + source.texture.name + "' have different wrap or filter modes, the packed texture uses those of '" + sources[0].texture.name + "'.");
+                }
+            }
+
+            // packed maps hold data rather than colors so are always linear
+            Texture2D packed = new Texture2D(width, height, TextureFormat.RGBA32, true, true);
+            packed.name = "Packed(" + key + ")";
+            packed.wrapMode = sources[0].texture.wrapMode;
+            packed.filterMode = sources[0].texture.filterMode;
+            packed.anisoLevel = sources[0].texture.anisoLevel;
+            packed.SetPixels32(pixels);
+            packed.Apply(true, false);
+            _packedTextures.Add(packed);
+
+            ImageData texdata = CreateImageData(packed, false);
+            _packedImageDataCache[key] = texdata;
+
+            return texdata;
+        }
+
+        /// <summary>
+        /// Get the two source texels and blend weight to bilinear sample texel 'index' of a row or column of
+        /// length 'size' from one of length 'sourceSize', clamping at the edges
+        /// </summary>
+
+        private static void GetBilinearTaps(int index, int size, int sourceSize, out int tap0, out int tap1, out float weight)
+        {
+            float coord = Mathf.Clamp((index + 0.5f) * sourceSize / size - 0.5f, 0.0f, sourceSize - 1);
+            tap0 = (int)coord;
+            tap1 = Mathf.Min(tap0 + 1, sourceSize - 1);
+            weight = coord - tap0;
         }
 
         /// <summary>
@@ -71,24 +192,7 @@ namespace vsgUnity
 
             TextureSupportIssues issues = GetSupportIssuesForTexture(texture);
 
-            if ((issues & TextureSupportIssues.Format) == TextureSupportIssues.Format && texture.dimension == TextureDimension.Tex2D)
-            {
-                Texture2D source = texture as Texture2D;
-                RenderTexture rt = RenderTexture.GetTemporary(source.width, source.height, 0, RenderTextureFormat.ARGB32);
-                Graphics.Blit(source, rt);
-                Texture2D converted = new Texture2D(rt.width, rt.height, TextureFormat.RGBA32, false);
-                Graphics.SetRenderTarget(rt);
-                converted.ReadPixels(new Rect(0.0f, 0.0f, rt.width, rt.height), 0, 0, false);
-                converted.Apply(false, false);
-                RenderTexture.ReleaseTemporary(rt);
-                _convertedTextures.Add(converted);
-
-                texdata = TextureConverter.CreateImageData(converted, false);
-                TextureConverter.AddImageDataToCache(texdata, source.GetInstanceID());
-
-                return texdata;
-            }
-            else if (issues != TextureSupportIssues.None)
+            if (issues != TextureSupportIssues.None)
             {
                 texdata = CreateImageData(Texture2D.whiteTexture);
                 NativeLog.WriteLine(GetTextureSupportReport(issues, texture));
@@ -213,6 +317,7 @@ namespace vsgUnity
             if (!PopulateImageData(texture as Texture, ref texdata)) return false;
             texdata.depth = 1;
             texdata.format = VkFormat.R8G8B8A8_UNORM;
+            texdata.sourceFormat = ImageSourceFormat.Native;
             texdata.pixels = NativeUtils.ToNative(Color32ArrayToByteArray(texture.GetPixels32(index, 0)));
             texdata.mipmapCount = 1;
             return true;
@@ -228,7 +333,7 @@ namespace vsgUnity
         public static bool PopulateImageData(Texture texture, ref ImageData texdata)
         {
             texdata.id = texture.GetInstanceID();
-            texdata.format = Vulkan.vkFormatForGraphicsFormat(texture.graphicsFormat);
+            texdata.sourceFormat = GetSourceFormatForTexture(texture, out texdata.format);
             texdata.width = texture.width;
             texdata.height = texture.height;
             texdata.anisoLevel = texture.anisoLevel;
@@ -240,6 +345,51 @@ namespace vsgUnity
             return true;
         }
 
+        /// <summary>
+        /// Returns the layout of the textures raw data if it needs converting by the exporter before it can be used by vulkan,
+        /// format is set to the vulkan format the raw data will be in once converted (or is already in if no conversion is needed)
+        /// </summary>
+        /// <param name="texture"></param>
+        /// <param name="format"></param>
+        /// <returns></returns>
+
+        public static ImageSourceFormat GetSourceFormatForTexture(Texture texture, out VkFormat format)
+        {
+            GraphicsFormat graphicsFormat = texture.graphicsFormat;
+            bool srgb = GraphicsFormatUtility.IsSRGBFormat(graphicsFormat);
+            VkFormat rgba8 = srgb ? VkFormat.R8G8B8A8_SRGB : VkFormat.R8G8B8A8_UNORM;
+
+            // some texture formats report a graphics format that doesn't match the byte order of their raw data
+            Texture2D texture2D = texture as Texture2D;
+            if (texture2D != null)
+            {
+                switch (texture2D.format)
+                {
+                    case TextureFormat.RGB24: format = rgba8; return ImageSourceFormat.R8G8B8;
+                    case TextureFormat.ARGB32: format = rgba8; return ImageSourceFormat.A8R8G8B8;
+                    case TextureFormat.BGRA32: format = rgba8; return ImageSourceFormat.B8G8R8A8;
+                    case TextureFormat.Alpha8: format = VkFormat.R8G8B8A8_UNORM; return ImageSourceFormat.A8;
+                    case TextureFormat.RGB565: format = VkFormat.R8G8B8A8_UNORM; return ImageSourceFormat.R5G6B5_Pack16;
+                    default: break;
+                }
+            }
+
+            switch (graphicsFormat)
+            {
+                case GraphicsFormat.R8G8B8_UNorm:
+                case GraphicsFormat.R8G8B8_SRGB: format = rgba8; return ImageSourceFormat.R8G8B8;
+                case GraphicsFormat.B8G8R8_UNorm:
+                case GraphicsFormat.B8G8R8_SRGB: format = rgba8; return ImageSourceFormat.B8G8R8;
+                case GraphicsFormat.R5G6B5_UNormPack16: format = VkFormat.R8G8B8A8_UNORM; return ImageSourceFormat.R5G6B5_Pack16;
+                case GraphicsFormat.R16G16B16_SFloat: format = VkFormat.R16G16B16A16_SFLOAT; return ImageSourceFormat.R16G16B16_SFloat;
+                case GraphicsFormat.R32G32B32_SFloat: format = VkFormat.R32G32B32A32_SFLOAT; return ImageSourceFormat.R32G32B32_SFloat;
+                default: break;
+            }
+
+            format = Vulkan.vkFormatForGraphicsFormat(graphicsFormat);
+            return ImageSourceFormat.Native;
+        }
+
         private static byte[] Color32ArrayToByteArray(Color32[] colors)
         {
             if (colors == null || colors.Length == 0)
@@ -284,7 +434,8 @@ namespace vsgUnity
 
             if (!texture.isReadable) issues |= TextureSupportIssues.ReadWrite;
 
-            VkFormat format = Vulkan.vkFormatForGraphicsFormat(texture.graphicsFormat);
+            VkFormat format;
+            GetSourceFormatForTexture(texture, out format);
             if (format == VkFormat.UNDEFINED) issues |= TextureSupportIssues.Format;
 
             if (texture.dimension != TextureDimension.Tex2D && texture.dimension != TextureDimension.Tex2DArray) issues |= TextureSupportIssues.Dimensions; //&& texture.dimension != TextureDimension.Tex3D
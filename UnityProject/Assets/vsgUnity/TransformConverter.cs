@@ -32,6 +32,7 @@ namespace vsgUnity
                 matrix[3, 0], matrix[3, 1], matrix[3, 2], matrix[3, 3]
             };
             transformdata.matrix.length = transformdata.matrix.data.Length;
+            transformdata.isStatic = transform.gameObject.isStatic ? 1 : 0;
             return transformdata;
         }
 
@@ -94,6 +94,29 @@ namespace vsgUnity
         VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM = 0x7FFFFFFF
     }
 
+    [System.Flags]
+    public enum VkCullModeFlagBits
+    {
+        VK_CULL_MODE_NONE = 0,
+        VK_CULL_MODE_FRONT_BIT = 0x00000001,
+        VK_CULL_MODE_BACK_BIT = 0x00000002,
+        VK_CULL_MODE_FRONT_AND_BACK = 0x00000003,
+        VK_CULL_MODE_FLAG_BITS_MAX_ENUM = 0x7FFFFFFF
+    }
+
+    public enum VkCompareOp
+    {
+        VK_COMPARE_OP_NEVER = 0,
+        VK_COMPARE_OP_LESS = 1,
+        VK_COMPARE_OP_EQUAL = 2,
+        VK_COMPARE_OP_LESS_OR_EQUAL = 3,
+        VK_COMPARE_OP_GREATER = 4,
+        VK_COMPARE_OP_NOT_EQUAL = 5,
+        VK_COMPARE_OP_GREATER_OR_EQUAL = 6,
+        VK_COMPARE_OP_ALWAYS = 7,
+        VK_COMPARE_OP_MAX_ENUM = 0x7FFFFFFF
+    }
+
     public enum VkFormat
     {
         UNDEFINED = 0,
@@ -0,0 +1,69 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <cstdint>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace unity2vsg
+{
+    // Compressed container for exported files. The file is cut into fixed size chunks, each compressed independently in the lz4
+    // block format, with an index of the chunks so they're compressed and decompressed in parallel.
+
+    struct CompressionStats
+    {
+        uint32_t chunks = 0;
+        uint64_t uncompressedSize = 0;
+        uint64_t compressedSize = 0;
+    };
+
+    // replace fileName with the compressed container of its contents. level 1 is the fastest, higher levels up to 9 search further
+    // for matches and compress smaller
+    extern bool compressFile(const std::string& fileName, int level, CompressionStats& stats);
+
+    // decompress the container fileName into contents, false if fileName isn't a container or couldn't be decompressed
+    extern bool decompressFile(const std::string& fileName, std::string& contents);
+
+    // a single lz4 block, compressBlock appends to dst
+    extern void compressBlock(const uint8_t* src, size_t srcSize, int level, std::vector<uint8_t>& dst);
+    extern bool decompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+    // reads a buffer in place, decompressed contents are read through a stream without the copy an istringstream would make
+    class MemoryStreamBuffer : public std::streambuf
+    {
+    public:
+        MemoryStreamBuffer(char* data, size_t size)
+        {
+            setg(data, data, data + size);
+        }
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+        {
+            if ((which & std::ios_base::in) == 0) return pos_type(off_type(-1));
+
+            char* base = dir == std::ios_base::beg ? eback() : (dir == std::ios_base::cur ? gptr() : egptr());
+            if (off < eback() - base || off > egptr() - base) return pos_type(off_type(-1));
+
+            setg(eback(), base + off, egptr());
+            return pos_type(off_type(gptr() - eback()));
+        }
+
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+        {
+            return seekoff(off_type(pos), std::ios_base::beg, which);
+        }
+    };
+} // namespace unity2vsg
@@ -0,0 +1,33 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <set>
+
+namespace unity2vsg
+{
+    struct CullHierarchyStats
+    {
+        uint32_t groupsPartitioned = 0;
+        uint32_t cullGroupsAdded = 0;
+        uint32_t maxDepth = 0;
+    };
+
+    // replace the children of groups holding more than leafSize of them with a bounding volume hierarchy of cullgroups split by the
+    // surface area heuristic, so culling them visits a logarithmic number of nodes. children drawing with blended pipelines or whose
+    // bounds can't be computed keep their place and order after the hierarchy
+    extern void buildCullHierarchy(vsg::Node* root, uint32_t leafSize, const std::set<vsg::GraphicsPipeline*>& blendedPipelines, CullHierarchyStats& stats);
+} // namespace unity2vsg
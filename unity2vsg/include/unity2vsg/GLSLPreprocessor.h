@@ -0,0 +1,31 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace unity2vsg
+{
+    // reads the source of an included file, returns false if it can't be read
+    typedef std::function<bool(const std::string& filename, std::string& source)> GLSLIncludeReader;
+
+    // single pass over source that moves #version and #pragma import_defines lines to the top, adding a #define for each imported
+    // define found in defines, and inlines #include files resolved relative to filename using includeReader
+    extern std::string preprocessGLSLSource(std::string_view source, const std::vector<std::string>& defines, const std::string& filename = std::string(), const GLSLIncludeReader& includeReader = GLSLIncludeReader());
+
+    // every define named by a #pragma import_defines in source or its includes, in the order they first appear
+    extern std::vector<std::string> importedGLSLDefines(std::string_view source, const std::string& filename = std::string(), const GLSLIncludeReader& includeReader = GLSLIncludeReader());
+} // namespace unity2vsg
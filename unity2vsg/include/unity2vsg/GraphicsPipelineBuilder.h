@@ -41,12 +41,21 @@ namespace vsg
 
             std::vector<DescriptorBindingSet> descriptorLayouts;
 
+            PushConstantRanges pushConstantRanges{
+                {VK_SHADER_STAGE_VERTEX_BIT, 0, 128} // projection view, and model matrices
+            };
+
             ColorBlendState::ColorBlendAttachments colorBlendAttachments;
             VkPrimitiveTopology primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+            VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+            bool depthWrite = true;
+            VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
         };
 
         GraphicsPipelineBuilder();
 
+        // build a pipeline from traits, layouts, states and pipelines equivalent to ones this builder has already built are reused
         virtual void build(ref_ptr<Traits> traits);
 
         ref_ptr<GraphicsPipeline> getGraphicsPipeline() const { return _graphicsPipeline; }
@@ -55,7 +64,15 @@ namespace vsg
         static size_t sizeOf(const Traits::StructInputAttributeDescription& structDescription);
 
     protected:
+        ref_ptr<GraphicsPipelineState> getOrCreateState(const std::string& key, const std::function<ref_ptr<GraphicsPipelineState>()>& create);
+
         ref_ptr<GraphicsPipeline> _graphicsPipeline;
+
+        // objects built so far keyed on their settings
+        std::map<std::string, ref_ptr<DescriptorSetLayout>> _descriptorSetLayouts;
+        std::map<std::string, ref_ptr<PipelineLayout>> _pipelineLayouts;
+        std::map<std::string, ref_ptr<GraphicsPipelineState>> _pipelineStates;
+        std::map<std::string, ref_ptr<GraphicsPipeline>> _graphicsPipelines;
     };
     VSG_type_name(vsg::GraphicsPipelineBuilder)
 } // namespace vsg
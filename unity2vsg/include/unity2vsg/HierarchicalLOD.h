@@ -0,0 +1,46 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+
+namespace unity2vsg
+{
+    struct HLODInputs
+    {
+        const std::set<vsg::Node*>* staticTransforms = nullptr; // transforms of objects marked static, only draws below these are clustered
+        std::set<vsg::GraphicsPipeline*> blendedPipelines; // draws with these keep their place
+        std::map<vsg::Object*, vsg::vec4> materialColors; // state commands binding a material mapped to the color its proxy is drawn with
+
+        // create the stategroup proxies are drawn under from their atlas, which holds a texel per material in the proxy
+        std::function<vsg::ref_ptr<vsg::StateGroup>(vsg::ref_ptr<vsg::Data> atlas)> createProxyState;
+    };
+
+    struct HLODStats
+    {
+        uint32_t clusters = 0;
+        uint64_t sourceTriangles = 0;
+        uint64_t proxyTriangles = 0;
+    };
+
+    // cluster the static draws under root into cells of clusterSize and put each cluster under a lod, which draws the cluster itself
+    // while its bound covers at least minimumScreenHeightRatio of the screen and a single simplified proxy mesh beyond that. proxies
+    // are simplified by merging the vertices of each material within a grid of proxyResolution cells across the cluster
+    extern void buildHierarchicalLODs(vsg::Group* root, double clusterSize, double minimumScreenHeightRatio, uint32_t proxyResolution, const HLODInputs& inputs,
+                                      HLODStats& stats);
+} // namespace unity2vsg
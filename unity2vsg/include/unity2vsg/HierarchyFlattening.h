@@ -0,0 +1,46 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <set>
+
+namespace unity2vsg
+{
+    struct FlattenStats
+    {
+        uint32_t groupsRemoved = 0;
+        uint32_t transformsRemoved = 0; // identity transforms, including the baked ones
+        uint32_t transformsMerged = 0;
+        uint32_t transformsBaked = 0;
+    };
+
+    struct FlattenInputs
+    {
+        std::set<vsg::Node*> staticTransforms; // transforms of objects marked static
+        std::set<vsg::Data*> normalArrays; // vec3 vertex arrays holding normals rather than positions
+        std::set<vsg::Data*> tangentArrays; // vec4 vertex arrays holding tangents with the handedness in w
+        std::set<vsg::GraphicsPipeline*> unbakeablePipelines; // pipelines whose shaders depend on the model matrix, like billboards
+    };
+
+    // collapse plain groups into their parent and transforms that are identity or chained into one. nodes carrying objects or values
+    // are kept as they are. only static identity transforms are removed and transforms are only chained with ones of the same static
+    // status, staticTransforms has the transforms removed taken out of it
+    extern void flattenHierarchy(vsg::Node* root, std::set<vsg::Node*>& staticTransforms, FlattenStats& stats);
+
+    // bake static transforms whose subgraph holds only static transforms into copies of the vertex data below them, leaving the
+    // transforms identity for flattenHierarchy to remove
+    extern void bakeStaticTransforms(vsg::Node* root, const FlattenInputs& inputs, FlattenStats& stats);
+} // namespace unity2vsg
@@ -0,0 +1,115 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace unity2vsg
+{
+    // Streams the leaf data of a scene (vertex, index and image arrays) out to a file beside the scene as subtrees are closed,
+    // so an export only holds the data of the subtree being built. Each array is written once, in the order it's first reached,
+    // and swapped in the graph for an empty placeholder of the same type and layout. The scene file references the placeholders,
+    // which MappedLeafData points at a mapping of the file on load, or readStreamedLeafData fills with copies.
+    //
+    // Arrays are aligned in the file so a mapping of it can be used in place, arrays of a page or more start on a page boundary.
+
+    // an array in a leaf file, offset is where its values start from the start of the file
+    struct LeafArrayEntry
+    {
+        uint64_t offset = 0;
+        uint64_t byteSize = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 0;
+        uint32_t valueSize = 0;
+    };
+
+    class LeafStreamWriter : public vsg::Object
+    {
+    public:
+        // original arrays and the placeholders that replaced them
+        using Replacements = std::vector<std::pair<vsg::ref_ptr<vsg::Data>, vsg::ref_ptr<vsg::Data>>>;
+
+        // opens a temporary file to stream to, the scene's file name isn't known until the export ends
+        LeafStreamWriter();
+
+        bool valid() const { return _file.good(); }
+
+        // write the arrays of the subgraph not yet written, replacing them with placeholders. subgraphs that were streamed before
+        // aren't revisited. keepGeometry leaves vertex positions and indices in place for passes that still need to read them
+        Replacements stream(vsg::Node* node, bool keepGeometry);
+
+        // write every array left in the scene, then the index and move the file to leafFileName(sceneFileName). the placeholders
+        // are attached to root as the "leaves" objects in the order they were written
+        Replacements finish(vsg::Object* root, const std::string& sceneFileName);
+
+        uint64_t arraysWritten() const { return _placeholders.size(); }
+        uint64_t bytesPadded() const { return _bytesPadded; }
+        uint64_t bytesWritten() const { return _bytesWritten; }
+
+        static std::string leafFileName(const std::string& sceneFileName);
+
+    protected:
+        virtual ~LeafStreamWriter();
+
+        class Streamer;
+
+        // the placeholder of original, writing original first if it hasn't been. null if the type of array isn't known
+        vsg::ref_ptr<vsg::Data> replace(vsg::ref_ptr<vsg::Data> original, Replacements& replacements);
+
+        std::string _fileName;
+        std::ofstream _file;
+        uint64_t _bytesWritten = 0;
+        uint64_t _bytesPadded = 0;
+        std::vector<LeafArrayEntry> _entries;
+        std::vector<vsg::ref_ptr<vsg::Data>> _placeholders;
+
+        // originals written and still referenced somewhere in the graph, so every reference is swapped for the same placeholder
+        std::map<vsg::Data*, std::pair<vsg::ref_ptr<vsg::Data>, vsg::ref_ptr<vsg::Data>>> _written;
+        std::set<vsg::Data*> _placeholderSet;
+        std::set<vsg::Node*> _streamedNodes;
+    };
+
+    // fill the placeholders of a scene exported with its leaf data streamed out, returns false if the scene has placeholders
+    // that couldn't be read. scenes without streamed leaf data are left as they are
+    extern bool readStreamedLeafData(vsg::Object* scene, const std::string& sceneFileName);
+
+    // maps the leaf file of a scene and points its placeholders at their values in the mapping without copying them, placeholders
+    // that can't be mapped are filled with copies. the placeholders let go of the values when this is destroyed, so it has to be
+    // destroyed before the scene
+    class MappedLeafData : public vsg::Object
+    {
+    public:
+        MappedLeafData(vsg::Object* scene, const std::string& sceneFileName);
+
+        // false if the scene has no placeholders or the file couldn't be mapped
+        bool valid() const { return _mapping != nullptr; }
+
+    protected:
+        virtual ~MappedLeafData();
+
+        void unmap();
+
+        uint8_t* _mapping = nullptr;
+        uint64_t _size = 0;
+        std::vector<vsg::ref_ptr<vsg::Data>> _arrays;
+    };
+} // namespace unity2vsg
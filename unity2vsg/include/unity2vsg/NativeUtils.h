@@ -128,11 +128,26 @@ namespace unity2vsg
     // Image types
     //
 
+    // layout of the raw pixel bytes when they can't be uploaded as format directly and have to be converted first
+    enum ImageSourceFormat
+    {
+        IMAGE_SOURCE_FORMAT_NATIVE = 0, // pixels are already in format
+        IMAGE_SOURCE_FORMAT_R8G8B8, // RGB24
+        IMAGE_SOURCE_FORMAT_B8G8R8,
+        IMAGE_SOURCE_FORMAT_A8R8G8B8, // ARGB32
+        IMAGE_SOURCE_FORMAT_B8G8R8A8, // BGRA32
+        IMAGE_SOURCE_FORMAT_A8, // Alpha8
+        IMAGE_SOURCE_FORMAT_R5G6B5_PACK16, // RGB565
+        IMAGE_SOURCE_FORMAT_R16G16B16_SFLOAT,
+        IMAGE_SOURCE_FORMAT_R32G32B32_SFLOAT
+    };
+
     struct ImageData
     {
         int id;
         ByteArray pixels;
         VkFormat format;
+        ImageSourceFormat sourceFormat;
         int width;
         int height;
         int depth;
@@ -184,6 +199,14 @@ namespace unity2vsg
         Vec4Array value;
     };
 
+    // a material's float, vector and color uniforms packed into one std140 block
+    struct DescriptorUniformBlockData
+    {
+        int id;
+        int binding;
+        FloatArray value;
+    };
+
     struct DescriptorImagesData
     {
         const char* id;
@@ -218,6 +241,9 @@ namespace unity2vsg
         int hasColors;
         int uvChannelCount;
         int useAlpha;
+        int cullMode; // VkCullModeFlags
+        int depthWrite;
+        int depthCompareOp; // VkCompareOp
         DescriptorSetLayoutBindingsArray descriptorBindings;
         ShaderStagesData shaderStages;
     };
@@ -230,6 +256,7 @@ namespace unity2vsg
     struct TransformData
     {
         FloatArray matrix;
+        int isStatic; // the object is marked static so its transform can be baked into its vertex data
     };
 
     struct CullData
@@ -253,6 +280,39 @@ namespace unity2vsg
         float farZ;
     };
 
+    //
+    // Export settings
+    //
+
+    struct ExportSettingsData
+    {
+        int virtualTextureMinSize; // textures with a width or height at or above this are exported as virtual textures, 0 disables
+        int virtualTexturePageSize; // size in texels of a virtual texture page excluding its border
+        int virtualTexturePageBorder; // texels of border duplicated around each page for filtering
+        int precompileShaders; // compile shaders to spirv at export so they don't need compiling at load, 0 disables
+        int shaderOptimization; // ShaderOptimization level used when precompiling
+        int shaderStripDebugInfo; // strip names and line info from precompiled shaders
+        const char* shaderCacheDirectory; // directory compiled shaders are cached in between exports, null or empty disables
+        int shaderCacheMaxSize; // size in megabytes the shader cache is trimmed to after each export, 0 is unbounded
+        int specializeShaderFeatures; // shaders importing VSG_SPECIALIZED get feature toggles as specialization constants rather than defines
+        int bindlessTextureCapacity; // size of the texture array shared by materials of shaders importing VSG_BINDLESS, 0 disables bindless materials
+        int depthOnlyPipelines; // give opaque draws a depth only variant for depth prepasses and shadow passes, 0 disables
+        int sortStateGroups; // reorder and merge stategroups so draws sharing state are adjacent before writing, 0 disables
+        int flattenHierarchy; // collapse plain groups and identity or chained transforms before writing, 0 disables
+        int bakeStaticTransforms; // bake the transforms of static objects into their vertex data before writing, 0 disables
+        int cullHierarchyLeafSize; // groups with more children than this get a bounding volume hierarchy of cullgroups over them, 0 disables
+        float tileSize; // size of the square tiles the scene is split into and written to separate files paged in by distance, 0 disables
+        float tileScreenHeightRatio; // portion of the screen height a tile's bound covers when it's paged in
+        float hlodClusterSize; // size of the cells static objects are clustered into, each cluster drawing a simplified proxy when far away, 0 disables
+        float hlodScreenHeightRatio; // portion of the screen height a cluster's bound covers below which its proxy is drawn
+        int hlodProxyResolution; // cells across a cluster the vertices of its proxy are merged within
+        float pvsCellSize; // size of the cells of the grid a potentially visible set is precomputed for, 0 disables
+        int pvsResolution; // width and height of the cube map faces occluders are rasterized into from each cell
+        int streamLeafData; // write vertex, index and image arrays to a file beside the scene as each node ends instead of holding them until the export ends
+        int packLeafData; // write vertex, index and image arrays once each, in the order they're drawn, to a page aligned file beside the scene that viewers map in place
+        int compressionLevel; // compress the scene file in chunks at this level, 1 fastest to 9 smallest, 0 writes it uncompressed
+    };
+
     // create a vsg Array from a pointer and length, by default the ownership of the memory will be external to vsg still
     // so be sure to call Array dataRelease before the ref_ptr tries to delete the memory
 
@@ -262,7 +322,7 @@ namespace unity2vsg
         return vsg::ref_ptr<vsg::Array<T>>(new vsg::Array<T>(static_cast<size_t>(length), ptr));
     }
 
-    vsg::ref_ptr<vsg::Sampler> createSamplerForTextureData(const ImageData& data)
+    inline vsg::ref_ptr<vsg::Sampler> createSamplerForTextureData(const ImageData& data)
     {
         auto sampler = vsg::Sampler::create();
 
@@ -306,7 +366,7 @@ namespace unity2vsg
         uint32_t blockSize; //bit size of block
     };
 
-    VkFormatSizeInfo GetSizeInfoForFormat(VkFormat format)
+    inline VkFormatSizeInfo GetSizeInfoForFormat(VkFormat format)
     {
         VkFormatSizeInfo sizeInfo;
         sizeInfo.layout.maxNumMipmaps = 1; // sensible default
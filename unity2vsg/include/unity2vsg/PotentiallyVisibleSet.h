@@ -0,0 +1,60 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace unity2vsg
+{
+    struct PVSStats
+    {
+        uint32_t cells = 0;
+        uint32_t targets = 0;
+        uint32_t switchedTargets = 0;
+        uint64_t occluderTriangles = 0;
+        uint64_t hiddenPairs = 0; // cell and target pairs where the target is switched off
+        double cellSize = 0.0;
+    };
+
+    // precompute which of the nodes with a bound (cullgroups, lods and pagedlods) can be seen from each cell of a grid over the
+    // scene, rendering opaque static geometry as occluders into a cube map at sample points of each cell with a multi threaded
+    // software rasterizer. targets hidden from some cell are wrapped in a switch and the visibility is attached to root as the
+    // "pvsOrigin", "pvsCellSize", "pvsCells", "pvsVisibility" and "pvsTargets" objects, see PotentiallyVisibleSet
+    extern void buildPotentiallyVisibleSet(vsg::Group* root, double cellSize, uint32_t resolution, const std::set<vsg::GraphicsPipeline*>& blendedPipelines,
+                                           const std::set<vsg::Node*>* staticTransforms, PVSStats& stats);
+
+    // applies the potentially visible set written with a scene, switching on only the targets visible from the cell holding the
+    // eye. outside the grid everything is switched on
+    class PotentiallyVisibleSet : public vsg::Object
+    {
+    public:
+        explicit PotentiallyVisibleSet(vsg::Object* scene);
+
+        bool valid() const { return !_targets.empty(); }
+
+        // eye is in the space of the scene's parent, only does work when the eye moves to another cell
+        void update(const vsg::dvec3& eye);
+
+    protected:
+        vsg::dvec3 _origin;
+        double _cellSize = 0.0;
+        vsg::uivec3 _cells;
+        vsg::ref_ptr<vsg::ubyteArray2D> _visibility;
+        std::vector<vsg::ref_ptr<vsg::Switch>> _targets;
+        int64_t _currentCell = -2;
+    };
+} // namespace unity2vsg
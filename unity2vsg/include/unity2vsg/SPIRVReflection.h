@@ -0,0 +1,46 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace unity2vsg
+{
+    struct SPIRVDescriptorBinding
+    {
+        uint32_t set;
+        uint32_t binding;
+        VkDescriptorType type;
+        uint32_t count; // 0 for runtime sized arrays
+        bool used;      // accessed by a function of the module rather than only declared
+    };
+
+    struct SPIRVInput
+    {
+        uint32_t location;
+        bool used;
+    };
+
+    struct SPIRVReflection
+    {
+        std::vector<SPIRVDescriptorBinding> descriptorBindings;
+        std::vector<SPIRVInput> inputs; // stage inputs with a location, built ins are excluded
+    };
+
+    // read the descriptor bindings and input locations a spirv module declares and whether its code accesses them, returns false if
+    // the binary can't be parsed
+    extern bool reflectSPIRV(const std::vector<uint32_t>& spirv, SPIRVReflection& reflection);
+} // namespace unity2vsg
@@ -0,0 +1,90 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
+
+namespace unity2vsg
+{
+    // axis aligned bounds, invalid until something is added to them
+    struct Bounds
+    {
+        double min[3] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+        double max[3] = {-std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max()};
+
+        bool valid() const { return min[0] <= max[0]; }
+
+        void expand(double x, double y, double z)
+        {
+            double p[3] = {x, y, z};
+            for (int i = 0; i < 3; i++)
+            {
+                min[i] = std::min(min[i], p[i]);
+                max[i] = std::max(max[i], p[i]);
+            }
+        }
+
+        void expand(const Bounds& bounds)
+        {
+            if (!bounds.valid()) return;
+            expand(bounds.min[0], bounds.min[1], bounds.min[2]);
+            expand(bounds.max[0], bounds.max[1], bounds.max[2]);
+        }
+
+        double center(int axis) const { return (min[axis] + max[axis]) * 0.5; }
+
+        double surfaceArea() const
+        {
+            if (!valid()) return 0.0;
+            double dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+            return 2.0 * (dx * dy + dy * dz + dz * dx);
+        }
+
+        vsg::dsphere sphere() const
+        {
+            double dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+            return vsg::dsphere(vsg::dvec3(center(0), center(1), center(2)), 0.5 * std::sqrt(dx * dx + dy * dy + dz * dz));
+        }
+    };
+
+    // bounds of subgraphs in the space of the group holding them, the bounds of vertex arrays are cached so shared meshes are only
+    // read once and whether each node can be moved so subgraphs aren't walked again for every node above them
+    class BoundsCalculator
+    {
+    public:
+        explicit BoundsCalculator(const std::set<vsg::GraphicsPipeline*>& blendedPipelines) :
+            _blendedPipelines(blendedPipelines) {}
+
+        // returns false if the node draws blended or holds something whose bounds aren't known, those nodes can't be moved
+        bool bounds(vsg::Node* node, const vsg::dmat4& matrix, Bounds& bounds);
+
+        bool blended(vsg::Object* object) const;
+
+    private:
+        bool addBounds(vsg::Node* node, const vsg::dmat4& matrix, Bounds& bounds);
+        bool movable(vsg::Node* node);
+        bool movable(const vsg::Group::Children& children);
+        bool addPositions(vsg::Data* data, const vsg::dmat4& matrix, Bounds& bounds);
+        void addSphere(const vsg::dsphere& sphere, const vsg::dmat4& matrix, Bounds& bounds) const;
+
+        const std::set<vsg::GraphicsPipeline*>& _blendedPipelines;
+        std::map<vsg::Data*, Bounds> _localBounds;
+        std::map<vsg::Node*, bool> _movable;
+    };
+} // namespace unity2vsg
@@ -0,0 +1,51 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/SceneBounds.h>
+
+#include <vsg/all.h>
+
+#include <array>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace unity2vsg
+{
+    // the draws of one cell of a grid over the scene, with copies of the groups, transforms and stategroups above them
+    struct SceneTile
+    {
+        std::array<int, 3> cell;
+        Bounds bounds;
+        vsg::ref_ptr<vsg::Group> root;
+    };
+
+    // move the draws under root into cells of a grid of tileSize by the center of their bounds, leaving root holding blended draws,
+    // draws whose bounds can't be computed and, if staticTransforms is given, draws below transforms not in it
+    extern std::vector<SceneTile> splitIntoTiles(vsg::Group* root, double tileSize, const std::set<vsg::GraphicsPipeline*>& blendedPipelines,
+                                                 const std::set<vsg::Node*>* staticTransforms = nullptr);
+
+    // a tile of the scene to be written to its own file, fileName is relative to the scene file
+    struct TilePage
+    {
+        std::string fileName;
+        vsg::ref_ptr<vsg::Node> root;
+    };
+
+    // move the draws under root into square tiles of tileSize by the center of their bounds, each tile holding copies of the groups,
+    // transforms and stategroups above its draws. root is left referencing the tiles through pagedlods that load them once their
+    // bound is above minimumScreenHeightRatio of the screen. blended draws and draws whose bounds can't be computed stay in root
+    extern std::vector<TilePage> tileScene(vsg::Group* root, double tileSize, double minimumScreenHeightRatio, const std::string& sceneFileName,
+                                           const std::set<vsg::GraphicsPipeline*>& blendedPipelines);
+} // namespace unity2vsg
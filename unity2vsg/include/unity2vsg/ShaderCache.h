@@ -0,0 +1,60 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/all.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace unity2vsg
+{
+    // Persistent cache of compiled spirv shared between exports. Entries are keyed by a hash of the fully
+    // preprocessed shader source, the stage and the compiler options, and stored one file per entry so several
+    // exporters can share a directory. Entries are written to a temporary file and renamed into place so readers
+    // never see a partial entry, and hits refresh the file time so trim() evicts the least recently used first.
+
+    class ShaderCache : public vsg::Object
+    {
+    public:
+        ShaderCache(const std::string& directory, uint64_t maxSize);
+
+        // create the key for a shader variant
+        static std::string createKey(VkShaderStageFlagBits stage, const std::string& source, uint32_t optimization, bool stripDebugInfo);
+
+        // returns true and fills spirv if an entry exists for key
+        bool read(const std::string& key, vsg::ShaderModule::SPIRV& spirv);
+
+        void write(const std::string& key, const vsg::ShaderModule::SPIRV& spirv);
+
+        // evict least recently used entries until the cache is within its maximum size, 0 means unbounded
+        void trim();
+
+        std::string statistics() const;
+
+    protected:
+        std::string entryFileName(const std::string& key) const;
+
+        std::string _directory;
+        uint64_t _maxSize;
+        bool _valid;
+
+        std::atomic<uint32_t> _hits;
+        std::atomic<uint32_t> _misses;
+        std::atomic<uint32_t> _writes;
+        std::atomic<uint32_t> _evictions;
+    };
+} // namespace unity2vsg
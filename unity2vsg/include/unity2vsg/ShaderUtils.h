@@ -40,10 +40,67 @@ namespace unity2vsg
         ALL_SHADER_MODE_MASK = LIGHTING | MATERIAL | BLEND | BILLBOARD | DIFFUSE_MAP | OPACITY_MAP | AMBIENT_MAP | NORMAL_MAP | SPECULAR_MAP | SHADER_TRANSLATE
     };
 
+    // feature defines that shaders importing VSG_SPECIALIZED read from bool specialization constants instead, so one module serves
+    // every combination of them. binding is the texture the feature samples, which needs a placeholder when the feature is off
+    struct SpecializedFeature
+    {
+        const char* define;
+        uint32_t constantID;
+        int32_t binding;
+    };
+
+    extern const std::vector<SpecializedFeature>& specializedShaderFeatures();
+
+    // layout of bindless materials for shaders importing VSG_BINDLESS. every texture in the export is in one sampler array and every
+    // material's record in one storage buffer, a push constant after the matrices holds the offset in uints of the draw's record.
+    // a record is the texture array index for each binding below BINDLESS_TEXTURE_SLOTS followed by the material's uniform block.
+    // the sampler array is sized by the specialization constant BINDLESS_TEXTURE_CAPACITY_CONSTANT
+    enum BindlessLayout : uint32_t
+    {
+        BINDLESS_TEXTURES_BINDING = 0,
+        BINDLESS_MATERIALS_BINDING = 1,
+        BINDLESS_MATERIAL_OFFSET = 128,
+        BINDLESS_TEXTURE_SLOTS = 16,
+        BINDLESS_TEXTURE_CAPACITY_CONSTANT = 110
+    };
+
+    // read the raw source of a glsl file and a hash of it, sources are cached by file name and reloaded when the file is modified
+    extern bool readGLSLSource(const std::string& filename, std::string& source, uint64_t& hash);
+
+    // fold the hashes of every file source includes, directly or through other includes, into hash. returns false if any of them
+    // can't be read, in which case the hash doesn't identify the preprocessed source and mustn't be used as a key
+    extern bool hashGLSLIncludes(const std::string& source, const std::string& filename, uint64_t& hash);
+
+    // the full set of defines for a shader variant, trimmed, sorted and without duplicates so define order doesn't create new variants
+    extern std::vector<std::string> createCanonicalDefines(const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines);
+
+    // the subset of defines that source or its includes import, any others can't change the preprocessed source so variants differing only by them are identical
+    extern std::vector<std::string> filterImportedDefines(const std::string& source, const std::vector<std::string>& defines, const std::string& filename = std::string());
+
+    // inject the defines imported by source after its version and inline its includes, which are resolved relative to filename
+    extern std::string preprocessGLSLShader(const std::string& source, const std::vector<std::string>& defines, const std::string& filename = std::string());
+
     // read a glsl file and inject defines based on shadermode mask and geometryattributes
     extern std::string readGLSLShader(const std::string& filename, const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines);
 
     // create standard shader and inject defines based on shadermode mask and geometryattributes
     extern std::string createFbxVertexSource(const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines);
     extern std::string createFbxFragmentSource(const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines);
+
+    enum ShaderOptimization : uint32_t
+    {
+        SHADER_OPTIMIZATION_NONE = 0,
+        SHADER_OPTIMIZATION_PERFORMANCE = 1,
+        SHADER_OPTIMIZATION_SIZE = 2
+    };
+
+    // glslang keeps per thread state, threads other than the one that first compiles a shader must call these before and after compiling
+    extern void initializeShaderCompilerThread();
+    extern void finalizeShaderCompilerThread();
+
+    // compile glsl source for a single stage to spirv, on failure the glslang log is passed to DebugLog and false is returned
+    extern bool compileGLSLToSPIRV(VkShaderStageFlagBits stage, const std::string& source, uint32_t optimization, bool stripDebugInfo, vsg::ShaderModule::SPIRV& spirv);
+
+    // remove the debug instructions (names, source text and line info) from a spirv binary
+    extern void stripSPIRVDebugInfo(vsg::ShaderModule::SPIRV& spirv);
 } // namespace unity2vsg
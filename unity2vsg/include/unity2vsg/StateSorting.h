@@ -0,0 +1,36 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <vsg/all.h>
+
+#include <cstdint>
+#include <set>
+
+namespace unity2vsg
+{
+    struct StateChangeCount
+    {
+        uint32_t pipelines = 0;
+        uint32_t descriptorSets = 0;
+    };
+
+    // count the pipeline and descriptor set binds recording the graph makes. state a stategroup pushes is only bound when something
+    // below it draws and isn't bound already
+    extern StateChangeCount countStateChanges(vsg::Node* root);
+
+    // reorder the children of each group so subgraphs drawn with the same pipeline, then the same descriptor set, are adjacent, and
+    // merge sibling stategroups binding the same pipeline into one holding a stategroup per descriptor set. subgraphs drawn with a
+    // blending pipeline keep their relative order and go after the opaque ones, stategroups carrying objects or values are kept whole
+    extern void sortStateGroups(vsg::Node* root, const std::set<vsg::GraphicsPipeline*>& blendedPipelines);
+} // namespace unity2vsg
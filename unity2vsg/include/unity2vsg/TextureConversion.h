@@ -0,0 +1,31 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/NativeUtils.h>
+
+#include <vsg/all.h>
+
+namespace unity2vsg
+{
+    // returns true if the pixels of data are not in data.format and must be converted before they can be exported
+    bool requiresFormatConversion(const ImageData& data);
+
+    // convert the pixels of source, including all of its mip levels, into source.format. converted is set to a copy of
+    // source pointing at the new pixels, the returned array owns those pixels and must outlive any data using them
+    vsg::ref_ptr<vsg::ubyteArray> convertImageData(const ImageData& source, ImageData& converted);
+
+    // average the texels of the top mip level of 8 bit rgba or bgra data into color, returns false for any other format
+    bool averageImageColor(const ImageData& data, vsg::vec4& color);
+} // namespace unity2vsg
@@ -0,0 +1,54 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+
+#include <vsg/all.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace unity2vsg
+{
+    // Fixed size pool of worker threads running tasks in the order they were submitted. threadInit and threadExit
+    // are run on each worker as it starts and stops so libraries with per thread state can be set up.
+
+    class ThreadPool : public vsg::Object
+    {
+    public:
+        ThreadPool(uint32_t numThreads, std::function<void()> threadInit = {}, std::function<void()> threadExit = {});
+
+        // queue a task, the future becomes ready once it has run and rethrows anything the task threw
+        std::future<void> run(std::function<void()> task);
+
+        uint32_t size() const { return static_cast<uint32_t>(_threads.size()); }
+
+    protected:
+        // finishes all queued tasks before joining the workers
+        virtual ~ThreadPool();
+
+        void worker(std::function<void()> threadInit, std::function<void()> threadExit);
+
+        std::vector<std::thread> _threads;
+        std::deque<std::packaged_task<void()>> _tasks;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _stopping;
+    };
+} // namespace unity2vsg
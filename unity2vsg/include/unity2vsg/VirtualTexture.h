@@ -0,0 +1,80 @@
+#pragma once
+
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/Export.h>
+#include <unity2vsg/NativeUtils.h>
+
+#include <vsg/all.h>
+
+namespace unity2vsg
+{
+    // Cuts large textures into fixed size pages per mip level and writes them to a single tile store file.
+    // Mip levels small enough to fit in a single page (the mip tail) stay resident as a regular texture
+    // so shaders that know nothing about virtual texturing still have something sensible to sample.
+
+    class VirtualTextureBuilder : public vsg::Object
+    {
+    public:
+        VirtualTextureBuilder(uint32_t minSize, uint32_t pageSize, uint32_t pageBorder);
+
+        // returns true if the image is large enough to be paged and in a format we can page
+        bool requiresVirtualTexture(const ImageData& data) const;
+
+        // register the image for paging, mipTail is set to the resident levels of the image and the
+        // returned object holds the page tables and layout info a runtime needs to stream the pages
+        vsg::ref_ptr<vsg::Objects> add(const ImageData& data, ImageData& mipTail);
+
+        // write all the registered pages to fileName and record it on each texture's info, must be called before
+        // the scene referencing the infos is written and before the source pixels are released
+        bool writeTileStore(const std::string& fileName);
+
+        bool empty() const { return _textures.empty(); }
+
+        static std::string tileStoreFileName(const std::string& sceneFileName);
+
+    protected:
+        struct Level
+        {
+            uint32_t width;
+            uint32_t height;
+            uint32_t pagesX;
+            uint32_t pagesY;
+            size_t offset; // byte offset of the level in the source pixels
+            uint32_t firstTile;
+            std::vector<std::pair<uint32_t, uint32_t>> pageOrder; // page x, y in the order they are written to the store
+        };
+
+        struct PagedTexture
+        {
+            ImageData source;
+            uint32_t texelSize;
+            std::vector<Level> levels; // paged levels only, the mip tail isn't included
+            vsg::ref_ptr<vsg::Objects> info;
+        };
+
+        // compute the paged levels of the image, returns false if the image has no mip level that fits in a page
+        bool computeLevels(const ImageData& data, std::vector<Level>& levels, uint32_t& tailLevel, size_t& tailOffset) const;
+
+        void copyTile(const PagedTexture& texture, const Level& level, uint32_t pageX, uint32_t pageY, std::vector<uint8_t>& buffer) const;
+
+        uint32_t _minSize;
+        uint32_t _pageSize;
+        uint32_t _pageBorder;
+
+        uint32_t _tileCount = 0;
+        std::vector<PagedTexture> _textures;
+        std::map<int, size_t> _textureIndices; // ImageData id to index in _textures
+
+    };
+} // namespace unity2vsg
@@ -17,9 +17,12 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 extern "C"
 {
-    UNITY2VSG_EXPORT void unity2vsg_BeginExport();
+    UNITY2VSG_EXPORT void unity2vsg_BeginExport(unity2vsg::ExportSettingsData settings);
     UNITY2VSG_EXPORT void unity2vsg_EndExport(const char* saveFileName);
 
+    // fill pointers with up to capacity pointers to memory passed in that the export has let go of, returns the number filled
+    UNITY2VSG_EXPORT uint32_t unity2vsg_TakeReleasedData(void** pointers, uint32_t capacity);
+
     // add nodes
     UNITY2VSG_EXPORT void unity2vsg_AddGroupNode();
     UNITY2VSG_EXPORT void unity2vsg_AddTransformNode(unity2vsg::TransformData transform);
@@ -49,6 +52,7 @@ extern "C"
     UNITY2VSG_EXPORT void unity2vsg_AddDescriptorBufferFloatArray(unity2vsg::DescriptorFloatArrayUniformData data);
     UNITY2VSG_EXPORT void unity2vsg_AddDescriptorBufferVector(unity2vsg::DescriptorVectorUniformData data);
     UNITY2VSG_EXPORT void unity2vsg_AddDescriptorBufferVectorArray(unity2vsg::DescriptorVectorArrayUniformData data);
+    UNITY2VSG_EXPORT void unity2vsg_AddDescriptorBufferBlock(unity2vsg::DescriptorUniformBlockData data);
 
     UNITY2VSG_EXPORT void unity2vsg_EndNode();
 
@@ -0,0 +1,151 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+
+#include <unity2vsg/ChunkedCompression.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+
+// round trips blocks and containers through the lz4 compressor at every level, then times compressing and decompressing a block
+
+namespace
+{
+    // the chunk size containers are cut into
+    constexpr size_t chunkSize = 1 << 20;
+
+    std::vector<uint8_t> randomBytes(size_t size, std::mt19937& random)
+    {
+        std::vector<uint8_t> bytes(size);
+        for (auto& byte : bytes) byte = static_cast<uint8_t>(random());
+        return bytes;
+    }
+
+    // runs of a few symbols with the odd random byte, roughly as compressible as vertex data
+    std::vector<uint8_t> compressibleBytes(size_t size, std::mt19937& random)
+    {
+        std::vector<uint8_t> bytes(size);
+        for (size_t i = 0; i < size; i++) bytes[i] = (random() % 16 == 0) ? static_cast<uint8_t>(random()) : static_cast<uint8_t>((i / 7) % 5);
+        return bytes;
+    }
+
+    bool roundTripBlock(const std::vector<uint8_t>& input, int level)
+    {
+        std::vector<uint8_t> compressed;
+        unity2vsg::compressBlock(input.data(), input.size(), level, compressed);
+
+        std::vector<uint8_t> output(input.size());
+        return unity2vsg::decompressBlock(compressed.data(), compressed.size(), output.data(), output.size()) && output == input;
+    }
+
+    bool roundTripFile(const std::vector<uint8_t>& input, int level, const std::filesystem::path& path)
+    {
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(input.data()), static_cast<std::streamsize>(input.size()));
+        }
+
+        unity2vsg::CompressionStats stats;
+        std::string contents;
+        if (!unity2vsg::compressFile(path.string(), level, stats) || !unity2vsg::decompressFile(path.string(), contents)) return false;
+        if (contents.size() != input.size() || std::memcmp(contents.data(), input.data(), input.size()) != 0) return false;
+
+        // read back the way the viewer reads a scene, through a stream over the contents
+        unity2vsg::MemoryStreamBuffer buffer(&contents[0], contents.size());
+        std::istream stream(&buffer);
+        std::vector<uint8_t> streamed((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        return streamed == input;
+    }
+
+    template<typename F>
+    double timeMilliseconds(int iterations, F func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) func();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 10;
+
+    std::mt19937 random(2019);
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> inputs;
+
+    // inputs under 13 bytes are too short to hold a match and are written as literals
+    for (size_t size = 0; size < 13; size++)
+    {
+        inputs.emplace_back("random " + std::to_string(size), randomBytes(size, random));
+        inputs.emplace_back("repeated " + std::to_string(size), std::vector<uint8_t>(size, 'a'));
+    }
+    for (size_t size : {size_t(13), size_t(64), size_t(4096), size_t(65536 + 17), chunkSize})
+    {
+        inputs.emplace_back("incompressible " + std::to_string(size), randomBytes(size, random));
+        inputs.emplace_back("repeated " + std::to_string(size), std::vector<uint8_t>(size, 0));
+        inputs.emplace_back("compressible " + std::to_string(size), compressibleBytes(size, random));
+    }
+
+    int result = 0;
+    for (int level = 1; level <= 9; level++)
+    {
+        for (auto& [name, input] : inputs)
+        {
+            if (!roundTripBlock(input, level))
+            {
+                std::cerr << name << ": block doesn't round trip at level " << level << std::endl;
+                result = 1;
+            }
+        }
+    }
+
+    // containers a byte either side of the chunk boundaries, and a container too small to compress
+    auto path = std::filesystem::temp_directory_path() / "chunkedCompressionBenchmark.bin";
+    for (size_t size : {size_t(12), chunkSize - 1, chunkSize, chunkSize + 1, 2 * chunkSize - 1, 2 * chunkSize, 2 * chunkSize + 1})
+    {
+        for (int level : {1, 9})
+        {
+            if (!roundTripFile(compressibleBytes(size, random), level, path) || !roundTripFile(randomBytes(size, random), level, path))
+            {
+                std::cerr << size << " byte container doesn't round trip at level " << level << std::endl;
+                result = 1;
+            }
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    auto input = compressibleBytes(chunkSize, random);
+    std::vector<uint8_t> output(input.size());
+    for (int level : {1, 5, 9})
+    {
+        std::vector<uint8_t> compressed;
+        double compress = timeMilliseconds(iterations, [&]() {
+            compressed.clear();
+            unity2vsg::compressBlock(input.data(), input.size(), level, compressed);
+        });
+        double decompress = timeMilliseconds(iterations, [&]() { unity2vsg::decompressBlock(compressed.data(), compressed.size(), output.data(), output.size()); });
+
+        double megabytes = static_cast<double>(input.size()) * iterations / (1024.0 * 1024.0);
+        std::cout << "level " << level << ": " << input.size() << " -> " << compressed.size() << " bytes, compress " << megabytes / compress * 1000.0
+                  << "MB/s, decompress " << megabytes / decompress * 1000.0 << "MB/s" << std::endl;
+    }
+
+    if (result == 0) std::cout << "every block and container round trips" << std::endl;
+    return result;
+}
@@ -0,0 +1,159 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/GLSLPreprocessor.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// compares the single pass preprocessor with the istringstream implementation it replaced over the bundled shaders
+
+namespace
+{
+    // the original implementation, kept here as the baseline
+    std::string legacyProcessGLSLShaderSource(const std::string& source, const std::vector<std::string>& defines)
+    {
+        auto sanitise = [](std::string& str) {
+            size_t startpos = str.find_first_not_of(" \t");
+            if (std::string::npos != startpos) str = str.substr(startpos);
+            size_t endpos = str.find_last_not_of(" \t\n");
+            if (endpos != std::string::npos) str = str.substr(0, endpos + 1);
+        };
+
+        auto startsWith = [](const std::string& str, const std::string& match) {
+            return str.compare(0, match.length(), match) == 0;
+        };
+
+        auto stringBetween = [](const std::string& str, const char& startChar, const char& endChar) {
+            auto start = str.find_first_of(startChar);
+            if (start == std::string::npos) return std::string();
+            auto end = str.find_first_of(endChar, start);
+            if (end == std::string::npos) return std::string();
+            if ((end - start) - 1 == 0) return std::string();
+            return str.substr(start + 1, (end - start) - 1);
+        };
+
+        auto split = [](const std::string& str, const char& seperator) {
+            std::vector<std::string> elements;
+            std::string::size_type prev_pos = 0, pos = 0;
+            while ((pos = str.find(seperator, pos)) != std::string::npos)
+            {
+                elements.push_back(str.substr(prev_pos, pos - prev_pos));
+                prev_pos = ++pos;
+            }
+            elements.push_back(str.substr(prev_pos, pos - prev_pos));
+            return elements;
+        };
+
+        std::istringstream iss(source);
+        std::ostringstream headerstream;
+        std::ostringstream sourcestream;
+
+        for (std::string line; std::getline(iss, line);)
+        {
+            std::string sanitisedline = line;
+            sanitise(sanitisedline);
+
+            if (startsWith(sanitisedline, "#version"))
+            {
+                headerstream << line << "\n";
+            }
+            else if (startsWith(sanitisedline, "#pragma import_defines"))
+            {
+                headerstream << line << "\n";
+                for (auto importedDef : split(stringBetween(sanitisedline, '(', ')'), ','))
+                {
+                    sanitise(importedDef);
+                    if (std::find(defines.begin(), defines.end(), importedDef) != defines.end())
+                    {
+                        headerstream << "#define " + importedDef << "\n";
+                    }
+                }
+            }
+            else
+            {
+                sourcestream << line << "\n";
+            }
+        }
+
+        return headerstream.str() + sourcestream.str();
+    }
+
+    template<typename F>
+    double timeMilliseconds(int iterations, F func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) func();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string directory = argc > 1 ? argv[1] : UNITY2VSG_SHADER_DIRECTORY;
+    int iterations = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 2000;
+
+    std::vector<std::pair<std::string, std::string>> shaders;
+    std::error_code ec;
+    for (auto& entry : std::filesystem::directory_iterator(directory, ec))
+    {
+        auto extension = entry.path().extension().string();
+        if (extension != ".vert" && extension != ".frag") continue;
+
+        std::ifstream file(entry.path(), std::ios::binary);
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        shaders.emplace_back(entry.path().filename().string(), contents.str());
+    }
+
+    if (shaders.empty())
+    {
+        std::cerr << "No .vert or .frag shaders found in '" << directory << "'" << std::endl;
+        return 1;
+    }
+
+    // every define the exporter can produce, so each import_defines pragma expands fully
+    std::vector<std::string> defines = {"VSG_NORMAL", "VSG_TANGENT", "VSG_COLOR", "VSG_TEXCOORD0", "VSG_LIGHTING", "VSG_MATERIAL", "VSG_DIFFUSE_MAP",
+                                        "VSG_OPACITY_MAP", "VSG_AMBIENT_MAP", "VSG_NORMAL_MAP", "VSG_SPECULAR_MAP", "VSG_BILLBOARD", "VSG_PACKED_MAP",
+                                        "VSG_PACKED_AMBIENT", "VSG_PACKED_SPECULAR", "VSG_PACKED_OPACITY"};
+
+    int result = 0;
+    double legacyTotal = 0.0;
+    double singlePassTotal = 0.0;
+    size_t sink = 0;
+
+    for (auto& [name, source] : shaders)
+    {
+        if (legacyProcessGLSLShaderSource(source, defines) != unity2vsg::preprocessGLSLSource(source, defines))
+        {
+            std::cerr << name << ": output differs from the legacy preprocessor" << std::endl;
+            result = 1;
+        }
+
+        double legacy = timeMilliseconds(iterations, [&]() { sink += legacyProcessGLSLShaderSource(source, defines).size(); });
+        double singlePass = timeMilliseconds(iterations, [&]() { sink += unity2vsg::preprocessGLSLSource(source, defines).size(); });
+        legacyTotal += legacy;
+        singlePassTotal += singlePass;
+
+        std::cout << name << " (" << source.size() << " bytes): legacy " << legacy / iterations * 1000.0 << "us, single pass "
+                  << singlePass / iterations * 1000.0 << "us, " << legacy / singlePass << "x" << std::endl;
+    }
+
+    std::cout << "total over " << iterations << " iterations: legacy " << legacyTotal << "ms, single pass " << singlePassTotal << "ms, "
+              << legacyTotal / singlePassTotal << "x (" << sink << ")" << std::endl;
+
+    return result;
+}
@@ -0,0 +1,387 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/ChunkedCompression.h>
+
+#include <unity2vsg/DebugLog.h>
+#include <unity2vsg/ThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // container layout
+    //   ContainerHeader
+    //   ChunkEntry chunks[chunkCount]
+    //   chunk data, each chunk an lz4 block or the chunk's bytes as they are if compressing didn't make it smaller
+    struct ContainerHeader
+    {
+        char magic[8] = {'v', 's', 'g', 'c', 'h', 'u', 'n', 'k'};
+        uint32_t version = 1;
+        uint32_t chunkCount = 0;
+        uint64_t uncompressedSize = 0;
+        uint32_t chunkSize = 0;
+        uint32_t reserved = 0;
+    };
+
+    struct ChunkEntry
+    {
+        uint64_t offset = 0; // from the start of the file
+        uint32_t compressedSize = 0; // equal to uncompressedSize if the chunk is stored as it is
+        uint32_t uncompressedSize = 0;
+    };
+
+    constexpr uint32_t chunkSize = 1 << 20;
+
+    // lz4 block format limits, the last match starts at least matchStartLimit bytes before the end of the block and is followed by
+    // at least lastLiterals literals
+    constexpr size_t minMatch = 4;
+    constexpr size_t lastLiterals = 5;
+    constexpr size_t matchStartLimit = 12;
+    constexpr size_t maxOffset = 65535;
+
+    constexpr uint32_t hashBits = 16;
+
+    uint32_t read32(const uint8_t* p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    uint32_t hash(uint32_t sequence)
+    {
+        return (sequence * 2654435761u) >> (32 - hashBits);
+    }
+
+    void writeLength(size_t length, std::vector<uint8_t>& dst)
+    {
+        for (; length >= 255; length -= 255) dst.push_back(255);
+        dst.push_back(static_cast<uint8_t>(length));
+    }
+
+    void writeSequence(const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength, std::vector<uint8_t>& dst)
+    {
+        size_t matchCode = matchLength > 0 ? matchLength - minMatch : 0;
+        dst.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        if (literalCount >= 15) writeLength(literalCount - 15, dst);
+        dst.insert(dst.end(), literals, literals + literalCount);
+
+        // the last sequence is literals only
+        if (matchLength == 0) return;
+
+        dst.push_back(static_cast<uint8_t>(offset & 0xff));
+        dst.push_back(static_cast<uint8_t>(offset >> 8));
+        if (matchCode >= 15) writeLength(matchCode - 15, dst);
+    }
+
+    // read an extended length, false if it runs past end
+    bool readLength(const uint8_t*& ip, const uint8_t* end, size_t& length)
+    {
+        uint8_t byte;
+        do
+        {
+            if (ip >= end) return false;
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    }
+} // namespace
+
+void unity2vsg::compressBlock(const uint8_t* src, size_t srcSize, int level, std::vector<uint8_t>& dst)
+{
+    const uint8_t* anchor = src;
+    const uint8_t* end = src + srcSize;
+
+    if (srcSize > matchStartLimit)
+    {
+        // level 1 checks the one position last seen with the same hash, higher levels follow a chain of them
+        uint32_t maxAttempts = level <= 1 ? 1u : 1u << std::min(level + 1, 10);
+        std::vector<int32_t> head(size_t(1) << hashBits, -1);
+        std::vector<int32_t> previous(level <= 1 ? 0 : srcSize, -1);
+
+        auto insert = [&](const uint8_t* p) {
+            auto position = static_cast<int32_t>(p - src);
+            auto& first = head[hash(read32(p))];
+            if (!previous.empty()) previous[position] = first;
+            first = position;
+        };
+
+        const uint8_t* matchLimit = end - lastLiterals;
+        const uint8_t* startLimit = end - matchStartLimit;
+        const uint8_t* ip = src;
+        uint32_t misses = 0;
+
+        while (ip < startLimit)
+        {
+            uint32_t sequence = read32(ip);
+            int32_t candidate = head[hash(sequence)];
+            insert(ip);
+
+            const uint8_t* match = nullptr;
+            size_t matchLength = 0;
+            for (uint32_t attempt = 0; attempt < maxAttempts && candidate >= 0 && static_cast<size_t>(ip - src - candidate) <= maxOffset; ++attempt)
+            {
+                const uint8_t* ref = src + candidate;
+                if (read32(ref) == sequence)
+                {
+                    size_t length = minMatch;
+                    while (ip + length < matchLimit && ref[length] == ip[length]) ++length;
+                    if (length > matchLength)
+                    {
+                        match = ref;
+                        matchLength = length;
+                    }
+                }
+                if (previous.empty()) break;
+                candidate = previous[candidate];
+            }
+
+            if (!match)
+            {
+                // skip faster through data that doesn't compress
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            // the match may reach back into the literals before it
+            while (ip > anchor && match > src && ip[-1] == match[-1])
+            {
+                --ip;
+                --match;
+                ++matchLength;
+            }
+
+            writeSequence(anchor, static_cast<size_t>(ip - anchor), static_cast<size_t>(ip - match), matchLength, dst);
+
+            const uint8_t* matchEnd = ip + matchLength;
+            if (!previous.empty())
+            {
+                for (const uint8_t* p = ip + 1; p < matchEnd && p < startLimit; ++p) insert(p);
+            }
+            ip = matchEnd;
+            anchor = ip;
+        }
+    }
+
+    writeSequence(anchor, static_cast<size_t>(end - anchor), 0, 0, dst);
+}
+
+bool unity2vsg::decompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize)
+{
+    const uint8_t* ip = src;
+    const uint8_t* end = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* outEnd = dst + dstSize;
+
+    while (ip < end)
+    {
+        uint8_t token = *ip++;
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(ip, end, literalCount)) return false;
+        if (literalCount > static_cast<size_t>(end - ip) || literalCount > static_cast<size_t>(outEnd - op)) return false;
+        std::memcpy(op, ip, literalCount);
+        ip += literalCount;
+        op += literalCount;
+
+        if (ip == end) break;
+
+        if (end - ip < 2) return false;
+        size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, end, matchLength)) return false;
+        matchLength += minMatch;
+        if (matchLength > static_cast<size_t>(outEnd - op)) return false;
+
+        // matches may overlap the bytes they produce
+        const uint8_t* ref = op - offset;
+        for (size_t i = 0; i < matchLength; ++i) op[i] = ref[i];
+        op += matchLength;
+    }
+
+    return op == outEnd;
+}
+
+bool unity2vsg::compressFile(const std::string& fileName, int level, CompressionStats& stats)
+{
+    std::vector<uint8_t> contents;
+    {
+        std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            DebugLog("ChunkedCompression Error: Unable to open " + fileName);
+            return false;
+        }
+        contents.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(contents.size())))
+        {
+            DebugLog("ChunkedCompression Error: Unable to read " + fileName);
+            return false;
+        }
+    }
+
+    level = std::clamp(level, 1, 9);
+    uint32_t chunkCount = static_cast<uint32_t>((contents.size() + chunkSize - 1) / chunkSize);
+    std::vector<std::vector<uint8_t>> chunks(chunkCount);
+
+    // threads take the next chunk until none are left
+    {
+        std::atomic<uint32_t> nextChunk(0);
+        auto compressChunks = [&]() {
+            for (uint32_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+            {
+                size_t offset = static_cast<size_t>(chunk) * chunkSize;
+                size_t size = std::min<size_t>(chunkSize, contents.size() - offset);
+                compressBlock(contents.data() + offset, size, level, chunks[chunk]);
+                if (chunks[chunk].size() >= size) chunks[chunk].assign(contents.begin() + offset, contents.begin() + offset + size);
+            }
+        };
+
+        vsg::ref_ptr<ThreadPool> threads(new ThreadPool(std::max(std::min(std::thread::hardware_concurrency(), chunkCount), 1u)));
+        std::vector<std::future<void>> tasks;
+        for (uint32_t i = 0; i < threads->size(); ++i) tasks.push_back(threads->run(compressChunks));
+        for (auto& task : tasks) task.get();
+    }
+
+    ContainerHeader header;
+    header.chunkCount = chunkCount;
+    header.uncompressedSize = contents.size();
+    header.chunkSize = chunkSize;
+
+    std::vector<ChunkEntry> entries(chunkCount);
+    uint64_t offset = sizeof(ContainerHeader) + sizeof(ChunkEntry) * chunkCount;
+    for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        entries[chunk].offset = offset;
+        entries[chunk].compressedSize = static_cast<uint32_t>(chunks[chunk].size());
+        entries[chunk].uncompressedSize = static_cast<uint32_t>(std::min<size_t>(chunkSize, contents.size() - static_cast<size_t>(chunk) * chunkSize));
+        offset += chunks[chunk].size();
+    }
+
+    // written beside the file and moved over it, so a failed write leaves the uncompressed file
+    std::string compressedFileName = fileName + ".tmp";
+    {
+        std::ofstream file(compressedFileName, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(ChunkEntry)));
+        for (auto& chunk : chunks) file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+        if (!file)
+        {
+            DebugLog("ChunkedCompression Error: Failed writing " + compressedFileName);
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(compressedFileName, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(compressedFileName, fileName, ec);
+    if (ec)
+    {
+        DebugLog("ChunkedCompression Error: Unable to replace " + fileName + ", " + ec.message());
+        std::filesystem::remove(compressedFileName, ec);
+        return false;
+    }
+
+    stats.chunks += chunkCount;
+    stats.uncompressedSize += contents.size();
+    stats.compressedSize += offset;
+    return true;
+}
+
+bool unity2vsg::decompressFile(const std::string& fileName, std::string& contents)
+{
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    auto fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    ContainerHeader header;
+    ContainerHeader expected;
+    if (fileSize < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0)
+    {
+        return false;
+    }
+
+    std::vector<ChunkEntry> entries(header.chunkCount);
+    std::vector<uint8_t> compressed(static_cast<size_t>(fileSize));
+    file.seekg(0);
+    if (header.version != expected.version || header.chunkSize == 0 || !file.read(reinterpret_cast<char*>(compressed.data()), static_cast<std::streamsize>(fileSize)) ||
+        fileSize < sizeof(header) + sizeof(ChunkEntry) * static_cast<uint64_t>(header.chunkCount))
+    {
+        DebugLog("ChunkedCompression Error: " + fileName + " isn't a container this version can read");
+        return false;
+    }
+    std::memcpy(entries.data(), compressed.data() + sizeof(header), entries.size() * sizeof(ChunkEntry));
+
+    // every chunk is checked to lie within the file and fill its part of the contents before any are decompressed
+    uint64_t uncompressedOffset = 0;
+    std::vector<uint64_t> uncompressedOffsets(header.chunkCount);
+    for (uint32_t chunk = 0; chunk < header.chunkCount; ++chunk)
+    {
+        auto& entry = entries[chunk];
+        if (entry.offset > fileSize || entry.compressedSize > fileSize - entry.offset || entry.uncompressedSize > header.chunkSize) return false;
+        uncompressedOffsets[chunk] = uncompressedOffset;
+        uncompressedOffset += entry.uncompressedSize;
+    }
+    if (uncompressedOffset != header.uncompressedSize)
+    {
+        DebugLog("ChunkedCompression Error: The chunk index of " + fileName + " is damaged");
+        return false;
+    }
+
+    contents.assign(static_cast<size_t>(header.uncompressedSize), '\0');
+    std::atomic<uint32_t> nextChunk(0);
+    std::atomic<uint32_t> failed(0);
+    auto decompressChunks = [&]() {
+        for (uint32_t chunk = nextChunk++; chunk < header.chunkCount; chunk = nextChunk++)
+        {
+            auto& entry = entries[chunk];
+            auto dst = reinterpret_cast<uint8_t*>(&contents[0]) + uncompressedOffsets[chunk];
+            if (entry.compressedSize == entry.uncompressedSize) std::memcpy(dst, compressed.data() + entry.offset, entry.uncompressedSize);
+            else if (!decompressBlock(compressed.data() + entry.offset, entry.compressedSize, dst, entry.uncompressedSize)) ++failed;
+        }
+    };
+
+    {
+        vsg::ref_ptr<ThreadPool> threads(new ThreadPool(std::max(std::min(std::thread::hardware_concurrency(), header.chunkCount), 1u)));
+        std::vector<std::future<void>> tasks;
+        for (uint32_t i = 0; i < threads->size(); ++i) tasks.push_back(threads->run(decompressChunks));
+        for (auto& task : tasks) task.get();
+    }
+
+    // the compressed file isn't held alongside the contents while they're read
+    std::vector<uint8_t>().swap(compressed);
+
+    if (failed > 0)
+    {
+        DebugLog("ChunkedCompression Error: " + std::to_string(failed.load()) + " chunks of " + fileName + " are damaged");
+        std::string().swap(contents);
+        return false;
+    }
+    return true;
+}
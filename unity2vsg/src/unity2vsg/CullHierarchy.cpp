@@ -0,0 +1,178 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/CullHierarchy.h>
+#include <unity2vsg/SceneBounds.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace
+{
+    struct Item
+    {
+        vsg::ref_ptr<vsg::Node> node;
+        Bounds bounds;
+    };
+
+    class HierarchyBuilder
+    {
+    public:
+        HierarchyBuilder(uint32_t leafSize, const std::set<vsg::GraphicsPipeline*>& blendedPipelines, CullHierarchyStats& stats) :
+            _leafSize(std::max(leafSize, 2u)),
+            _calculator(blendedPipelines),
+            _stats(stats) {}
+
+        // partition the widest groups bottom up, so a group's children are finished before their bounds are used
+        void apply(vsg::Node* node, bool insideBlended)
+        {
+            if (!node) return;
+
+            if (auto lod = dynamic_cast<vsg::LOD*>(node))
+            {
+                for (auto& child : lod->children) apply(child.node, insideBlended);
+                return;
+            }
+            if (auto cullNode = dynamic_cast<vsg::CullNode*>(node))
+            {
+                apply(cullNode->child, insideBlended);
+                return;
+            }
+
+            auto group = dynamic_cast<vsg::Group*>(node);
+            if (!group) return;
+
+            if (auto stategroup = dynamic_cast<vsg::StateGroup*>(node))
+            {
+                for (auto& command : stategroup->stateCommands)
+                {
+                    if (dynamic_cast<vsg::BindGraphicsPipeline*>(command.get())) insideBlended = _calculator.blended(command);
+                }
+
+                // the depth only variant draws the same meshes, so gets its own hierarchy
+                if (auto depthOnly = dynamic_cast<vsg::Node*>(stategroup->getObject("depthOnly"))) apply(depthOnly, insideBlended);
+            }
+
+            for (auto& child : group->children) apply(child, insideBlended);
+
+            // draws under a blended pipeline are in the order they have to be drawn
+            if (!insideBlended && group->children.size() > _leafSize) partition(*group);
+        }
+
+    private:
+        void partition(vsg::Group& group)
+        {
+            std::vector<Item> items;
+            vsg::Group::Children fixed;
+            for (auto& child : group.children)
+            {
+                Item item;
+                item.node = child;
+                if (_calculator.bounds(child, vsg::dmat4(), item.bounds) && item.bounds.valid())
+                    items.push_back(item);
+                else
+                    fixed.push_back(child);
+            }
+            if (items.size() <= _leafSize) return;
+
+            vsg::Group::Children children;
+            children.push_back(build(items, 0, items.size(), 1));
+            children.insert(children.end(), fixed.begin(), fixed.end());
+            group.children = children;
+
+            _stats.groupsPartitioned++;
+        }
+
+        vsg::ref_ptr<vsg::Node> build(std::vector<Item>& items, size_t begin, size_t end, uint32_t depth)
+        {
+            _stats.maxDepth = std::max(_stats.maxDepth, depth);
+
+            Bounds bounds;
+            for (size_t i = begin; i < end; i++) bounds.expand(items[i].bounds);
+
+            auto cullGroup = vsg::CullGroup::create(bounds.sphere());
+            _stats.cullGroupsAdded++;
+
+            size_t count = end - begin;
+            if (count <= _leafSize)
+            {
+                for (size_t i = begin; i < end; i++) cullGroup->addChild(items[i].node);
+                return cullGroup;
+            }
+
+            size_t split = findSplit(items, begin, end);
+            cullGroup->addChild(build(items, begin, split, depth + 1));
+            cullGroup->addChild(build(items, split, end, depth + 1));
+            return cullGroup;
+        }
+
+        // sort the items along the axis and position minimising the surface area heuristic, the cost of a split being the area of
+        // each side weighted by the number of items in it, and return where the second half starts
+        size_t findSplit(std::vector<Item>& items, size_t begin, size_t end)
+        {
+            size_t count = end - begin;
+            std::vector<double> rightAreas(count);
+
+            int bestAxis = -1;
+            size_t bestSplit = count / 2;
+            double bestCost = std::numeric_limits<double>::max();
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                sortAlong(items, begin, end, axis);
+
+                Bounds right;
+                for (size_t i = count; i > 0; i--)
+                {
+                    right.expand(items[begin + i - 1].bounds);
+                    rightAreas[i - 1] = right.surfaceArea();
+                }
+
+                Bounds left;
+                for (size_t i = 1; i < count; i++)
+                {
+                    left.expand(items[begin + i - 1].bounds);
+                    double cost = left.surfaceArea() * static_cast<double>(i) + rightAreas[i] * static_cast<double>(count - i);
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = i;
+                    }
+                }
+            }
+
+            if (bestAxis != 2) sortAlong(items, begin, end, bestAxis < 0 ? 0 : bestAxis);
+            return begin + bestSplit;
+        }
+
+        static void sortAlong(std::vector<Item>& items, size_t begin, size_t end, int axis)
+        {
+            std::stable_sort(items.begin() + begin, items.begin() + end, [axis](const Item& lhs, const Item& rhs) {
+                return lhs.bounds.center(axis) < rhs.bounds.center(axis);
+            });
+        }
+
+        uint32_t _leafSize;
+        BoundsCalculator _calculator;
+        CullHierarchyStats& _stats;
+    };
+} // namespace
+
+void unity2vsg::buildCullHierarchy(vsg::Node* root, uint32_t leafSize, const std::set<vsg::GraphicsPipeline*>& blendedPipelines, CullHierarchyStats& stats)
+{
+    HierarchyBuilder builder(leafSize, blendedPipelines, stats);
+    builder.apply(root, false);
+}
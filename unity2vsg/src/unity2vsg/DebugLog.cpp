@@ -12,12 +12,17 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <unity2vsg/DebugLog.h>
 
+#include <mutex>
+
 using namespace unity2vsg;
 
 StringArgFuncPtr s_DebugLog = nullptr;
 
 void unity2vsg::DebugLog(const std::string& msg)
 {
+    // messages can come from the shader threads, serialise them so the callback is never re-entered
+    static std::mutex s_mutex;
+    std::lock_guard<std::mutex> lock(s_mutex);
     if (s_DebugLog != nullptr) s_DebugLog(msg.c_str());
 }
 
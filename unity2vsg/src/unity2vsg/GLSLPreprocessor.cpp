@@ -0,0 +1,213 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/GLSLPreprocessor.h>
+
+#include <unity2vsg/DebugLog.h>
+
+#include <deque>
+#include <unordered_set>
+
+using namespace unity2vsg;
+
+namespace
+{
+    const std::string_view whitespace = " \t\r";
+
+    std::string_view trim(std::string_view str)
+    {
+        size_t start = str.find_first_not_of(whitespace);
+        if (start == std::string_view::npos) return std::string_view();
+        size_t end = str.find_last_not_of(whitespace);
+        return str.substr(start, end - start + 1);
+    }
+
+    // if str starts with match return the remainder with leading whitespace removed
+    bool consume(std::string_view& str, std::string_view match)
+    {
+        if (str.compare(0, match.size(), match) != 0) return false;
+        str.remove_prefix(match.size());
+        size_t start = str.find_first_not_of(whitespace);
+        str.remove_prefix(start == std::string_view::npos ? str.size() : start);
+        return true;
+    }
+
+    class Preprocessor
+    {
+    public:
+        Preprocessor(const std::vector<std::string>& defines, const GLSLIncludeReader& includeReader, std::vector<std::string>* imported = nullptr) :
+            _requested(defines.begin(), defines.end()),
+            _includeReader(includeReader),
+            _imported(imported)
+        {
+        }
+
+        void process(std::string_view source, const std::string& filename, bool isInclude)
+        {
+            _includeStack.push_back(filename);
+
+            size_t pos = 0;
+            while (pos < source.size())
+            {
+                size_t end = source.find('\n', pos);
+                bool terminated = end != std::string_view::npos;
+                if (!terminated) end = source.size();
+
+                std::string_view line = source.substr(pos, end - pos);
+                std::string_view lineWithEnd = source.substr(pos, terminated ? end - pos + 1 : end - pos);
+                pos = end + 1;
+
+                std::string_view directive = trim(line);
+                if (directive.empty() || directive[0] != '#' || !processDirective(line, directive, filename, isInclude))
+                {
+                    // standard source line, referenced in place rather than copied
+                    appendSource(lineWithEnd);
+                    if (!terminated) appendSource("\n");
+                }
+            }
+
+            _includeStack.pop_back();
+        }
+
+        std::string result() const
+        {
+            std::string output;
+            output.reserve(_header.size() + _sourceSize);
+            output += _header;
+            for (auto& run : _source) output += run;
+            return output;
+        }
+
+    protected:
+        bool processDirective(std::string_view line, std::string_view directive, const std::string& filename, bool isInclude)
+        {
+            directive.remove_prefix(1);
+            directive = trim(directive);
+
+            if (consume(directive, "version"))
+            {
+                // included files don't get to redeclare the version
+                if (!isInclude) appendHeader(line);
+                return true;
+            }
+
+            std::string_view pragma = directive;
+            if (consume(pragma, "pragma") && consume(pragma, "import_defines"))
+            {
+                if (!isInclude) appendHeader(line);
+
+                size_t open = pragma.find('(');
+                size_t close = open == std::string_view::npos ? open : pragma.find(')', open);
+                if (close == std::string_view::npos) return true;
+
+                // insert a define for each imported define that was also requested
+                std::string_view csv = pragma.substr(open + 1, close - open - 1);
+                while (!csv.empty())
+                {
+                    size_t comma = csv.find(',');
+                    std::string_view define = trim(csv.substr(0, comma));
+                    csv.remove_prefix(comma == std::string_view::npos ? csv.size() : comma + 1);
+
+                    if (define.empty()) continue;
+                    if (_imported && _seen.insert(define).second) _imported->emplace_back(define);
+
+                    if (_requested.count(define) == 0 || !_emitted.insert(define).second) continue;
+                    _header.append("#define ");
+                    _header.append(define);
+                    _header.push_back('\n');
+                }
+                return true;
+            }
+
+            if (_includeReader && consume(directive, "include"))
+            {
+                if (directive.size() < 2 || (directive[0] != '"' && directive[0] != '<')) return false;
+
+                size_t close = directive.find(directive[0] == '"' ? '"' : '>', 1);
+                if (close == std::string_view::npos) return false;
+
+                std::string includeName(directive.substr(1, close - 1));
+                size_t slash = filename.find_last_of("/\\");
+                std::string includePath = slash == std::string::npos ? includeName : filename.substr(0, slash + 1) + includeName;
+
+                // skip recursive includes rather than looping forever
+                for (auto& parent : _includeStack)
+                {
+                    if (parent == includePath) return true;
+                }
+
+                // included sources are kept alive as the output references them
+                _includedSources.emplace_back();
+                if (!_includeReader(includePath, _includedSources.back()))
+                {
+                    DebugLog("GLSLPreprocessor Error: Failed to read include '" + includePath + "' from '" + filename + "'");
+                    _includedSources.pop_back();
+                    return true;
+                }
+
+                process(_includedSources.back(), includePath, true);
+                return true;
+            }
+
+            return false;
+        }
+
+        void appendHeader(std::string_view line)
+        {
+            _header.append(line);
+            _header.push_back('\n');
+        }
+
+        void appendSource(std::string_view run)
+        {
+            // neighbouring lines from the same buffer are merged into a single run
+            if (!_source.empty() && _source.back().data() + _source.back().size() == run.data())
+            {
+                _source.back() = std::string_view(_source.back().data(), _source.back().size() + run.size());
+            }
+            else
+            {
+                _source.push_back(run);
+            }
+            _sourceSize += run.size();
+        }
+
+        std::unordered_set<std::string_view> _requested;
+        std::unordered_set<std::string_view> _emitted;
+        const GLSLIncludeReader& _includeReader;
+
+        std::vector<std::string>* _imported;
+        std::unordered_set<std::string_view> _seen;
+
+        std::string _header;
+        std::vector<std::string_view> _source;
+        size_t _sourceSize = 0;
+
+        std::deque<std::string> _includedSources;
+        std::vector<std::string> _includeStack;
+    };
+} // namespace
+
+std::string unity2vsg::preprocessGLSLSource(std::string_view source, const std::vector<std::string>& defines, const std::string& filename, const GLSLIncludeReader& includeReader)
+{
+    Preprocessor preprocessor(defines, includeReader);
+    preprocessor.process(source, filename, false);
+    return preprocessor.result();
+}
+
+std::vector<std::string> unity2vsg::importedGLSLDefines(std::string_view source, const std::string& filename, const GLSLIncludeReader& includeReader)
+{
+    std::vector<std::string> imported;
+    Preprocessor preprocessor(std::vector<std::string>(), includeReader, &imported);
+    preprocessor.process(source, filename, false);
+    return imported;
+}
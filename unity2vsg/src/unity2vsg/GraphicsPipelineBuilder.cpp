@@ -22,24 +22,60 @@ GraphicsPipelineBuilder::GraphicsPipelineBuilder() :
 {
 }
 
+namespace
+{
+    // append the raw bytes of a value to a structural key
+    template<typename T>
+    void appendKey(std::string& key, const T& value)
+    {
+        key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void appendKey(std::string& key, const std::vector<T>& values)
+    {
+        appendKey(key, values.size());
+        if (!values.empty()) key.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    void appendKey(std::string& key, const std::string& value)
+    {
+        appendKey(key, value.size());
+        key.append(value);
+    }
+} // namespace
+
 void GraphicsPipelineBuilder::build(ref_ptr<Traits> traits)
 {
-    // set up graphics pipeline
+    // set up graphics pipeline, every object is keyed on its settings so equivalent traits share objects rather than
+    // creating new ones, and pipelines built from equivalent traits are the same pipeline
 
     // create descriptor layouts
     DescriptorSetLayouts descriptorSetLayouts;
+    std::string layoutKey;
 
     for (auto& bindingSet : traits->descriptorLayouts)
     {
         DescriptorSetLayoutBindings setLayoutBindings;
+        std::string setKey;
         for (auto& stageBindings : bindingSet) // could order of stage type in map be important here??
         {
             for (auto& stageBinding : stageBindings.second)
             {
                 setLayoutBindings.push_back({stageBinding.index, stageBinding.type, stageBinding.count, stageBindings.first, nullptr});
+
+                appendKey(setKey, stageBinding.index);
+                appendKey(setKey, stageBinding.type);
+                appendKey(setKey, stageBinding.count);
+                appendKey(setKey, stageBindings.first);
             }
         }
-        descriptorSetLayouts.push_back(DescriptorSetLayout::create(setLayoutBindings));
+
+        auto& descriptorSetLayout = _descriptorSetLayouts[setKey];
+        if (!descriptorSetLayout) descriptorSetLayout = DescriptorSetLayout::create(setLayoutBindings);
+        descriptorSetLayouts.push_back(descriptorSetLayout);
+
+        appendKey(layoutKey, setKey);
     }
 
     // create vertex bindings and attributes
@@ -75,20 +111,74 @@ void GraphicsPipelineBuilder::build(ref_ptr<Traits> traits)
     //auto shaderStages = ShaderStages::create(traits->shaderModules);
     //shaderStages->setSpecializationInfos(traits->specializationInfos);
 
+    std::string vertexInputKey("vertexInput");
+    appendKey(vertexInputKey, vertexBindingsDescriptions);
+    appendKey(vertexInputKey, vertexAttributeDescriptions);
+
+    std::string inputAssemblyKey("inputAssembly");
+    appendKey(inputAssemblyKey, traits->primitiveTopology);
+
+    std::string colorBlendKey("colorBlend");
+    appendKey(colorBlendKey, traits->colorBlendAttachments);
+
+    std::string rasterizationKey("rasterization");
+    appendKey(rasterizationKey, traits->cullMode);
+
+    std::string depthStencilKey("depthStencil");
+    appendKey(depthStencilKey, traits->depthWrite);
+    appendKey(depthStencilKey, traits->depthCompareOp);
+
     GraphicsPipelineStates pipelineStates{
-        VertexInputState::create(vertexBindingsDescriptions, vertexAttributeDescriptions),
-        InputAssemblyState::create(traits->primitiveTopology),
-        RasterizationState::create(),
-        MultisampleState::create(),
-        traits->colorBlendAttachments.size() > 0 ? ColorBlendState::create(traits->colorBlendAttachments) : ColorBlendState::create(),
-        DepthStencilState::create()};
-
-    PushConstantRanges pushConstantRanges{
-        {VK_SHADER_STAGE_VERTEX_BIT, 0, 128} // projection view, and model matrices
-    };
-
-    auto pipelineLayout = PipelineLayout::create(descriptorSetLayouts, pushConstantRanges);
-    _graphicsPipeline = GraphicsPipeline::create(pipelineLayout, traits->shaderStages, pipelineStates);
+        getOrCreateState(vertexInputKey, [&]() { return VertexInputState::create(vertexBindingsDescriptions, vertexAttributeDescriptions); }),
+        getOrCreateState(inputAssemblyKey, [&]() { return InputAssemblyState::create(traits->primitiveTopology); }),
+        getOrCreateState(rasterizationKey, [&]() {
+            auto rasterizationState = RasterizationState::create();
+            rasterizationState->cullMode = traits->cullMode;
+            return rasterizationState;
+        }),
+        getOrCreateState("multisample", []() { return MultisampleState::create(); }),
+        getOrCreateState(colorBlendKey, [&]() { return traits->colorBlendAttachments.size() > 0 ? ColorBlendState::create(traits->colorBlendAttachments) : ColorBlendState::create(); }),
+        getOrCreateState(depthStencilKey, [&]() {
+            auto depthStencilState = DepthStencilState::create();
+            depthStencilState->depthTestEnable = VK_TRUE;
+            depthStencilState->depthWriteEnable = traits->depthWrite ? VK_TRUE : VK_FALSE;
+            depthStencilState->depthCompareOp = traits->depthCompareOp;
+            return depthStencilState;
+        })};
+
+    appendKey(layoutKey, traits->pushConstantRanges);
+
+    auto& pipelineLayout = _pipelineLayouts[layoutKey];
+    if (!pipelineLayout) pipelineLayout = PipelineLayout::create(descriptorSetLayouts, traits->pushConstantRanges);
+
+    // the shared objects are identified by address, shader stages by their module and specialization values as each
+    // pipeline gets its own stage objects
+    std::string pipelineKey;
+    appendKey(pipelineKey, pipelineLayout.get());
+    for (auto& pipelineState : pipelineStates) appendKey(pipelineKey, pipelineState.get());
+    for (auto& shaderStage : traits->shaderStages)
+    {
+        appendKey(pipelineKey, shaderStage->stage);
+        appendKey(pipelineKey, shaderStage->module.get());
+        appendKey(pipelineKey, shaderStage->entryPointName);
+        for (auto& constant : shaderStage->specializationConstants)
+        {
+            appendKey(pipelineKey, constant.first);
+            if (!constant.second) continue;
+            appendKey(pipelineKey, std::string(static_cast<const char*>(constant.second->dataPointer()), constant.second->dataSize()));
+        }
+    }
+
+    auto& graphicsPipeline = _graphicsPipelines[pipelineKey];
+    if (!graphicsPipeline) graphicsPipeline = GraphicsPipeline::create(pipelineLayout, traits->shaderStages, pipelineStates);
+    _graphicsPipeline = graphicsPipeline;
+}
+
+ref_ptr<GraphicsPipelineState> GraphicsPipelineBuilder::getOrCreateState(const std::string& key, const std::function<ref_ptr<GraphicsPipelineState>()>& create)
+{
+    auto& pipelineState = _pipelineStates[key];
+    if (!pipelineState) pipelineState = create();
+    return pipelineState;
 }
 
 size_t GraphicsPipelineBuilder::sizeOf(VkFormat format)
@@ -0,0 +1,334 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/HierarchicalLOD.h>
+#include <unity2vsg/SceneTiling.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <tuple>
+#include <typeinfo>
+
+using namespace unity2vsg;
+
+namespace
+{
+    struct Triangle
+    {
+        std::array<std::array<double, 3>, 3> corners;
+        uint32_t material;
+    };
+
+    bool readIndex(vsg::Data* indices, size_t i, uint32_t& index)
+    {
+        if (auto ushorts = dynamic_cast<vsg::ushortArray*>(indices))
+        {
+            if (i >= ushorts->size()) return false;
+            index = ushorts->at(i);
+            return true;
+        }
+        if (auto uints = dynamic_cast<vsg::uintArray*>(indices))
+        {
+            if (i >= uints->size()) return false;
+            index = uints->at(i);
+            return true;
+        }
+        return false;
+    }
+
+    // gathers the triangles drawn by a subgraph in the space of its root, along with the palette of material colors they use
+    class TriangleCollector
+    {
+    public:
+        explicit TriangleCollector(const std::map<vsg::Object*, vsg::vec4>& materialColors) :
+            _materialColors(materialColors) {}
+
+        void collect(vsg::Node* node, const vsg::dmat4& matrix, uint32_t material)
+        {
+            if (!node) return;
+
+            if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(node))
+            {
+                if (!vid->arrays.empty() && vid->indices) addTriangles(vid->arrays.front()->data, vid->indices->data, vid->firstIndex, vid->indexCount, vid->vertexOffset, matrix, material);
+                return;
+            }
+
+            if (auto commands = dynamic_cast<vsg::Commands*>(node))
+            {
+                vsg::Data* positions = nullptr;
+                vsg::Data* indices = nullptr;
+                for (auto& command : commands->children)
+                {
+                    material = materialOf(command, material);
+                    if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+                    {
+                        positions = bvb->arrays.empty() ? nullptr : bvb->arrays.front()->data.get();
+                    }
+                    else if (auto bib = dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+                    {
+                        indices = bib->indices ? bib->indices->data.get() : nullptr;
+                    }
+                    else if (auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get()))
+                    {
+                        if (positions && indices) addTriangles(positions, indices, drawIndexed->firstIndex, drawIndexed->indexCount, drawIndexed->vertexOffset, matrix, material);
+                    }
+                }
+                return;
+            }
+
+            // the lowest detail of an lod is closest to what a proxy shows
+            if (auto lod = dynamic_cast<vsg::LOD*>(node))
+            {
+                for (auto itr = lod->children.rbegin(); itr != lod->children.rend(); ++itr)
+                {
+                    if (!itr->node) continue;
+                    collect(itr->node, matrix, material);
+                    break;
+                }
+                return;
+            }
+
+            if (auto cullNode = dynamic_cast<vsg::CullNode*>(node))
+            {
+                collect(cullNode->child, matrix, material);
+                return;
+            }
+
+            auto group = dynamic_cast<vsg::Group*>(node);
+            if (!group) return;
+
+            vsg::dmat4 childMatrix = matrix;
+            if (typeid(*node) == typeid(vsg::MatrixTransform))
+            {
+                childMatrix = matrix * static_cast<vsg::MatrixTransform*>(node)->matrix;
+            }
+            else if (auto stategroup = dynamic_cast<vsg::StateGroup*>(node))
+            {
+                for (auto& command : stategroup->stateCommands) material = materialOf(command, material);
+            }
+
+            for (auto& child : group->children) collect(child, childMatrix, material);
+        }
+
+        // the palette entry of draws with no known material
+        uint32_t defaultMaterial() { return paletteIndex(nullptr, vsg::vec4(1.0f, 1.0f, 1.0f, 1.0f)); }
+
+        std::vector<Triangle> triangles;
+        std::vector<vsg::vec4> palette;
+
+    private:
+        uint32_t materialOf(vsg::Object* command, uint32_t current)
+        {
+            auto itr = _materialColors.find(command);
+            return itr != _materialColors.end() ? paletteIndex(command, itr->second) : current;
+        }
+
+        uint32_t paletteIndex(vsg::Object* material, const vsg::vec4& color)
+        {
+            auto itr = _paletteIndices.find(material);
+            if (itr != _paletteIndices.end()) return itr->second;
+
+            uint32_t index = static_cast<uint32_t>(palette.size());
+            palette.push_back(color);
+            _paletteIndices[material] = index;
+            return index;
+        }
+
+        void addTriangles(vsg::Data* positionData, vsg::Data* indices, uint32_t firstIndex, uint32_t indexCount, int32_t vertexOffset, const vsg::dmat4& matrix, uint32_t material)
+        {
+            auto positions = dynamic_cast<vsg::vec3Array*>(positionData);
+            if (!positions || !indices) return;
+
+            for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+            {
+                Triangle triangle;
+                triangle.material = material;
+
+                bool valid = true;
+                for (uint32_t c = 0; c < 3 && valid; c++)
+                {
+                    uint32_t index = 0;
+                    valid = readIndex(indices, firstIndex + i + c, index);
+                    int64_t vertex = static_cast<int64_t>(index) + vertexOffset;
+                    valid = valid && vertex >= 0 && static_cast<size_t>(vertex) < positions->size();
+                    if (!valid) break;
+
+                    const vsg::vec3& p = positions->at(static_cast<size_t>(vertex));
+                    for (int r = 0; r < 3; r++)
+                    {
+                        triangle.corners[c][r] = matrix[0][r] * p.x + matrix[1][r] * p.y + matrix[2][r] * p.z + matrix[3][r];
+                    }
+                }
+                if (valid) triangles.push_back(triangle);
+            }
+        }
+
+        const std::map<vsg::Object*, vsg::vec4>& _materialColors;
+        std::map<vsg::Object*, uint32_t> _paletteIndices;
+    };
+
+    // simplify by merging the vertices of each material within a cell of a grid over the bounds, triangles left with fewer than
+    // three distinct vertices are dropped along with duplicates
+    vsg::ref_ptr<vsg::Node> createProxy(TriangleCollector& collector, const Bounds& bounds, uint32_t resolution, const HLODInputs& inputs, HLODStats& stats)
+    {
+        double extent = 0.0;
+        for (int axis = 0; axis < 3; axis++) extent = std::max(extent, bounds.max[axis] - bounds.min[axis]);
+        double cellSize = extent > 0.0 ? extent / static_cast<double>(std::max(resolution, 1u)) : 1.0;
+
+        using VertexKey = std::tuple<int64_t, int64_t, int64_t, uint32_t>;
+        std::map<VertexKey, uint32_t> vertexIndices;
+        std::vector<std::array<double, 3>> sums;
+        std::vector<uint32_t> counts;
+        std::vector<uint32_t> materials;
+
+        std::set<std::array<uint32_t, 3>> triangles;
+        std::vector<std::array<uint32_t, 3>> orderedTriangles;
+
+        for (auto& triangle : collector.triangles)
+        {
+            std::array<uint32_t, 3> vertices;
+            for (int c = 0; c < 3; c++)
+            {
+                auto& p = triangle.corners[c];
+                VertexKey key(static_cast<int64_t>(std::floor((p[0] - bounds.min[0]) / cellSize)), static_cast<int64_t>(std::floor((p[1] - bounds.min[1]) / cellSize)),
+                              static_cast<int64_t>(std::floor((p[2] - bounds.min[2]) / cellSize)), triangle.material);
+
+                auto itr = vertexIndices.find(key);
+                if (itr == vertexIndices.end())
+                {
+                    itr = vertexIndices.insert(std::make_pair(key, static_cast<uint32_t>(sums.size()))).first;
+                    sums.push_back({0.0, 0.0, 0.0});
+                    counts.push_back(0);
+                    materials.push_back(triangle.material);
+                }
+
+                vertices[c] = itr->second;
+                for (int r = 0; r < 3; r++) sums[itr->second][r] += p[r];
+                counts[itr->second]++;
+            }
+
+            if (vertices[0] == vertices[1] || vertices[1] == vertices[2] || vertices[2] == vertices[0]) continue;
+
+            // rotate the lowest index first so the same triangle with the same winding is only kept once
+            while (vertices[0] > vertices[1] || vertices[0] > vertices[2]) std::rotate(vertices.begin(), vertices.begin() + 1, vertices.end());
+            if (triangles.insert(vertices).second) orderedTriangles.push_back(vertices);
+        }
+
+        stats.sourceTriangles += collector.triangles.size();
+        if (orderedTriangles.empty()) return {};
+        stats.proxyTriangles += orderedTriangles.size();
+
+        // the atlas holds one texel per material, each proxy vertex samples the center of its material's texel
+        uint32_t atlasSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(collector.palette.size()))));
+        auto atlas = vsg::ubvec4Array2D::create(atlasSize, atlasSize);
+        for (uint32_t i = 0; i < atlasSize * atlasSize; i++)
+        {
+            vsg::vec4 color = i < collector.palette.size() ? collector.palette[i] : vsg::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+            auto toByte = [](float value) { return static_cast<uint8_t>(std::round(std::min(std::max(value, 0.0f), 1.0f) * 255.0f)); };
+            atlas->set(i % atlasSize, i / atlasSize, vsg::ubvec4(toByte(color.x), toByte(color.y), toByte(color.z), toByte(color.w)));
+        }
+
+        size_t vertexCount = sums.size();
+        vsg::ref_ptr<vsg::vec3Array> positions(new vsg::vec3Array(vertexCount));
+        vsg::ref_ptr<vsg::vec3Array> normals(new vsg::vec3Array(vertexCount));
+        vsg::ref_ptr<vsg::vec2Array> texCoords(new vsg::vec2Array(vertexCount));
+
+        std::vector<std::array<double, 3>> normalSums(vertexCount, {0.0, 0.0, 0.0});
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            double count = static_cast<double>(counts[v]);
+            sums[v] = {sums[v][0] / count, sums[v][1] / count, sums[v][2] / count};
+            positions->set(v, vsg::vec3(static_cast<float>(sums[v][0]), static_cast<float>(sums[v][1]), static_cast<float>(sums[v][2])));
+
+            uint32_t material = materials[v];
+            texCoords->set(v, vsg::vec2((static_cast<float>(material % atlasSize) + 0.5f) / static_cast<float>(atlasSize),
+                                        (static_cast<float>(material / atlasSize) + 0.5f) / static_cast<float>(atlasSize)));
+        }
+
+        // area weighted face normals averaged at each vertex
+        vsg::ref_ptr<vsg::uintArray> indices(new vsg::uintArray(orderedTriangles.size() * 3));
+        for (size_t t = 0; t < orderedTriangles.size(); t++)
+        {
+            auto& tri = orderedTriangles[t];
+            auto& a = sums[tri[0]];
+            auto& b = sums[tri[1]];
+            auto& c = sums[tri[2]];
+            double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+
+            for (int corner = 0; corner < 3; corner++)
+            {
+                for (int r = 0; r < 3; r++) normalSums[tri[corner]][r] += n[r];
+                indices->set(t * 3 + corner, tri[corner]);
+            }
+        }
+
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            auto& n = normalSums[v];
+            double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (length > 0.0)
+                normals->set(v, vsg::vec3(static_cast<float>(n[0] / length), static_cast<float>(n[1] / length), static_cast<float>(n[2] / length)));
+            else
+                normals->set(v, vsg::vec3(0.0f, 1.0f, 0.0f));
+        }
+
+        auto draw = vsg::VertexIndexDraw::create();
+        draw->assignArrays(vsg::DataList{positions, normals, texCoords});
+        draw->assignIndices(indices);
+        draw->indexCount = static_cast<uint32_t>(indices->size());
+        draw->instanceCount = 1;
+
+        auto stategroup = inputs.createProxyState(atlas);
+        if (!stategroup) return {};
+        stategroup->addChild(draw);
+        return stategroup;
+    }
+} // namespace
+
+void unity2vsg::buildHierarchicalLODs(vsg::Group* root, double clusterSize, double minimumScreenHeightRatio, uint32_t proxyResolution, const HLODInputs& inputs,
+                                      HLODStats& stats)
+{
+    if (!root || clusterSize <= 0.0 || !inputs.createProxyState) return;
+
+    for (auto& cluster : splitIntoTiles(root, clusterSize, inputs.blendedPipelines, inputs.staticTransforms))
+    {
+        TriangleCollector collector(inputs.materialColors);
+        collector.collect(cluster.root, vsg::dmat4(), collector.defaultMaterial());
+
+        auto proxy = createProxy(collector, cluster.bounds, proxyResolution, inputs, stats);
+        if (!proxy)
+        {
+            // nothing to simplify, the cluster goes back as it was
+            root->addChild(cluster.root);
+            continue;
+        }
+
+        auto lod = vsg::LOD::create();
+        lod->bound = cluster.bounds.sphere();
+
+        vsg::LOD::Child detail;
+        detail.node = cluster.root;
+        detail.minimumScreenHeightRatio = minimumScreenHeightRatio;
+        lod->addChild(detail);
+
+        vsg::LOD::Child proxyChild;
+        proxyChild.node = proxy;
+        proxyChild.minimumScreenHeightRatio = 0.0;
+        lod->addChild(proxyChild);
+
+        root->addChild(lod);
+        stats.clusters++;
+    }
+}
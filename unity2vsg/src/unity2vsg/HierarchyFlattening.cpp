@@ -0,0 +1,498 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/HierarchyFlattening.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <string>
+#include <typeinfo>
+
+using namespace unity2vsg;
+
+namespace
+{
+    bool isIdentity(const vsg::dmat4& matrix)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            for (int r = 0; r < 4; r++)
+            {
+                if (matrix[c][r] != (c == r ? 1.0 : 0.0)) return false;
+            }
+        }
+        return true;
+    }
+
+    // collapses pass through nodes and chained transforms, keeping the set of static transforms in step with the nodes it removes
+    class HierarchyFlattener
+    {
+    public:
+        HierarchyFlattener(std::set<vsg::Node*>& staticTransforms, FlattenStats& stats) :
+            _staticTransforms(staticTransforms),
+            _stats(stats) {}
+
+        vsg::ref_ptr<vsg::Node> flattenNode(vsg::ref_ptr<vsg::Node> node)
+        {
+            if (auto group = dynamic_cast<vsg::Group*>(node.get()))
+            {
+                flattenChildren(*group);
+
+                // a transform whose only child is a transform applies the product of both, as long as both are static or both can move
+                if (typeid(*group) == typeid(vsg::MatrixTransform))
+                {
+                    auto transform = static_cast<vsg::MatrixTransform*>(group);
+                    while (transform->children.size() == 1 && typeid(*transform->children.front()) == typeid(vsg::MatrixTransform) && !transform->children.front()->getAuxiliary() &&
+                           isStatic(transform) == isStatic(transform->children.front()))
+                    {
+                        auto child = static_cast<vsg::MatrixTransform*>(transform->children.front().get());
+                        transform->matrix = transform->matrix * child->matrix;
+                        _staticTransforms.erase(child);
+                        auto grandchildren = child->children;
+                        transform->children = grandchildren;
+                        _stats.transformsMerged++;
+                    }
+                }
+            }
+            else if (auto lod = dynamic_cast<vsg::LOD*>(node.get()))
+            {
+                for (auto& child : lod->children) child.node = flattenSingle(child.node);
+            }
+            else if (auto cullNode = dynamic_cast<vsg::CullNode*>(node.get()))
+            {
+                cullNode->child = flattenSingle(cullNode->child);
+            }
+            return node;
+        }
+
+    private:
+        bool isStatic(vsg::Node* node) const
+        {
+            return _staticTransforms.find(node) != _staticTransforms.end();
+        }
+
+        // a plain group or a static identity transform, nodes that only pass their children on. identity transforms of objects that
+        // can move are kept for the runtime to animate
+        bool isPassThrough(vsg::Node* node) const
+        {
+            if (!node || node->getAuxiliary()) return false;
+            if (typeid(*node) == typeid(vsg::Group)) return true;
+            if (typeid(*node) == typeid(vsg::MatrixTransform)) return isStatic(node) && isIdentity(static_cast<vsg::MatrixTransform*>(node)->matrix);
+            return false;
+        }
+
+        void removed(vsg::Node* node)
+        {
+            if (typeid(*node) == typeid(vsg::Group))
+                _stats.groupsRemoved++;
+            else
+                _stats.transformsRemoved++;
+            _staticTransforms.erase(node);
+        }
+
+        // flatten a child slot that holds one node, pass through nodes can only be removed if they have a single child
+        vsg::ref_ptr<vsg::Node> flattenSingle(vsg::ref_ptr<vsg::Node> node)
+        {
+            if (!node) return node;
+
+            auto flattened = flattenNode(node);
+            while (isPassThrough(flattened) && static_cast<vsg::Group*>(flattened.get())->children.size() == 1)
+            {
+                removed(flattened);
+                flattened = static_cast<vsg::Group*>(flattened.get())->children.front();
+            }
+            return flattened;
+        }
+
+        // flatten the children of a group, pass through children are replaced by their own children
+        void flattenChildren(vsg::Group& group)
+        {
+            vsg::Group::Children children;
+            for (auto& child : group.children)
+            {
+                auto flattened = flattenNode(child);
+                if (isPassThrough(flattened))
+                {
+                    removed(flattened);
+                    auto& grandchildren = static_cast<vsg::Group*>(flattened.get())->children;
+                    children.insert(children.end(), grandchildren.begin(), grandchildren.end());
+                }
+                else
+                {
+                    children.push_back(flattened);
+                }
+            }
+            group.children = children;
+        }
+
+        std::set<vsg::Node*>& _staticTransforms;
+        FlattenStats& _stats;
+    };
+
+    class TransformBaker
+    {
+    public:
+        TransformBaker(const FlattenInputs& inputs, FlattenStats& stats) :
+            _inputs(inputs),
+            _stats(stats) {}
+
+        // bake the topmost static transforms that can be baked
+        void bakeSubgraphs(vsg::Node* node)
+        {
+            if (!node) return;
+
+            if (isStaticTransform(node) && bakeable(node))
+            {
+                bake(vsg::ref_ptr<vsg::Node>(node), vsg::dmat4());
+                return;
+            }
+
+            if (auto group = dynamic_cast<vsg::Group*>(node))
+            {
+                for (auto& child : group->children) bakeSubgraphs(child);
+            }
+            else if (auto lod = dynamic_cast<vsg::LOD*>(node))
+            {
+                for (auto& child : lod->children) bakeSubgraphs(child.node);
+            }
+            else if (auto cullNode = dynamic_cast<vsg::CullNode*>(node))
+            {
+                bakeSubgraphs(cullNode->child);
+            }
+        }
+
+    private:
+        bool isStaticTransform(vsg::Node* node) const
+        {
+            return typeid(*node) == typeid(vsg::MatrixTransform) && _inputs.staticTransforms.find(node) != _inputs.staticTransforms.end();
+        }
+
+        bool bakeablePipeline(vsg::Object* object) const
+        {
+            auto bindPipeline = dynamic_cast<vsg::BindGraphicsPipeline*>(object);
+            return !bindPipeline || _inputs.unbakeablePipelines.find(bindPipeline->pipeline.get()) == _inputs.unbakeablePipelines.end();
+        }
+
+        // every transform in the subgraph is static, no pipeline depends on the model matrix and every node is one baking understands
+        bool bakeable(vsg::Node* node) const
+        {
+            if (!node) return true;
+
+            if (dynamic_cast<vsg::VertexIndexDraw*>(node)) return true;
+
+            if (auto commands = dynamic_cast<vsg::Commands*>(node))
+            {
+                for (auto& command : commands->children)
+                {
+                    if (!bakeablePipeline(command)) return false;
+                }
+                return true;
+            }
+
+            if (auto lod = dynamic_cast<vsg::LOD*>(node))
+            {
+                for (auto& child : lod->children)
+                {
+                    if (!bakeable(child.node)) return false;
+                }
+                return true;
+            }
+
+            if (auto cullNode = dynamic_cast<vsg::CullNode*>(node)) return bakeable(cullNode->child);
+
+            auto group = dynamic_cast<vsg::Group*>(node);
+            if (!group) return false;
+
+            if (typeid(*node) == typeid(vsg::MatrixTransform))
+            {
+                if (!isStaticTransform(node)) return false;
+            }
+            else if (auto stategroup = dynamic_cast<vsg::StateGroup*>(node))
+            {
+                for (auto& command : stategroup->stateCommands)
+                {
+                    if (!bakeablePipeline(command)) return false;
+                }
+            }
+            else if (typeid(*node) != typeid(vsg::Group) && typeid(*node) != typeid(vsg::CullGroup))
+            {
+                return false;
+            }
+
+            for (auto& child : group->children)
+            {
+                if (!bakeable(child)) return false;
+            }
+            return true;
+        }
+
+        // bake the transform above a node into it, returning the node to put in its place
+        vsg::ref_ptr<vsg::Node> bake(vsg::ref_ptr<vsg::Node> node, const vsg::dmat4& matrix)
+        {
+            if (!node) return node;
+
+            if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(node.get())) return bakeVertexIndexDraw(vid, matrix);
+
+            if (auto commands = dynamic_cast<vsg::Commands*>(node.get()))
+            {
+                for (auto& command : commands->children) command = bakeCommand(command, matrix);
+                return node;
+            }
+
+            if (auto lod = dynamic_cast<vsg::LOD*>(node.get()))
+            {
+                lod->bound = transformBound(lod->bound, matrix);
+                for (auto& child : lod->children) child.node = bake(child.node, matrix);
+                return node;
+            }
+
+            if (auto cullNode = dynamic_cast<vsg::CullNode*>(node.get()))
+            {
+                cullNode->bound = transformBound(cullNode->bound, matrix);
+                cullNode->child = bake(cullNode->child, matrix);
+                return node;
+            }
+
+            vsg::dmat4 childMatrix = matrix;
+            if (typeid(*node) == typeid(vsg::MatrixTransform))
+            {
+                auto transform = static_cast<vsg::MatrixTransform*>(node.get());
+                childMatrix = matrix * transform->matrix;
+                transform->matrix = vsg::dmat4();
+                _stats.transformsBaked++;
+            }
+            else if (auto cullGroup = dynamic_cast<vsg::CullGroup*>(node.get()))
+            {
+                cullGroup->bound = transformBound(cullGroup->bound, matrix);
+            }
+            else if (auto stategroup = dynamic_cast<vsg::StateGroup*>(node.get()))
+            {
+                // the depth only variant draws the same meshes so is baked the same way
+                if (auto depthOnly = dynamic_cast<vsg::Node*>(stategroup->getObject("depthOnly"))) bake(vsg::ref_ptr<vsg::Node>(depthOnly), childMatrix);
+            }
+
+            if (auto group = dynamic_cast<vsg::Group*>(node.get()))
+            {
+                for (auto& child : group->children) child = bake(child, childMatrix);
+            }
+            return node;
+        }
+
+        vsg::ref_ptr<vsg::Node> bakeVertexIndexDraw(vsg::VertexIndexDraw* vid, const vsg::dmat4& matrix)
+        {
+            auto& baked = _bakedNodes[std::make_pair(static_cast<vsg::Object*>(vid), matrixKey(matrix))];
+            if (baked) return baked;
+
+            vsg::DataList arrays;
+            for (auto& array : vid->arrays) arrays.push_back(bakeArray(array->data, matrix, arrays.empty()));
+
+            auto bakedDraw = vsg::VertexIndexDraw::create();
+            bakedDraw->assignArrays(arrays);
+            if (vid->indices) bakedDraw->assignIndices(orientIndices(vid->indices->data, matrix));
+            bakedDraw->indexCount = vid->indexCount;
+            bakedDraw->instanceCount = vid->instanceCount;
+
+            baked = bakedDraw;
+            return baked;
+        }
+
+        vsg::ref_ptr<vsg::Command> bakeCommand(vsg::ref_ptr<vsg::Command> command, const vsg::dmat4& matrix)
+        {
+            if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+            {
+                auto& baked = _bakedCommands[std::make_pair(static_cast<vsg::Object*>(bvb), matrixKey(matrix))];
+                if (!baked)
+                {
+                    vsg::DataList arrays;
+                    for (auto& array : bvb->arrays) arrays.push_back(bakeArray(array->data, matrix, arrays.empty()));
+                    baked = vsg::BindVertexBuffers::create(0, arrays);
+                }
+                return baked;
+            }
+
+            if (auto bib = dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+            {
+                if (determinant(matrix) >= 0.0 || !bib->indices) return command;
+
+                auto& flipped = _flippedCommands[bib];
+                if (!flipped) flipped = vsg::BindIndexBuffer::create(orientIndices(bib->indices->data, matrix));
+                return flipped;
+            }
+
+            return command;
+        }
+
+        // positions are transformed, normals by the inverse transpose and tangents by the matrix keeping their handedness. other
+        // arrays are shared with the unbaked draws
+        vsg::ref_ptr<vsg::Data> bakeArray(vsg::ref_ptr<vsg::Data> data, const vsg::dmat4& matrix, bool positions)
+        {
+            bool normals = _inputs.normalArrays.find(data.get()) != _inputs.normalArrays.end();
+            bool tangents = _inputs.tangentArrays.find(data.get()) != _inputs.tangentArrays.end();
+            if (!positions && !normals && !tangents) return data;
+
+            auto& baked = _bakedArrays[std::make_pair(static_cast<vsg::Object*>(data.get()), matrixKey(matrix))];
+            if (baked) return baked;
+            baked = data;
+
+            double det = determinant(matrix);
+            double sign = det < 0.0 ? -1.0 : 1.0;
+
+            if (auto vec3s = dynamic_cast<vsg::vec3Array*>(data.get()))
+            {
+                vsg::ref_ptr<vsg::vec3Array> bakedVec3s(new vsg::vec3Array(vec3s->size()));
+                for (size_t i = 0; i < vec3s->size(); i++)
+                {
+                    const vsg::vec3& v = vec3s->at(i);
+                    double x, y, z;
+                    if (positions)
+                    {
+                        x = matrix[0][0] * v.x + matrix[1][0] * v.y + matrix[2][0] * v.z + matrix[3][0];
+                        y = matrix[0][1] * v.x + matrix[1][1] * v.y + matrix[2][1] * v.z + matrix[3][1];
+                        z = matrix[0][2] * v.x + matrix[1][2] * v.y + matrix[2][2] * v.z + matrix[3][2];
+                    }
+                    else
+                    {
+                        // the cofactor matrix is the inverse transpose scaled by the determinant
+                        x = sign * (cofactor(matrix, 0, 0) * v.x + cofactor(matrix, 0, 1) * v.y + cofactor(matrix, 0, 2) * v.z);
+                        y = sign * (cofactor(matrix, 1, 0) * v.x + cofactor(matrix, 1, 1) * v.y + cofactor(matrix, 1, 2) * v.z);
+                        z = sign * (cofactor(matrix, 2, 0) * v.x + cofactor(matrix, 2, 1) * v.y + cofactor(matrix, 2, 2) * v.z);
+                        normalize(x, y, z);
+                    }
+                    bakedVec3s->set(i, vsg::vec3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)));
+                }
+                baked = bakedVec3s;
+            }
+            else if (auto vec4s = dynamic_cast<vsg::vec4Array*>(data.get()))
+            {
+                vsg::ref_ptr<vsg::vec4Array> bakedVec4s(new vsg::vec4Array(vec4s->size()));
+                for (size_t i = 0; i < vec4s->size(); i++)
+                {
+                    const vsg::vec4& v = vec4s->at(i);
+                    double x = matrix[0][0] * v.x + matrix[1][0] * v.y + matrix[2][0] * v.z;
+                    double y = matrix[0][1] * v.x + matrix[1][1] * v.y + matrix[2][1] * v.z;
+                    double z = matrix[0][2] * v.x + matrix[1][2] * v.y + matrix[2][2] * v.z;
+                    normalize(x, y, z);
+                    bakedVec4s->set(i, vsg::vec4(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z), static_cast<float>(sign * v.w)));
+                }
+                baked = bakedVec4s;
+            }
+            return baked;
+        }
+
+        // mirroring transforms reverse the winding of the baked triangles, so their indices are flipped back
+        vsg::ref_ptr<vsg::Data> orientIndices(vsg::ref_ptr<vsg::Data> indices, const vsg::dmat4& matrix)
+        {
+            if (!indices || determinant(matrix) >= 0.0) return indices;
+
+            auto& flipped = _flippedIndices[indices.get()];
+            if (flipped) return flipped;
+
+            if (auto ushorts = dynamic_cast<vsg::ushortArray*>(indices.get()))
+                flipped = flipTriangles(ushorts);
+            else if (auto uints = dynamic_cast<vsg::uintArray*>(indices.get()))
+                flipped = flipTriangles(uints);
+            else
+                flipped = indices;
+            return flipped;
+        }
+
+        template<class A>
+        vsg::ref_ptr<vsg::Data> flipTriangles(A* indices)
+        {
+            vsg::ref_ptr<A> flipped(new A(indices->size()));
+            for (size_t i = 0; i < indices->size(); i++) flipped->set(i, indices->at(i));
+            for (size_t i = 0; i + 2 < indices->size(); i += 3)
+            {
+                flipped->set(i + 1, indices->at(i + 2));
+                flipped->set(i + 2, indices->at(i + 1));
+            }
+            return flipped;
+        }
+
+        vsg::dsphere transformBound(const vsg::dsphere& bound, const vsg::dmat4& matrix) const
+        {
+            vsg::dsphere transformed;
+            for (int r = 0; r < 3; r++)
+            {
+                transformed.center[r] = matrix[0][r] * bound.center.x + matrix[1][r] * bound.center.y + matrix[2][r] * bound.center.z + matrix[3][r];
+            }
+
+            double maxScale = 0.0;
+            for (int c = 0; c < 3; c++)
+            {
+                maxScale = std::max(maxScale, std::sqrt(matrix[c][0] * matrix[c][0] + matrix[c][1] * matrix[c][1] + matrix[c][2] * matrix[c][2]));
+            }
+            transformed.radius = bound.radius * maxScale;
+            return transformed;
+        }
+
+        // cofactor of the upper 3x3 of the matrix at row r and column c, the matrix is indexed column first
+        static double cofactor(const vsg::dmat4& matrix, int r, int c)
+        {
+            int r0 = (r + 1) % 3, r1 = (r + 2) % 3;
+            int c0 = (c + 1) % 3, c1 = (c + 2) % 3;
+            return matrix[c0][r0] * matrix[c1][r1] - matrix[c1][r0] * matrix[c0][r1];
+        }
+
+        static double determinant(const vsg::dmat4& matrix)
+        {
+            return matrix[0][0] * cofactor(matrix, 0, 0) + matrix[1][0] * cofactor(matrix, 0, 1) + matrix[2][0] * cofactor(matrix, 0, 2);
+        }
+
+        static void normalize(double& x, double& y, double& z)
+        {
+            double length = std::sqrt(x * x + y * y + z * z);
+            if (length <= 0.0) return;
+            x /= length;
+            y /= length;
+            z /= length;
+        }
+
+        static std::string matrixKey(const vsg::dmat4& matrix)
+        {
+            std::string key(sizeof(double) * 16, '\0');
+            for (int c = 0; c < 4; c++)
+            {
+                for (int r = 0; r < 4; r++)
+                {
+                    double value = matrix[c][r];
+                    std::memcpy(&key[(c * 4 + r) * sizeof(double)], &value, sizeof(double));
+                }
+            }
+            return key;
+        }
+
+        const FlattenInputs& _inputs;
+        FlattenStats& _stats;
+
+        // baked copies keyed on the original and the matrix baked into them, so meshes shared under one transform stay shared
+        std::map<std::pair<vsg::Object*, std::string>, vsg::ref_ptr<vsg::Node>> _bakedNodes;
+        std::map<std::pair<vsg::Object*, std::string>, vsg::ref_ptr<vsg::Command>> _bakedCommands;
+        std::map<std::pair<vsg::Object*, std::string>, vsg::ref_ptr<vsg::Data>> _bakedArrays;
+        std::map<vsg::Data*, vsg::ref_ptr<vsg::Data>> _flippedIndices;
+        std::map<vsg::Object*, vsg::ref_ptr<vsg::Command>> _flippedCommands;
+    };
+} // namespace
+
+void unity2vsg::flattenHierarchy(vsg::Node* root, std::set<vsg::Node*>& staticTransforms, FlattenStats& stats)
+{
+    HierarchyFlattener flattener(staticTransforms, stats);
+    flattener.flattenNode(vsg::ref_ptr<vsg::Node>(root));
+}
+
+void unity2vsg::bakeStaticTransforms(vsg::Node* root, const FlattenInputs& inputs, FlattenStats& stats)
+{
+    TransformBaker baker(inputs, stats);
+    baker.bakeSubgraphs(root);
+}
@@ -0,0 +1,536 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/LeafStream.h>
+
+#include <unity2vsg/DebugLog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <typeinfo>
+
+#if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    define NOMINMAX
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace unity2vsg;
+
+namespace
+{
+    // leaf file layout
+    //   LeafFileHeader, padded to pageSize
+    //   the values of each array, arrays of pageSize bytes or more start on a page boundary and the rest on a valueAlignment boundary
+    //   LeafArrayEntry arrays[arrayCount] at indexOffset, in the order of the scene's "leaves" objects
+    struct LeafFileHeader
+    {
+        char magic[8] = {'v', 's', 'g', 'l', 'e', 'a', 'f', 's'};
+        uint32_t version = 2;
+        uint32_t arrayCount = 0;
+        uint64_t indexOffset = 0;
+    };
+
+    constexpr uint64_t pageSize = 4096;
+    constexpr uint64_t valueAlignment = 64;
+    const char padding[pageSize] = {};
+
+    // the array types an export creates, arrays of any other type are left in the scene
+    template<class... A>
+    struct ArrayTypes
+    {
+    };
+
+    using LeafArrayTypes = ArrayTypes<vsg::floatArray, vsg::vec2Array, vsg::vec3Array, vsg::vec4Array, vsg::ubyteArray, vsg::ushortArray, vsg::uintArray,
+                                      vsg::floatArray2D, vsg::vec2Array2D, vsg::vec4Array2D, vsg::ubyteArray2D, vsg::ubvec2Array2D, vsg::ubvec3Array2D,
+                                      vsg::ubvec4Array2D, vsg::ushortArray2D, vsg::usvec2Array2D, vsg::usvec4Array2D, vsg::uintArray2D, vsg::uivec2Array2D,
+                                      vsg::uivec4Array2D, vsg::block64Array2D, vsg::block128Array2D, vsg::ubyteArray3D, vsg::ubvec2Array3D, vsg::ubvec4Array3D>;
+
+    // call function with data cast to its type, false if it isn't one of types
+    template<class... A, class F>
+    bool applyTyped(vsg::Data& data, ArrayTypes<A...>, F function)
+    {
+        bool applied = false;
+        ((typeid(data) == typeid(A) && (applied = function(static_cast<A&>(data)), true)) || ...);
+        return applied;
+    }
+
+    template<class... A>
+    vsg::ref_ptr<vsg::Data> createPlaceholder(const vsg::Data& data, ArrayTypes<A...>)
+    {
+        vsg::ref_ptr<vsg::Data> placeholder;
+        ((typeid(data) == typeid(A) && (placeholder = A::create(), true)) || ...);
+        return placeholder;
+    }
+
+    template<typename T>
+    void assignValues(vsg::Array<T>& array, const LeafArrayEntry& entry, T* values)
+    {
+        array.assign(entry.width, values, array.getLayout());
+    }
+
+    template<typename T>
+    void assignValues(vsg::Array2D<T>& array, const LeafArrayEntry& entry, T* values)
+    {
+        array.assign(entry.width, entry.height, values, array.getLayout());
+    }
+
+    template<typename T>
+    void assignValues(vsg::Array3D<T>& array, const LeafArrayEntry& entry, T* values)
+    {
+        array.assign(entry.width, entry.height, entry.depth, values, array.getLayout());
+    }
+
+    template<class A>
+    bool matches(const LeafArrayEntry& entry)
+    {
+        using value_type = typename A::value_type;
+        uint64_t count = static_cast<uint64_t>(entry.width) * entry.height * entry.depth;
+        return entry.valueSize == sizeof(value_type) && entry.byteSize == count * sizeof(value_type);
+    }
+
+    template<class A>
+    bool readValues(A& array, const LeafArrayEntry& entry, std::istream& in)
+    {
+        using value_type = typename A::value_type;
+        if (!matches<A>(entry)) return false;
+
+        auto values = new value_type[entry.byteSize / sizeof(value_type)];
+        in.seekg(static_cast<std::streamoff>(entry.offset));
+        if (!in.read(reinterpret_cast<char*>(values), static_cast<std::streamsize>(entry.byteSize)))
+        {
+            delete[] values;
+            return false;
+        }
+
+        assignValues(array, entry, values);
+        return true;
+    }
+
+    template<class A>
+    bool mapValues(A& array, const LeafArrayEntry& entry, uint8_t* mapping, uint64_t mappingSize)
+    {
+        using value_type = typename A::value_type;
+        if (!matches<A>(entry) || entry.offset > mappingSize || entry.byteSize > mappingSize - entry.offset || entry.offset % alignof(value_type) != 0) return false;
+
+        assignValues(array, entry, reinterpret_cast<value_type*>(mapping + entry.offset));
+        return true;
+    }
+
+    // false if header isn't of a leaf file holding arrayCount arrays and an index that fits in fileSize
+    bool checkHeader(const LeafFileHeader& header, size_t arrayCount, uint64_t fileSize)
+    {
+        LeafFileHeader expected;
+        return std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 && header.version == expected.version && header.arrayCount == arrayCount &&
+               header.indexOffset <= fileSize && static_cast<uint64_t>(header.arrayCount) * sizeof(LeafArrayEntry) <= fileSize - header.indexOffset;
+    }
+
+    vsg::ref_ptr<vsg::Data> getData(vsg::ref_ptr<vsg::ImageInfo>& imageInfo)
+    {
+        if (imageInfo->imageView && imageInfo->imageView->image) return imageInfo->imageView->image->data;
+        else return {};
+    }
+} // namespace
+
+// visits the slots of a subgraph that hold leaf data, swapping each array for its placeholder
+class LeafStreamWriter::Streamer : public vsg::Visitor
+{
+public:
+    Streamer(LeafStreamWriter& writer, bool keepGeometry, bool revisit) :
+        _writer(writer),
+        _keepGeometry(keepGeometry),
+        _revisit(revisit)
+    {
+    }
+
+    Replacements replacements;
+
+    void apply(vsg::Object& object) override
+    {
+        if (typeid(object) == typeid(vsg::DescriptorImage))
+        {
+            vsg::DescriptorImage* texture = static_cast<vsg::DescriptorImage*>(&object);
+            for (auto& imageInfo : texture->imageInfoList)
+            {
+                if (auto data = getData(imageInfo)) imageInfo->imageView->image->data = replace(data);
+            }
+        }
+
+        auto node = dynamic_cast<vsg::Node*>(&object);
+        if (node && !enter(node)) return;
+
+        object.traverse(*this);
+    }
+
+    void apply(vsg::Geometry& geometry) override
+    {
+        for (auto& array : geometry.arrays) replace(array, &array == &geometry.arrays.front());
+        if (geometry.indices) replace(geometry.indices, true);
+    }
+
+    void apply(vsg::VertexIndexDraw& vid) override
+    {
+        for (auto& array : vid.arrays) replace(array, &array == &vid.arrays.front());
+        if (vid.indices) replace(vid.indices, true);
+    }
+
+    void apply(vsg::BindVertexBuffers& bvb) override
+    {
+        for (auto& array : bvb.arrays) replace(array, &array == &bvb.arrays.front());
+    }
+
+    void apply(vsg::BindIndexBuffer& bib) override
+    {
+        if (bib.indices) replace(bib.indices, true);
+    }
+
+    void apply(vsg::StateGroup& stategroup) override
+    {
+        if (!enter(&stategroup)) return;
+
+        for (auto& command : stategroup.stateCommands)
+        {
+            command->accept(*this);
+        }
+
+        // the depth only twin of a stategroup isn't one of its children
+        if (auto depthOnly = dynamic_cast<vsg::Node*>(stategroup.getObject("depthOnly"))) depthOnly->accept(*this);
+
+        stategroup.traverse(*this);
+    }
+
+protected:
+    // false if the node was streamed by an earlier pass, nodes aren't changed once closed so there's nothing new below it
+    bool enter(vsg::Node* node)
+    {
+        if (_revisit) return true;
+        return _writer._streamedNodes.insert(node).second;
+    }
+
+    vsg::ref_ptr<vsg::Data> replace(vsg::ref_ptr<vsg::Data> data)
+    {
+        return _writer.replace(data, replacements);
+    }
+
+    void replace(vsg::ref_ptr<vsg::BufferInfo>& bufferInfo, bool geometry)
+    {
+        if (!bufferInfo->data || (geometry && _keepGeometry)) return;
+        bufferInfo->data = replace(bufferInfo->data);
+    }
+
+    LeafStreamWriter& _writer;
+    bool _keepGeometry;
+    bool _revisit;
+};
+
+LeafStreamWriter::LeafStreamWriter()
+{
+    std::error_code ec;
+    auto directory = std::filesystem::temp_directory_path(ec);
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    _fileName = (directory / ("unity2vsg-" + std::to_string(stamp) + ".vsgl")).string();
+
+    _file.open(_fileName, std::ios::binary | std::ios::trunc);
+    if (!_file)
+    {
+        DebugLog("LeafStream Error: Unable to open " + _fileName + " to stream leaf data to");
+        return;
+    }
+
+    LeafFileHeader header;
+    _file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    _file.write(padding, pageSize - sizeof(header));
+    _bytesWritten = pageSize;
+}
+
+LeafStreamWriter::~LeafStreamWriter()
+{
+    // an export that never finished leaves nothing behind
+    if (_file.is_open())
+    {
+        _file.close();
+        std::error_code ec;
+        std::filesystem::remove(_fileName, ec);
+    }
+}
+
+std::string LeafStreamWriter::leafFileName(const std::string& sceneFileName)
+{
+    auto ext = sceneFileName.find_last_of('.');
+    auto sep = sceneFileName.find_last_of("/\\");
+    if (ext == std::string::npos || (sep != std::string::npos && ext < sep)) return sceneFileName + ".vsgl";
+    return sceneFileName.substr(0, ext) + ".vsgl";
+}
+
+vsg::ref_ptr<vsg::Data> LeafStreamWriter::replace(vsg::ref_ptr<vsg::Data> original, Replacements& replacements)
+{
+    if (!valid() || _placeholderSet.count(original.get()) > 0) return original;
+
+    auto written = _written.find(original.get());
+    if (written != _written.end()) return written->second.second;
+
+    auto placeholder = createPlaceholder(*original, LeafArrayTypes{});
+    if (!placeholder) return original;
+
+    LeafArrayEntry entry;
+    entry.byteSize = original->dataSize();
+    entry.width = original->width();
+    entry.height = original->height();
+    entry.depth = original->depth();
+    entry.valueSize = static_cast<uint32_t>(original->valueSize());
+
+    uint64_t alignment = entry.byteSize >= pageSize ? pageSize : valueAlignment;
+    uint64_t paddingSize = (alignment - _bytesWritten % alignment) % alignment;
+    entry.offset = _bytesWritten + paddingSize;
+
+    _file.write(padding, static_cast<std::streamsize>(paddingSize));
+    _file.write(static_cast<const char*>(original->dataPointer()), static_cast<std::streamsize>(entry.byteSize));
+    if (!_file)
+    {
+        DebugLog("LeafStream Error: Failed writing to " + _fileName + ", the rest of the leaf data stays in the scene");
+        return original;
+    }
+
+    // the virtual texture of a mip tail is what a runtime streams the rest of the texture with
+    placeholder->setLayout(original->getLayout());
+    if (auto virtualTexture = original->getObject("virtualTexture")) placeholder->setObject("virtualTexture", vsg::ref_ptr<vsg::Object>(virtualTexture));
+
+    _entries.push_back(entry);
+    _bytesWritten = entry.offset + entry.byteSize;
+    _bytesPadded += paddingSize;
+    _placeholders.push_back(placeholder);
+    _placeholderSet.insert(placeholder.get());
+    _written[original.get()] = std::make_pair(original, placeholder);
+    replacements.emplace_back(original, placeholder);
+    return placeholder;
+}
+
+LeafStreamWriter::Replacements LeafStreamWriter::stream(vsg::Node* node, bool keepGeometry)
+{
+    // originals no longer referenced by anything but this writer are freed
+    for (auto itr = _written.begin(); itr != _written.end();)
+    {
+        if (itr->second.first->referenceCount() == 1) itr = _written.erase(itr);
+        else ++itr;
+    }
+
+    Streamer streamer(*this, keepGeometry, false);
+    node->accept(streamer);
+    return streamer.replacements;
+}
+
+LeafStreamWriter::Replacements LeafStreamWriter::finish(vsg::Object* root, const std::string& sceneFileName)
+{
+    // passes run at the end of the export restructure closed subgraphs and add data of their own, so everything is visited again
+    Streamer streamer(*this, false, true);
+    root->accept(streamer);
+
+    _written.clear();
+    _streamedNodes.clear();
+
+    if (!valid()) return streamer.replacements;
+
+    uint64_t paddingSize = (alignof(LeafArrayEntry) - _bytesWritten % alignof(LeafArrayEntry)) % alignof(LeafArrayEntry);
+    _file.write(padding, static_cast<std::streamsize>(paddingSize));
+
+    LeafFileHeader header;
+    header.arrayCount = static_cast<uint32_t>(_entries.size());
+    header.indexOffset = _bytesWritten + paddingSize;
+
+    _file.write(reinterpret_cast<const char*>(_entries.data()), static_cast<std::streamsize>(_entries.size() * sizeof(LeafArrayEntry)));
+    _file.seekp(0);
+    _file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    _file.close();
+    if (!_file)
+    {
+        DebugLog("LeafStream Error: Failed writing the index of " + _fileName);
+        return streamer.replacements;
+    }
+
+    // the temporary file may be on another volume than the scene
+    auto fileName = leafFileName(sceneFileName);
+    std::error_code ec;
+    std::filesystem::rename(_fileName, fileName, ec);
+    if (ec)
+    {
+        ec.clear();
+        std::filesystem::copy_file(_fileName, fileName, std::filesystem::copy_options::overwrite_existing, ec);
+        std::error_code removeError;
+        std::filesystem::remove(_fileName, removeError);
+        if (ec) DebugLog("LeafStream Error: Unable to move the leaf data to " + fileName + ", " + ec.message());
+    }
+
+    auto leaves = vsg::Objects::create();
+    for (auto& placeholder : _placeholders) leaves->addChild(placeholder);
+    root->setObject("leaves", leaves);
+
+    return streamer.replacements;
+}
+
+bool unity2vsg::readStreamedLeafData(vsg::Object* scene, const std::string& sceneFileName)
+{
+    auto leaves = dynamic_cast<vsg::Objects*>(scene->getObject("leaves"));
+    if (!leaves) return true;
+
+    auto fileName = LeafStreamWriter::leafFileName(sceneFileName);
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    auto fileSize = static_cast<uint64_t>(std::max<std::streamoff>(file.tellg(), 0));
+    file.seekg(0);
+
+    LeafFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !checkHeader(header, leaves->children.size(), fileSize))
+    {
+        DebugLog("LeafStream Error: " + fileName + " is missing or doesn't match the scene");
+        return false;
+    }
+
+    std::vector<LeafArrayEntry> entries(header.arrayCount);
+    file.seekg(static_cast<std::streamoff>(header.indexOffset));
+    if (!file.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(LeafArrayEntry))))
+    {
+        DebugLog("LeafStream Error: Unable to read the index of " + fileName);
+        return false;
+    }
+
+    uint32_t failed = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        auto placeholder = dynamic_cast<vsg::Data*>(leaves->children[i].get());
+        if (!placeholder || !applyTyped(*placeholder, LeafArrayTypes{}, [&](auto& array) { return readValues(array, entries[i], file); }))
+        {
+            file.clear();
+            ++failed;
+        }
+    }
+
+    if (failed > 0) DebugLog("LeafStream Error: Unable to read " + std::to_string(failed) + " of " + std::to_string(entries.size()) + " arrays from " + fileName);
+    return failed == 0;
+}
+
+MappedLeafData::MappedLeafData(vsg::Object* scene, const std::string& sceneFileName)
+{
+    auto leaves = dynamic_cast<vsg::Objects*>(scene->getObject("leaves"));
+    if (!leaves) return;
+
+    auto fileName = LeafStreamWriter::leafFileName(sceneFileName);
+
+    // mapped copy on write, so anything modifying the arrays in place doesn't write to the file
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER size;
+        HANDLE fileMapping = GetFileSizeEx(file, &size) && size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr) : nullptr;
+        if (fileMapping)
+        {
+            _mapping = static_cast<uint8_t*>(MapViewOfFile(fileMapping, FILE_MAP_COPY, 0, 0, 0));
+            _size = static_cast<uint64_t>(size.QuadPart);
+            CloseHandle(fileMapping);
+        }
+        CloseHandle(file);
+    }
+#else
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file >= 0)
+    {
+        struct stat status;
+        if (fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            void* mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+            if (mapping != MAP_FAILED)
+            {
+                _mapping = static_cast<uint8_t*>(mapping);
+                _size = static_cast<uint64_t>(status.st_size);
+            }
+        }
+        close(file);
+    }
+#endif
+
+    LeafFileHeader header;
+    if (_mapping && _size >= sizeof(header)) std::memcpy(&header, _mapping, sizeof(header));
+    if (!_mapping || _size < sizeof(header) || !checkHeader(header, leaves->children.size(), _size))
+    {
+        DebugLog("LeafStream Error: Unable to map " + fileName + " or it doesn't match the scene");
+        unmap();
+        return;
+    }
+
+    std::vector<LeafArrayEntry> entries(header.arrayCount);
+    std::memcpy(entries.data(), _mapping + header.indexOffset, entries.size() * sizeof(LeafArrayEntry));
+
+    // arrays that can't be mapped, such as ones not aligned for their values, are read into copies instead
+    std::ifstream leafFile;
+    uint32_t copied = 0;
+    uint32_t failed = 0;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        auto placeholder = dynamic_cast<vsg::Data*>(leaves->children[i].get());
+        if (!placeholder)
+        {
+            ++failed;
+        }
+        else if (applyTyped(*placeholder, LeafArrayTypes{}, [&](auto& array) { return mapValues(array, entries[i], _mapping, _size); }))
+        {
+            _arrays.emplace_back(placeholder);
+        }
+        else
+        {
+            if (!leafFile.is_open()) leafFile.open(fileName, std::ios::binary);
+            if (applyTyped(*placeholder, LeafArrayTypes{}, [&](auto& array) { return readValues(array, entries[i], leafFile); }))
+            {
+                ++copied;
+            }
+            else
+            {
+                leafFile.clear();
+                ++failed;
+            }
+        }
+    }
+
+    if (copied > 0) DebugLog("LeafStream: Read copies of " + std::to_string(copied) + " of " + std::to_string(entries.size()) + " arrays from " + fileName + " that couldn't be mapped");
+    if (failed > 0) DebugLog("LeafStream Error: Unable to map or read " + std::to_string(failed) + " of " + std::to_string(entries.size()) + " arrays from " + fileName);
+}
+
+MappedLeafData::~MappedLeafData()
+{
+    unmap();
+}
+
+void MappedLeafData::unmap()
+{
+    // arrays still pointing into the mapping let go of it rather than freeing it
+    for (auto& array : _arrays)
+    {
+        auto values = static_cast<uint8_t*>(array->dataPointer());
+        if (values >= _mapping && values < _mapping + _size) array->dataRelease();
+    }
+    _arrays.clear();
+
+    if (!_mapping) return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(_mapping);
+#else
+    munmap(_mapping, static_cast<size_t>(_size));
+#endif
+    _mapping = nullptr;
+    _size = 0;
+}
@@ -0,0 +1,783 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/PotentiallyVisibleSet.h>
+#include <unity2vsg/SceneBounds.h>
+#include <unity2vsg/ThreadPool.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <thread>
+#include <typeinfo>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // bounds the grid's cell count, the cell size grows until the scene fits
+    const uint64_t maxCells = 32768;
+
+    // draws smaller than this fraction of a cell hardly occlude anything, leaving them out only ever leaves more visible
+    const double minOccluderFraction = 0.25;
+
+    // occluder triangles are culled against each cube face in runs of this many, so large draws still cull in pieces
+    const size_t clusterTriangles = 64;
+
+    using Point = std::array<double, 3>;
+
+    bool readIndex(vsg::Data* indices, size_t i, uint32_t& index)
+    {
+        if (auto ushorts = dynamic_cast<vsg::ushortArray*>(indices))
+        {
+            if (i >= ushorts->size()) return false;
+            index = ushorts->at(i);
+            return true;
+        }
+        if (auto uints = dynamic_cast<vsg::uintArray*>(indices))
+        {
+            if (i >= uints->size()) return false;
+            index = uints->at(i);
+            return true;
+        }
+        return false;
+    }
+
+    struct Target
+    {
+        vsg::ref_ptr<vsg::Node>* slot; // where the target is held, so it can be replaced by a switch
+        Bounds bounds;
+    };
+
+    // a run of consecutive occluder triangles and the box around them
+    struct OccluderCluster
+    {
+        size_t first; // the first corner
+        size_t count; // the number of corners
+        Bounds bounds;
+    };
+
+    // the nodes with a bound below the root and any static transforms, only those keep their place while the scene runs
+    class TargetCollector
+    {
+    public:
+        explicit TargetCollector(const std::set<vsg::Node*>* staticTransforms) :
+            _staticTransforms(staticTransforms) {}
+
+        void collect(vsg::ref_ptr<vsg::Node>& slot, const vsg::dmat4& matrix, bool root)
+        {
+            vsg::Node* node = slot.get();
+            if (!node) return;
+
+            if (auto cullNode = dynamic_cast<vsg::CullNode*>(node))
+            {
+                addTarget(slot, cullNode->bound, matrix);
+                collect(cullNode->child, matrix, false);
+                return;
+            }
+            if (auto lod = dynamic_cast<vsg::LOD*>(node))
+            {
+                addTarget(slot, lod->bound, matrix);
+                for (auto& child : lod->children) collect(child.node, matrix, false);
+                return;
+            }
+            // the pages are separate files, switching the pagedlod off also stops them loading
+            if (auto pagedLOD = dynamic_cast<vsg::PagedLOD*>(node))
+            {
+                addTarget(slot, pagedLOD->bound, matrix);
+                return;
+            }
+            if (auto cullGroup = dynamic_cast<vsg::CullGroup*>(node)) addTarget(slot, cullGroup->bound, matrix);
+
+            auto group = dynamic_cast<vsg::Group*>(node);
+            if (!group) return;
+
+            vsg::dmat4 childMatrix = matrix;
+            if (typeid(*node) == typeid(vsg::MatrixTransform))
+            {
+                if (!root && (!_staticTransforms || _staticTransforms->find(node) == _staticTransforms->end())) return;
+                childMatrix = matrix * static_cast<vsg::MatrixTransform*>(node)->matrix;
+            }
+
+            for (auto& child : group->children) collect(child, childMatrix, false);
+        }
+
+        std::vector<Target> targets;
+
+    private:
+        void addTarget(vsg::ref_ptr<vsg::Node>& slot, const vsg::dsphere& sphere, const vsg::dmat4& matrix)
+        {
+            if (sphere.radius <= 0.0) return;
+
+            // the sphere's bounding box in the space of the root's parent
+            double scale = 0.0;
+            for (int c = 0; c < 3; c++)
+            {
+                scale = std::max(scale, std::sqrt(matrix[c][0] * matrix[c][0] + matrix[c][1] * matrix[c][1] + matrix[c][2] * matrix[c][2]));
+            }
+            double radius = sphere.radius * scale;
+
+            Target target;
+            target.slot = &slot;
+            for (int r = 0; r < 3; r++)
+            {
+                double center = matrix[0][r] * sphere.center.x + matrix[1][r] * sphere.center.y + matrix[2][r] * sphere.center.z + matrix[3][r];
+                target.bounds.min[r] = center - radius;
+                target.bounds.max[r] = center + radius;
+            }
+            targets.push_back(target);
+        }
+
+        const std::set<vsg::Node*>* _staticTransforms;
+    };
+
+    // gathers the triangles of the opaque static draws big enough to occlude, three corners each
+    class OccluderCollector
+    {
+    public:
+        OccluderCollector(const std::set<vsg::GraphicsPipeline*>& blendedPipelines, const std::set<vsg::Node*>* staticTransforms, double minSize) :
+            _blendedPipelines(blendedPipelines),
+            _staticTransforms(staticTransforms),
+            _minSize(minSize) {}
+
+        void collect(vsg::Node* node, const vsg::dmat4& matrix, bool root)
+        {
+            if (!node) return;
+
+            if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(node))
+            {
+                if (!vid->arrays.empty() && vid->indices) addTriangles(vid->arrays.front()->data, vid->indices->data, vid->firstIndex, vid->indexCount, vid->vertexOffset, matrix);
+                return;
+            }
+
+            if (auto commands = dynamic_cast<vsg::Commands*>(node))
+            {
+                vsg::Data* positions = nullptr;
+                vsg::Data* indices = nullptr;
+                for (auto& command : commands->children)
+                {
+                    if (blended(command)) return;
+                    if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+                    {
+                        positions = bvb->arrays.empty() ? nullptr : bvb->arrays.front()->data.get();
+                    }
+                    else if (auto bib = dynamic_cast<vsg::BindIndexBuffer*>(command.get()))
+                    {
+                        indices = bib->indices ? bib->indices->data.get() : nullptr;
+                    }
+                    else if (auto drawIndexed = dynamic_cast<vsg::DrawIndexed*>(command.get()))
+                    {
+                        if (positions && indices) addTriangles(positions, indices, drawIndexed->firstIndex, drawIndexed->indexCount, drawIndexed->vertexOffset, matrix);
+                    }
+                }
+                return;
+            }
+
+            // the lowest detail is drawn from furthest away, and simplification tends to open gaps rather than close them
+            if (auto lod = dynamic_cast<vsg::LOD*>(node))
+            {
+                for (auto itr = lod->children.rbegin(); itr != lod->children.rend(); ++itr)
+                {
+                    if (!itr->node) continue;
+                    collect(itr->node, matrix, false);
+                    break;
+                }
+                return;
+            }
+
+            if (auto cullNode = dynamic_cast<vsg::CullNode*>(node))
+            {
+                collect(cullNode->child, matrix, false);
+                return;
+            }
+
+            // pages aren't loaded from everywhere, so can't be relied on to occlude
+            auto group = dynamic_cast<vsg::Group*>(node);
+            if (!group) return;
+
+            vsg::dmat4 childMatrix = matrix;
+            if (typeid(*node) == typeid(vsg::MatrixTransform))
+            {
+                if (!root && (!_staticTransforms || _staticTransforms->find(node) == _staticTransforms->end())) return;
+                childMatrix = matrix * static_cast<vsg::MatrixTransform*>(node)->matrix;
+            }
+            else if (auto stategroup = dynamic_cast<vsg::StateGroup*>(node))
+            {
+                for (auto& command : stategroup->stateCommands)
+                {
+                    if (blended(command)) return;
+                }
+            }
+
+            for (auto& child : group->children) collect(child, childMatrix, false);
+        }
+
+        std::vector<Point> corners;
+        std::vector<OccluderCluster> clusters;
+
+    private:
+        bool blended(vsg::Object* object) const
+        {
+            auto bindPipeline = dynamic_cast<vsg::BindGraphicsPipeline*>(object);
+            return bindPipeline && _blendedPipelines.find(bindPipeline->pipeline.get()) != _blendedPipelines.end();
+        }
+
+        void addTriangles(vsg::Data* positionData, vsg::Data* indices, uint32_t firstIndex, uint32_t indexCount, int32_t vertexOffset, const vsg::dmat4& matrix)
+        {
+            auto positions = dynamic_cast<vsg::vec3Array*>(positionData);
+            if (!positions || !indices) return;
+
+            size_t first = corners.size();
+            Bounds bounds;
+            for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+            {
+                Point triangle[3];
+                bool valid = true;
+                for (uint32_t c = 0; c < 3 && valid; c++)
+                {
+                    uint32_t index = 0;
+                    valid = readIndex(indices, firstIndex + i + c, index);
+                    int64_t vertex = static_cast<int64_t>(index) + vertexOffset;
+                    valid = valid && vertex >= 0 && static_cast<size_t>(vertex) < positions->size();
+                    if (!valid) break;
+
+                    const vsg::vec3& p = positions->at(static_cast<size_t>(vertex));
+                    for (int r = 0; r < 3; r++)
+                    {
+                        triangle[c][r] = matrix[0][r] * p.x + matrix[1][r] * p.y + matrix[2][r] * p.z + matrix[3][r];
+                    }
+                    bounds.expand(triangle[c][0], triangle[c][1], triangle[c][2]);
+                }
+                if (valid) corners.insert(corners.end(), triangle, triangle + 3);
+            }
+
+            double size = 0.0;
+            for (int axis = 0; axis < 3 && bounds.valid(); axis++) size = std::max(size, bounds.max[axis] - bounds.min[axis]);
+            if (size < _minSize)
+            {
+                corners.resize(first);
+                return;
+            }
+
+            for (size_t start = first; start < corners.size(); start += clusterTriangles * 3)
+            {
+                OccluderCluster cluster;
+                cluster.first = start;
+                cluster.count = std::min(clusterTriangles * 3, corners.size() - start);
+                for (size_t i = start; i < start + cluster.count; i++) cluster.bounds.expand(corners[i][0], corners[i][1], corners[i][2]);
+                clusters.push_back(cluster);
+            }
+        }
+
+        const std::set<vsg::GraphicsPipeline*>& _blendedPipelines;
+        const std::set<vsg::Node*>* _staticTransforms;
+        double _minSize;
+    };
+
+    struct Face
+    {
+        double right[3];
+        double up[3];
+        double forward[3];
+    };
+
+    // the six 90 degree frustums of a cube map, together they see in every direction
+    const Face cubeFaces[6] = {
+        {{0.0, 0.0, -1.0}, {0.0, 1.0, 0.0}, {1.0, 0.0, 0.0}},
+        {{0.0, 0.0, 1.0}, {0.0, 1.0, 0.0}, {-1.0, 0.0, 0.0}},
+        {{1.0, 0.0, 0.0}, {0.0, 0.0, -1.0}, {0.0, 1.0, 0.0}},
+        {{1.0, 0.0, 0.0}, {0.0, 0.0, 1.0}, {0.0, -1.0, 0.0}},
+        {{1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 1.0}},
+        {{-1.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, -1.0}}};
+
+    // renders the occluders around a viewpoint into a depth buffer of inverse view depths sampled at pixel centers, then erodes it
+    // so each pixel keeps the furthest depth of its neighbours and is only occluded where they all are. the bounds of a target are
+    // tested against every pixel they touch at their nearest depth, so only gaps between occluders narrower than a pixel can be
+    // missed
+    class OcclusionRasterizer
+    {
+    public:
+        OcclusionRasterizer(const std::vector<Point>& occluders, const std::vector<OccluderCluster>& clusters, const std::vector<Target>& targets, uint32_t resolution, double nearDistance) :
+            _occluders(occluders),
+            _clusters(clusters),
+            _targets(targets),
+            _resolution(resolution),
+            _near(nearDistance),
+            _depth(static_cast<size_t>(resolution) * resolution),
+            _eroded(_depth.size()) {}
+
+        // sets the bits of the targets visible from eye
+        void render(const Point& eye, uint8_t* visible)
+        {
+            for (auto& face : cubeFaces)
+            {
+                size_t hidden = 0;
+                for (size_t t = 0; t < _targets.size(); t++)
+                {
+                    if ((visible[t / 8] & (1u << (t % 8))) == 0) hidden++;
+                }
+                if (hidden == 0) return;
+
+                std::fill(_depth.begin(), _depth.end(), 0.0f);
+                for (auto& cluster : _clusters)
+                {
+                    if (!inFrustum(face, eye, cluster.bounds)) continue;
+                    for (size_t i = cluster.first; i + 2 < cluster.first + cluster.count; i += 3) rasterize(face, eye, &_occluders[i]);
+                }
+                erode();
+
+                for (size_t t = 0; t < _targets.size(); t++)
+                {
+                    if ((visible[t / 8] & (1u << (t % 8))) == 0 && test(face, eye, _targets[t].bounds)) visible[t / 8] |= static_cast<uint8_t>(1u << (t % 8));
+                }
+            }
+        }
+
+    private:
+        static void toView(const Face& face, const Point& eye, const Point& p, double view[3])
+        {
+            double d[3] = {p[0] - eye[0], p[1] - eye[1], p[2] - eye[2]};
+            view[0] = d[0] * face.right[0] + d[1] * face.right[1] + d[2] * face.right[2];
+            view[1] = d[0] * face.up[0] + d[1] * face.up[1] + d[2] * face.up[2];
+            view[2] = d[0] * face.forward[0] + d[1] * face.forward[1] + d[2] * face.forward[2];
+        }
+
+        // false only when every corner of the bounds is behind the near plane or outside the same side plane, so none of the
+        // triangles inside could be drawn
+        bool inFrustum(const Face& face, const Point& eye, const Bounds& bounds) const
+        {
+            double view[8][3];
+            for (int corner = 0; corner < 8; corner++)
+            {
+                Point p = {(corner & 1) ? bounds.max[0] : bounds.min[0], (corner & 2) ? bounds.max[1] : bounds.min[1], (corner & 4) ? bounds.max[2] : bounds.min[2]};
+                toView(face, eye, p, view[corner]);
+            }
+
+            for (int plane = 0; plane < 5; plane++)
+            {
+                bool outside = true;
+                for (int corner = 0; corner < 8 && outside; corner++)
+                {
+                    const double* v = view[corner];
+                    switch (plane)
+                    {
+                    case 0: outside = v[2] < _near; break;
+                    case 1: outside = v[0] > v[2]; break;
+                    case 2: outside = v[0] < -v[2]; break;
+                    case 3: outside = v[1] > v[2]; break;
+                    default: outside = v[1] < -v[2]; break;
+                    }
+                }
+                if (outside) return false;
+            }
+            return true;
+        }
+
+        void rasterize(const Face& face, const Point& eye, const Point* corners)
+        {
+            double view[3][3];
+            for (int c = 0; c < 3; c++)
+            {
+                toView(face, eye, corners[c], view[c]);
+                // clipping would add area, dropping an occluder that reaches the near plane only leaves more visible
+                if (view[c][2] < _near) return;
+            }
+
+            // all corners outside one of the side planes
+            for (int axis = 0; axis < 2; axis++)
+            {
+                if (view[0][axis] > view[0][2] && view[1][axis] > view[1][2] && view[2][axis] > view[2][2]) return;
+                if (view[0][axis] < -view[0][2] && view[1][axis] < -view[1][2] && view[2][axis] < -view[2][2]) return;
+            }
+
+            double half = 0.5 * static_cast<double>(_resolution);
+            double sx[3], sy[3], inv[3];
+            for (int c = 0; c < 3; c++)
+            {
+                sx[c] = (view[c][0] / view[c][2] + 1.0) * half;
+                sy[c] = (view[c][1] / view[c][2] + 1.0) * half;
+                inv[c] = 1.0 / view[c][2];
+            }
+
+            double area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+            if (std::abs(area) < 1e-12) return;
+            double sign = area > 0.0 ? 1.0 : -1.0;
+            area = std::abs(area);
+
+            // edge functions positive inside, both facings occlude
+            double a[3], b[3], c[3];
+            double depthA = 0.0, depthB = 0.0, depthC = 0.0;
+            for (int i = 0; i < 3; i++)
+            {
+                int j = (i + 1) % 3;
+                a[i] = sign * (sy[i] - sy[j]);
+                b[i] = sign * (sx[j] - sx[i]);
+                c[i] = sign * (sx[i] * sy[j] - sy[i] * sx[j]);
+
+                // the inverse depth is linear in screen space, each edge function weights the corner opposite it
+                double weight = inv[(i + 2) % 3] / area;
+                depthA += a[i] * weight;
+                depthB += b[i] * weight;
+                depthC += c[i] * weight;
+            }
+
+            int maxPixel = static_cast<int>(_resolution) - 1;
+            int x0 = std::max(0, static_cast<int>(std::floor(std::min({sx[0], sx[1], sx[2]}))));
+            int x1 = std::min(maxPixel, static_cast<int>(std::floor(std::max({sx[0], sx[1], sx[2]}))));
+            int y0 = std::max(0, static_cast<int>(std::floor(std::min({sy[0], sy[1], sy[2]}))));
+            int y1 = std::min(maxPixel, static_cast<int>(std::floor(std::max({sy[0], sy[1], sy[2]}))));
+
+            for (int y = y0; y <= y1; y++)
+            {
+                double py = static_cast<double>(y) + 0.5;
+                for (int x = x0; x <= x1; x++)
+                {
+                    double px = static_cast<double>(x) + 0.5;
+                    if (a[0] * px + b[0] * py + c[0] < 0.0 || a[1] * px + b[1] * py + c[1] < 0.0 || a[2] * px + b[2] * py + c[2] < 0.0) continue;
+
+                    float depth = static_cast<float>(depthA * px + depthB * py + depthC);
+                    float& stored = _depth[static_cast<size_t>(y) * _resolution + x];
+                    if (depth > stored) stored = depth;
+                }
+            }
+        }
+
+        void erode()
+        {
+            int maxPixel = static_cast<int>(_resolution) - 1;
+            for (int y = 0; y <= maxPixel; y++)
+            {
+                for (int x = 0; x <= maxPixel; x++)
+                {
+                    float depth = _depth[static_cast<size_t>(y) * _resolution + x];
+                    for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, maxPixel); ny++)
+                    {
+                        for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, maxPixel); nx++)
+                        {
+                            depth = std::min(depth, _depth[static_cast<size_t>(ny) * _resolution + nx]);
+                        }
+                    }
+                    _eroded[static_cast<size_t>(y) * _resolution + x] = depth;
+                }
+            }
+        }
+
+        // the part of the bounds inside the face's frustum, found by clipping each side of the box to it
+        bool test(const Face& face, const Point& eye, const Bounds& bounds) const
+        {
+            // a box holding the eye has no side in front of it
+            bool inside = true;
+            for (int axis = 0; axis < 3; axis++) inside = inside && eye[axis] >= bounds.min[axis] && eye[axis] <= bounds.max[axis];
+            if (inside) return true;
+
+            Point view[8];
+            for (int corner = 0; corner < 8; corner++)
+            {
+                Point p = {(corner & 1) ? bounds.max[0] : bounds.min[0], (corner & 2) ? bounds.max[1] : bounds.min[1], (corner & 4) ? bounds.max[2] : bounds.min[2]};
+                toView(face, eye, p, view[corner].data());
+            }
+
+            static const int sides[6][4] = {{0, 1, 3, 2}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 3, 7, 5}};
+
+            double minX = std::numeric_limits<double>::max(), maxX = -minX, minY = minX, maxY = -minX, nearest = minX;
+            for (auto& side : sides)
+            {
+                // each plane clipped against adds at most one vertex
+                std::array<Point, 9> polygon, clipped;
+                size_t count = 4;
+                for (int i = 0; i < 4; i++) polygon[i] = view[side[i]];
+
+                for (int plane = 0; plane < 5 && count > 0; plane++)
+                {
+                    auto distance = [&](const Point& v) {
+                        switch (plane)
+                        {
+                        case 0: return v[2] - _near;
+                        case 1: return v[2] - v[0];
+                        case 2: return v[2] + v[0];
+                        case 3: return v[2] - v[1];
+                        default: return v[2] + v[1];
+                        }
+                    };
+
+                    size_t clippedCount = 0;
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        const Point& from = polygon[i];
+                        const Point& to = polygon[(i + 1) % count];
+                        double fromDistance = distance(from), toDistance = distance(to);
+                        if (fromDistance >= 0.0) clipped[clippedCount++] = from;
+                        if ((fromDistance >= 0.0) != (toDistance >= 0.0))
+                        {
+                            double t = fromDistance / (fromDistance - toDistance);
+                            clipped[clippedCount++] = {from[0] + (to[0] - from[0]) * t, from[1] + (to[1] - from[1]) * t, from[2] + (to[2] - from[2]) * t};
+                        }
+                    }
+                    polygon = clipped;
+                    count = clippedCount;
+                }
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    double z = std::max(polygon[i][2], _near);
+                    minX = std::min(minX, polygon[i][0] / z);
+                    maxX = std::max(maxX, polygon[i][0] / z);
+                    minY = std::min(minY, polygon[i][1] / z);
+                    maxY = std::max(maxY, polygon[i][1] / z);
+                    nearest = std::min(nearest, z);
+                }
+            }
+
+            if (nearest == std::numeric_limits<double>::max()) return false;
+
+            double half = 0.5 * static_cast<double>(_resolution);
+            int maxPixel = static_cast<int>(_resolution) - 1;
+            int x0 = std::max(0, static_cast<int>(std::floor((minX + 1.0) * half)));
+            int x1 = std::min(maxPixel, static_cast<int>(std::floor((maxX + 1.0) * half)));
+            int y0 = std::max(0, static_cast<int>(std::floor((minY + 1.0) * half)));
+            int y1 = std::min(maxPixel, static_cast<int>(std::floor((maxY + 1.0) * half)));
+
+            float nearestInverse = static_cast<float>(1.0 / nearest);
+            for (int y = y0; y <= y1; y++)
+            {
+                for (int x = x0; x <= x1; x++)
+                {
+                    if (_eroded[static_cast<size_t>(y) * _resolution + x] <= nearestInverse) return true;
+                }
+            }
+            return false;
+        }
+
+        const std::vector<Point>& _occluders;
+        const std::vector<OccluderCluster>& _clusters;
+        const std::vector<Target>& _targets;
+        uint32_t _resolution;
+        double _near;
+        std::vector<float> _depth;
+        std::vector<float> _eroded;
+    };
+
+    bool overlaps(const Bounds& lhs, const Bounds& rhs)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (lhs.max[axis] < rhs.min[axis] || rhs.max[axis] < lhs.min[axis]) return false;
+        }
+        return true;
+    }
+} // namespace
+
+void unity2vsg::buildPotentiallyVisibleSet(vsg::Group* root, double cellSize, uint32_t resolution, const std::set<vsg::GraphicsPipeline*>& blendedPipelines,
+                                           const std::set<vsg::Node*>* staticTransforms, PVSStats& stats)
+{
+    if (!root || cellSize <= 0.0 || resolution == 0) return;
+
+    vsg::ref_ptr<vsg::Node> rootSlot(root);
+    TargetCollector targetCollector(staticTransforms);
+    targetCollector.collect(rootSlot, vsg::dmat4(), true);
+    auto& targets = targetCollector.targets;
+    stats.targets = static_cast<uint32_t>(targets.size());
+    if (targets.empty()) return;
+
+    // the grid covers the targets, only where there's something to see matters
+    Bounds sceneBounds;
+    for (auto& target : targets) sceneBounds.expand(target.bounds);
+
+    uint32_t cells[3];
+    uint64_t cellCount = 0;
+    for (;;)
+    {
+        cellCount = 1;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            cells[axis] = std::max(1u, static_cast<uint32_t>(std::ceil((sceneBounds.max[axis] - sceneBounds.min[axis]) / cellSize)));
+            cellCount *= cells[axis];
+        }
+        if (cellCount <= maxCells) break;
+        cellSize *= std::cbrt(static_cast<double>(cellCount) / static_cast<double>(maxCells)) * 1.01;
+    }
+    stats.cells = static_cast<uint32_t>(cellCount);
+    stats.cellSize = cellSize;
+
+    OccluderCollector occluderCollector(blendedPipelines, staticTransforms, cellSize * minOccluderFraction);
+    occluderCollector.collect(root, vsg::dmat4(), true);
+    auto& occluders = occluderCollector.corners;
+    stats.occluderTriangles = occluders.size() / 3;
+
+    // each cell samples visibility from its corners, which neighbouring cells share, and its center
+    uint32_t corners[3] = {cells[0] + 1, cells[1] + 1, cells[2] + 1};
+    size_t cornerCount = static_cast<size_t>(corners[0]) * corners[1] * corners[2];
+    std::vector<Point> points;
+    points.reserve(cornerCount + cellCount);
+    for (uint32_t z = 0; z < corners[2]; z++)
+    {
+        for (uint32_t y = 0; y < corners[1]; y++)
+        {
+            for (uint32_t x = 0; x < corners[0]; x++)
+            {
+                points.push_back({sceneBounds.min[0] + x * cellSize, sceneBounds.min[1] + y * cellSize, sceneBounds.min[2] + z * cellSize});
+            }
+        }
+    }
+    for (uint32_t z = 0; z < cells[2]; z++)
+    {
+        for (uint32_t y = 0; y < cells[1]; y++)
+        {
+            for (uint32_t x = 0; x < cells[0]; x++)
+            {
+                points.push_back({sceneBounds.min[0] + (x + 0.5) * cellSize, sceneBounds.min[1] + (y + 0.5) * cellSize, sceneBounds.min[2] + (z + 0.5) * cellSize});
+            }
+        }
+    }
+
+    size_t rowBytes = (targets.size() + 7) / 8;
+    std::vector<uint8_t> pointVisibility(points.size() * rowBytes, 0);
+    double nearDistance = cellSize * 1e-3;
+
+    {
+        vsg::ref_ptr<ThreadPool> threads(new ThreadPool(std::max(std::thread::hardware_concurrency(), 1u)));
+        std::atomic<size_t> nextPoint(0);
+        std::vector<std::future<void>> tasks;
+        for (uint32_t t = 0; t < threads->size(); t++)
+        {
+            tasks.push_back(threads->run([&]() {
+                OcclusionRasterizer rasterizer(occluders, occluderCollector.clusters, targets, resolution, nearDistance);
+                for (size_t p = nextPoint++; p < points.size(); p = nextPoint++) rasterizer.render(points[p], &pointVisibility[p * rowBytes]);
+            }));
+        }
+        for (auto& task : tasks) task.get();
+    }
+
+    // a cell sees what any of its samples see, along with whatever its own bounds overlap
+    std::vector<uint8_t> cellVisibility(static_cast<size_t>(cellCount) * rowBytes, 0);
+    for (uint32_t z = 0; z < cells[2]; z++)
+    {
+        for (uint32_t y = 0; y < cells[1]; y++)
+        {
+            for (uint32_t x = 0; x < cells[0]; x++)
+            {
+                size_t cell = (static_cast<size_t>(z) * cells[1] + y) * cells[0] + x;
+                uint8_t* row = &cellVisibility[cell * rowBytes];
+
+                for (int corner = 0; corner < 8; corner++)
+                {
+                    size_t point = (static_cast<size_t>(z + ((corner >> 2) & 1)) * corners[1] + y + ((corner >> 1) & 1)) * corners[0] + x + (corner & 1);
+                    for (size_t i = 0; i < rowBytes; i++) row[i] |= pointVisibility[point * rowBytes + i];
+                }
+                for (size_t i = 0; i < rowBytes; i++) row[i] |= pointVisibility[(cornerCount + cell) * rowBytes + i];
+
+                Bounds cellBounds;
+                cellBounds.expand(points[cell + cornerCount][0] - cellSize * 0.5, points[cell + cornerCount][1] - cellSize * 0.5, points[cell + cornerCount][2] - cellSize * 0.5);
+                cellBounds.expand(points[cell + cornerCount][0] + cellSize * 0.5, points[cell + cornerCount][1] + cellSize * 0.5, points[cell + cornerCount][2] + cellSize * 0.5);
+                for (size_t t = 0; t < targets.size(); t++)
+                {
+                    if (overlaps(cellBounds, targets[t].bounds)) row[t / 8] |= static_cast<uint8_t>(1u << (t % 8));
+                }
+            }
+        }
+    }
+
+    // only targets hidden from some cell need a switch
+    std::vector<size_t> switched;
+    for (size_t t = 0; t < targets.size(); t++)
+    {
+        for (size_t cell = 0; cell < cellCount; cell++)
+        {
+            if ((cellVisibility[cell * rowBytes + t / 8] & (1u << (t % 8))) == 0)
+            {
+                switched.push_back(t);
+                break;
+            }
+        }
+    }
+    stats.switchedTargets = static_cast<uint32_t>(switched.size());
+    if (switched.empty()) return;
+
+    auto visibility = vsg::ubyteArray2D::create(static_cast<uint32_t>((switched.size() + 7) / 8), static_cast<uint32_t>(cellCount));
+    auto switches = vsg::Objects::create();
+    for (size_t s = 0; s < switched.size(); s++)
+    {
+        size_t t = switched[s];
+        for (size_t cell = 0; cell < cellCount; cell++)
+        {
+            if (s % 8 == 0) visibility->set(s / 8, cell, 0);
+            if (cellVisibility[cell * rowBytes + t / 8] & (1u << (t % 8)))
+                visibility->set(s / 8, cell, static_cast<uint8_t>(visibility->at(s / 8, cell) | (1u << (s % 8))));
+            else
+                stats.hiddenPairs++;
+        }
+
+        auto targetSwitch = vsg::Switch::create();
+        targetSwitch->addChild(true, *targets[t].slot);
+        *targets[t].slot = targetSwitch;
+        switches->addChild(targetSwitch);
+    }
+
+    root->setObject("pvsOrigin", vsg::dvec3Value::create(vsg::dvec3(sceneBounds.min[0], sceneBounds.min[1], sceneBounds.min[2])));
+    root->setObject("pvsCellSize", vsg::doubleValue::create(cellSize));
+    root->setObject("pvsCells", vsg::uivec3Value::create(vsg::uivec3(cells[0], cells[1], cells[2])));
+    root->setObject("pvsVisibility", visibility);
+    root->setObject("pvsTargets", switches);
+}
+
+PotentiallyVisibleSet::PotentiallyVisibleSet(vsg::Object* scene)
+{
+    if (!scene) return;
+
+    auto origin = dynamic_cast<vsg::dvec3Value*>(scene->getObject("pvsOrigin"));
+    auto cellSize = dynamic_cast<vsg::doubleValue*>(scene->getObject("pvsCellSize"));
+    auto cells = dynamic_cast<vsg::uivec3Value*>(scene->getObject("pvsCells"));
+    auto visibility = dynamic_cast<vsg::ubyteArray2D*>(scene->getObject("pvsVisibility"));
+    auto targets = dynamic_cast<vsg::Objects*>(scene->getObject("pvsTargets"));
+    if (!origin || !cellSize || !cells || !visibility || !targets || cellSize->value() <= 0.0) return;
+
+    uint64_t cellCount = static_cast<uint64_t>(cells->value().x) * cells->value().y * cells->value().z;
+    if (visibility->height() != cellCount || static_cast<uint64_t>(visibility->width()) * 8 < targets->children.size()) return;
+
+    _origin = origin->value();
+    _cellSize = cellSize->value();
+    _cells = cells->value();
+    _visibility = visibility;
+    for (auto& target : targets->children)
+    {
+        auto targetSwitch = dynamic_cast<vsg::Switch*>(target.get());
+        if (!targetSwitch || targetSwitch->children.empty())
+        {
+            _targets.clear();
+            return;
+        }
+        _targets.push_back(vsg::ref_ptr<vsg::Switch>(targetSwitch));
+    }
+}
+
+void PotentiallyVisibleSet::update(const vsg::dvec3& eye)
+{
+    if (_targets.empty()) return;
+
+    int64_t cell = -1;
+    int64_t x = static_cast<int64_t>(std::floor((eye.x - _origin.x) / _cellSize));
+    int64_t y = static_cast<int64_t>(std::floor((eye.y - _origin.y) / _cellSize));
+    int64_t z = static_cast<int64_t>(std::floor((eye.z - _origin.z) / _cellSize));
+    if (x >= 0 && y >= 0 && z >= 0 && x < _cells.x && y < _cells.y && z < _cells.z) cell = (z * _cells.y + y) * _cells.x + x;
+
+    if (cell == _currentCell) return;
+    _currentCell = cell;
+
+    for (size_t t = 0; t < _targets.size(); t++)
+    {
+        bool visible = cell < 0 || (_visibility->at(static_cast<uint32_t>(t / 8), static_cast<uint32_t>(cell)) & (1u << (t % 8))) != 0;
+        _targets[t]->children[0].mask = visible ? vsg::MASK_ALL : vsg::MASK_OFF;
+    }
+}
@@ -0,0 +1,250 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/SPIRVReflection.h>
+
+#include <map>
+#include <set>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // the spirv opcodes, decorations and storage classes reflection reads
+    enum Op : uint32_t
+    {
+        OpTypeImage = 25,
+        OpTypeSampler = 26,
+        OpTypeSampledImage = 27,
+        OpTypeArray = 28,
+        OpTypeRuntimeArray = 29,
+        OpTypeStruct = 30,
+        OpTypePointer = 32,
+        OpConstant = 43,
+        OpFunction = 54,
+        OpFunctionCall = 57,
+        OpVariable = 59,
+        OpImageTexelPointer = 60,
+        OpLoad = 61,
+        OpStore = 62,
+        OpCopyMemory = 63,
+        OpCopyMemorySized = 64,
+        OpAccessChain = 65,
+        OpInBoundsAccessChain = 66,
+        OpPtrAccessChain = 67,
+        OpArrayLength = 68,
+        OpDecorate = 71
+    };
+
+    enum Decoration : uint32_t
+    {
+        DecorationBufferBlock = 3,
+        DecorationBuiltIn = 11,
+        DecorationLocation = 30,
+        DecorationBinding = 33,
+        DecorationDescriptorSet = 34
+    };
+
+    enum StorageClass : uint32_t
+    {
+        StorageClassUniformConstant = 0,
+        StorageClassInput = 1,
+        StorageClassUniform = 2,
+        StorageClassStorageBuffer = 12
+    };
+
+    enum Dim : uint32_t
+    {
+        DimBuffer = 5,
+        DimSubpassData = 6
+    };
+
+    struct Variable
+    {
+        uint32_t pointerType;
+        uint32_t storageClass;
+    };
+} // namespace
+
+bool unity2vsg::reflectSPIRV(const std::vector<uint32_t>& spirv, SPIRVReflection& reflection)
+{
+    reflection = SPIRVReflection();
+
+    const size_t headerSize = 5;
+    if (spirv.size() <= headerSize || spirv[0] != 0x07230203) return false;
+
+    // ids of interest gathered in a single pass, the types of a variable are always declared before it and its
+    // decorations before any function so everything needed is known by the first function
+    std::map<uint32_t, std::map<uint32_t, uint32_t>> decorations; // id, decoration, first operand
+    std::map<uint32_t, std::vector<uint32_t>> types;              // id, instruction words
+    std::map<uint32_t, uint32_t> constants;
+    std::map<uint32_t, Variable> variables;
+    std::set<uint32_t> accessed;
+
+    bool inFunctions = false;
+    size_t read = headerSize;
+    while (read < spirv.size())
+    {
+        uint32_t wordCount = spirv[read] >> 16;
+        uint32_t opcode = spirv[read] & 0xFFFF;
+        if (wordCount == 0 || read + wordCount > spirv.size()) return false;
+
+        const uint32_t* operands = &spirv[read + 1];
+        uint32_t operandCount = wordCount - 1;
+
+        switch (opcode)
+        {
+        case OpDecorate:
+            if (operandCount >= 2) decorations[operands[0]][operands[1]] = operandCount >= 3 ? operands[2] : 0;
+            break;
+        case OpTypeImage:
+        case OpTypeSampler:
+        case OpTypeSampledImage:
+        case OpTypeArray:
+        case OpTypeRuntimeArray:
+        case OpTypeStruct:
+        case OpTypePointer:
+            if (operandCount >= 1) types[operands[0]] = std::vector<uint32_t>(spirv.begin() + read, spirv.begin() + read + wordCount);
+            break;
+        case OpConstant:
+            if (operandCount >= 3) constants[operands[1]] = operands[2];
+            break;
+        case OpFunction:
+            inFunctions = true;
+            break;
+        case OpVariable:
+            if (!inFunctions && operandCount >= 3) variables[operands[1]] = {operands[0], operands[2]};
+            break;
+        // the operands that name the variable an instruction reads or writes through
+        case OpLoad:
+        case OpImageTexelPointer:
+        case OpArrayLength:
+        case OpAccessChain:
+        case OpInBoundsAccessChain:
+        case OpPtrAccessChain:
+            if (operandCount >= 3) accessed.insert(operands[2]);
+            break;
+        case OpStore:
+            if (operandCount >= 1) accessed.insert(operands[0]);
+            break;
+        case OpCopyMemory:
+        case OpCopyMemorySized:
+            if (operandCount >= 2)
+            {
+                accessed.insert(operands[0]);
+                accessed.insert(operands[1]);
+            }
+            break;
+        case OpFunctionCall:
+            for (uint32_t i = 3; i < operandCount; i++) accessed.insert(operands[i]);
+            break;
+        default:
+            break;
+        }
+
+        read += wordCount;
+    }
+
+    auto decoration = [&](uint32_t id, uint32_t type, uint32_t& value) {
+        auto itr = decorations.find(id);
+        if (itr == decorations.end()) return false;
+        auto decorationItr = itr->second.find(type);
+        if (decorationItr == itr->second.end()) return false;
+        value = decorationItr->second;
+        return true;
+    };
+
+    auto type = [&](uint32_t id) -> const std::vector<uint32_t>* {
+        auto itr = types.find(id);
+        return itr != types.end() ? &itr->second : nullptr;
+    };
+
+    for (auto& entry : variables)
+    {
+        uint32_t id = entry.first;
+        const Variable& variable = entry.second;
+        bool used = accessed.count(id) > 0;
+
+        uint32_t value;
+        if (variable.storageClass == StorageClassInput)
+        {
+            if (decoration(id, DecorationBuiltIn, value) || !decoration(id, DecorationLocation, value)) continue;
+            reflection.inputs.push_back({value, used});
+            continue;
+        }
+
+        if (variable.storageClass != StorageClassUniformConstant && variable.storageClass != StorageClassUniform && variable.storageClass != StorageClassStorageBuffer) continue;
+
+        uint32_t binding;
+        if (!decoration(id, DecorationBinding, binding)) continue;
+        uint32_t set = 0;
+        decoration(id, DecorationDescriptorSet, set);
+
+        // follow the pointer to the variable's type through any arrays, multiplying out their lengths
+        const std::vector<uint32_t>* pointer = type(variable.pointerType);
+        if (!pointer || pointer->size() < 4) continue;
+
+        const std::vector<uint32_t>* pointee = type((*pointer)[3]);
+        uint32_t count = 1;
+        while (pointee && ((pointee->front() & 0xFFFF) == OpTypeArray || (pointee->front() & 0xFFFF) == OpTypeRuntimeArray))
+        {
+            if ((pointee->front() & 0xFFFF) == OpTypeRuntimeArray)
+            {
+                count = 0;
+            }
+            else if (pointee->size() >= 4)
+            {
+                auto length = constants.find((*pointee)[3]);
+                count *= length != constants.end() ? length->second : 1;
+            }
+            pointee = pointee->size() >= 3 ? type((*pointee)[2]) : nullptr;
+        }
+        if (!pointee) continue;
+
+        VkDescriptorType descriptorType;
+        switch (pointee->front() & 0xFFFF)
+        {
+        case OpTypeSampledImage:
+            descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            break;
+        case OpTypeSampler:
+            descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+            break;
+        case OpTypeImage:
+        {
+            if (pointee->size() < 9) continue;
+            uint32_t dim = (*pointee)[3];
+            bool sampled = (*pointee)[7] == 1;
+            if (dim == DimBuffer)
+                descriptorType = sampled ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+            else if (dim == DimSubpassData)
+                descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+            else
+                descriptorType = sampled ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            break;
+        }
+        case OpTypeStruct:
+        {
+            // storage buffers are BufferBlock structs in the Uniform class before spirv 1.3 and the StorageBuffer class after
+            bool storage = variable.storageClass == StorageClassStorageBuffer || decoration((*pointee)[1], DecorationBufferBlock, value);
+            descriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            break;
+        }
+        default:
+            continue;
+        }
+
+        reflection.descriptorBindings.push_back({set, binding, descriptorType, count, used});
+    }
+
+    return true;
+}
@@ -0,0 +1,212 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/SceneBounds.h>
+
+#include <typeinfo>
+
+using namespace unity2vsg;
+
+bool BoundsCalculator::bounds(vsg::Node* node, const vsg::dmat4& matrix, Bounds& bounds)
+{
+    if (!node) return true;
+
+    // whether a node can be moved doesn't depend on where it is, so it's worked out once as its bounds are first added
+    auto known = _movable.find(node);
+    if (known != _movable.end() && !known->second) return false;
+
+    bool result = addBounds(node, matrix, bounds);
+    _movable[node] = result;
+    return result;
+}
+
+bool BoundsCalculator::addBounds(vsg::Node* node, const vsg::dmat4& matrix, Bounds& bounds)
+{
+    // nodes that already cull have their bound precomputed
+    if (auto cullGroup = dynamic_cast<vsg::CullGroup*>(node))
+    {
+        if (!movable(cullGroup->children)) return false;
+        addSphere(cullGroup->bound, matrix, bounds);
+        return true;
+    }
+    if (auto cullNode = dynamic_cast<vsg::CullNode*>(node))
+    {
+        if (cullNode->child && !movable(cullNode->child)) return false;
+        addSphere(cullNode->bound, matrix, bounds);
+        return true;
+    }
+    if (auto lod = dynamic_cast<vsg::LOD*>(node))
+    {
+        for (auto& child : lod->children)
+        {
+            if (child.node && !movable(child.node)) return false;
+        }
+        addSphere(lod->bound, matrix, bounds);
+        return true;
+    }
+    if (auto pagedLOD = dynamic_cast<vsg::PagedLOD*>(node))
+    {
+        // only opaque draws are paged
+        addSphere(pagedLOD->bound, matrix, bounds);
+        return true;
+    }
+
+    if (auto vid = dynamic_cast<vsg::VertexIndexDraw*>(node))
+    {
+        if (vid->arrays.empty()) return false;
+        return addPositions(vid->arrays.front()->data, matrix, bounds);
+    }
+
+    if (auto commands = dynamic_cast<vsg::Commands*>(node))
+    {
+        bool drawn = false;
+        for (auto& command : commands->children)
+        {
+            if (blended(command)) return false;
+            if (auto bvb = dynamic_cast<vsg::BindVertexBuffers*>(command.get()))
+            {
+                if (bvb->arrays.empty() || !addPositions(bvb->arrays.front()->data, matrix, bounds)) return false;
+                drawn = true;
+            }
+        }
+        return drawn;
+    }
+
+    auto group = dynamic_cast<vsg::Group*>(node);
+    if (!group) return false;
+
+    vsg::dmat4 childMatrix = matrix;
+    if (typeid(*node) == typeid(vsg::MatrixTransform))
+    {
+        childMatrix = matrix * static_cast<vsg::MatrixTransform*>(node)->matrix;
+    }
+    else if (auto stategroup = dynamic_cast<vsg::StateGroup*>(node))
+    {
+        for (auto& command : stategroup->stateCommands)
+        {
+            if (blended(command)) return false;
+        }
+    }
+    else if (typeid(*node) != typeid(vsg::Group))
+    {
+        return false;
+    }
+
+    for (auto& child : group->children)
+    {
+        if (!this->bounds(child, childMatrix, bounds)) return false;
+    }
+    return true;
+}
+
+bool BoundsCalculator::blended(vsg::Object* object) const
+{
+    auto bindPipeline = dynamic_cast<vsg::BindGraphicsPipeline*>(object);
+    return bindPipeline && _blendedPipelines.find(bindPipeline->pipeline.get()) != _blendedPipelines.end();
+}
+
+// the bound of a culling node is known, but what it holds still has to be opaque to be reordered
+bool BoundsCalculator::movable(vsg::Node* node)
+{
+    auto known = _movable.find(node);
+    if (known != _movable.end()) return known->second;
+
+    bool result = true;
+    if (auto cullGroup = dynamic_cast<vsg::CullGroup*>(node))
+    {
+        result = movable(cullGroup->children);
+    }
+    else if (auto cullNode = dynamic_cast<vsg::CullNode*>(node))
+    {
+        result = !cullNode->child || movable(cullNode->child);
+    }
+    else if (auto lod = dynamic_cast<vsg::LOD*>(node))
+    {
+        for (auto& child : lod->children)
+        {
+            if (child.node && !movable(child.node))
+            {
+                result = false;
+                break;
+            }
+        }
+    }
+    else
+    {
+        Bounds ignored;
+        return bounds(node, vsg::dmat4(), ignored);
+    }
+
+    _movable[node] = result;
+    return result;
+}
+
+bool BoundsCalculator::movable(const vsg::Group::Children& children)
+{
+    for (auto& child : children)
+    {
+        if (!movable(child)) return false;
+    }
+    return true;
+}
+
+bool BoundsCalculator::addPositions(vsg::Data* data, const vsg::dmat4& matrix, Bounds& bounds)
+{
+    auto itr = _localBounds.find(data);
+    if (itr == _localBounds.end())
+    {
+        Bounds local;
+        if (auto positions = dynamic_cast<vsg::vec3Array*>(data))
+        {
+            for (size_t i = 0; i < positions->size(); i++)
+            {
+                const vsg::vec3& p = positions->at(i);
+                local.expand(p.x, p.y, p.z);
+            }
+        }
+        itr = _localBounds.insert(std::make_pair(data, local)).first;
+    }
+
+    const Bounds& local = itr->second;
+    if (!local.valid()) return false;
+
+    // the corners of the transformed box bound everything in it
+    for (int corner = 0; corner < 8; corner++)
+    {
+        double x = (corner & 1) ? local.max[0] : local.min[0];
+        double y = (corner & 2) ? local.max[1] : local.min[1];
+        double z = (corner & 4) ? local.max[2] : local.min[2];
+        bounds.expand(matrix[0][0] * x + matrix[1][0] * y + matrix[2][0] * z + matrix[3][0],
+                      matrix[0][1] * x + matrix[1][1] * y + matrix[2][1] * z + matrix[3][1],
+                      matrix[0][2] * x + matrix[1][2] * y + matrix[2][2] * z + matrix[3][2]);
+    }
+    return true;
+}
+
+void BoundsCalculator::addSphere(const vsg::dsphere& sphere, const vsg::dmat4& matrix, Bounds& bounds) const
+{
+    double center[3];
+    for (int r = 0; r < 3; r++)
+    {
+        center[r] = matrix[0][r] * sphere.center.x + matrix[1][r] * sphere.center.y + matrix[2][r] * sphere.center.z + matrix[3][r];
+    }
+
+    double maxScale = 0.0;
+    for (int c = 0; c < 3; c++)
+    {
+        maxScale = std::max(maxScale, std::sqrt(matrix[c][0] * matrix[c][0] + matrix[c][1] * matrix[c][1] + matrix[c][2] * matrix[c][2]));
+    }
+    double radius = sphere.radius * maxScale;
+
+    bounds.expand(center[0] - radius, center[1] - radius, center[2] - radius);
+    bounds.expand(center[0] + radius, center[1] + radius, center[2] + radius);
+}
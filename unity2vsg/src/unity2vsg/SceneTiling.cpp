@@ -0,0 +1,243 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/SceneTiling.h>
+
+#include <climits>
+#include <cmath>
+#include <map>
+#include <typeinfo>
+
+using namespace unity2vsg;
+
+namespace
+{
+    using TileKey = std::array<int, 3>;
+
+    // the key of what stays in the scene file
+    const TileKey unpaged = {INT_MIN, INT_MIN, INT_MIN};
+
+    using TileParts = std::map<TileKey, vsg::ref_ptr<vsg::Node>>;
+
+    class SceneTiler
+    {
+    public:
+        SceneTiler(double tileSize, const std::set<vsg::GraphicsPipeline*>& blendedPipelines, const std::set<vsg::Node*>* staticTransforms) :
+            _tileSize(tileSize),
+            _calculator(blendedPipelines),
+            _staticTransforms(staticTransforms) {}
+
+        // split a node into the parts of it in each tile. a node entirely in one tile is returned as it is, otherwise groups are
+        // copied for each tile holding the parts of their children in it
+        TileParts split(vsg::ref_ptr<vsg::Node> node, const vsg::dmat4& matrix)
+        {
+            TileParts parts;
+            if (!node) return parts;
+
+            if (!movable(node))
+            {
+                parts[unpaged] = node;
+                return parts;
+            }
+
+            if (!splittable(node))
+            {
+                Bounds bounds;
+                if (_calculator.bounds(node, matrix, bounds) && bounds.valid())
+                {
+                    TileKey key = tileOf(bounds);
+                    _tileBounds[key].expand(bounds);
+                    parts[key] = node;
+                }
+                else
+                {
+                    parts[unpaged] = node;
+                }
+                return parts;
+            }
+
+            auto group = static_cast<vsg::Group*>(node.get());
+            vsg::dmat4 childMatrix = matrix;
+            if (typeid(*group) == typeid(vsg::MatrixTransform)) childMatrix = matrix * static_cast<vsg::MatrixTransform*>(group)->matrix;
+
+            std::map<TileKey, vsg::Group::Children> children;
+            std::set<TileKey> keys;
+            for (auto& child : group->children)
+            {
+                for (auto& part : split(child, childMatrix))
+                {
+                    children[part.first].push_back(part.second);
+                    keys.insert(part.first);
+                }
+            }
+
+            // the depth only variant draws the same meshes so is split the same way, each copy of the stategroup gets its part of it
+            TileParts depthOnlyParts;
+            auto stategroup = dynamic_cast<vsg::StateGroup*>(group);
+            if (stategroup)
+            {
+                if (auto depthOnly = dynamic_cast<vsg::Node*>(stategroup->getObject("depthOnly")))
+                {
+                    depthOnlyParts = split(vsg::ref_ptr<vsg::Node>(depthOnly), childMatrix);
+                    for (auto& part : depthOnlyParts) keys.insert(part.first);
+                }
+            }
+
+            if (keys.size() <= 1)
+            {
+                parts[keys.empty() ? unpaged : *keys.begin()] = node;
+                return parts;
+            }
+
+            for (auto& key : keys)
+            {
+                vsg::ref_ptr<vsg::Group> copy;
+                if (typeid(*group) == typeid(vsg::MatrixTransform))
+                {
+                    copy = vsg::MatrixTransform::create(static_cast<vsg::MatrixTransform*>(group)->matrix);
+                }
+                else if (typeid(*group) == typeid(vsg::CullGroup))
+                {
+                    copy = vsg::CullGroup::create(static_cast<vsg::CullGroup*>(group)->bound);
+                }
+                else if (stategroup)
+                {
+                    auto stategroupCopy = vsg::StateGroup::create();
+                    stategroupCopy->stateCommands = stategroup->stateCommands;
+                    auto depthOnlyPart = depthOnlyParts.find(key);
+                    if (depthOnlyPart != depthOnlyParts.end()) stategroupCopy->setObject("depthOnly", depthOnlyPart->second);
+                    copy = stategroupCopy;
+                }
+                else
+                {
+                    copy = vsg::Group::create();
+                }
+                copy->children = children[key];
+                parts[key] = copy;
+            }
+            return parts;
+        }
+
+        const Bounds& tileBounds(const TileKey& key) { return _tileBounds[key]; }
+
+    private:
+        // with static transforms given, whatever is below the others stays where it is
+        bool movable(vsg::Node* node) const
+        {
+            if (!_staticTransforms || typeid(*node) != typeid(vsg::MatrixTransform)) return true;
+            return _staticTransforms->find(node) != _staticTransforms->end();
+        }
+
+        // groups whose copies behave the same as the original, blended stategroups are kept whole so their draw order is kept
+        bool splittable(vsg::Node* node) const
+        {
+            if (node->getAuxiliary() && !dynamic_cast<vsg::StateGroup*>(node)) return false;
+
+            const std::type_info& type = typeid(*node);
+            if (type == typeid(vsg::Group) || type == typeid(vsg::MatrixTransform) || type == typeid(vsg::CullGroup)) return true;
+
+            if (type == typeid(vsg::StateGroup))
+            {
+                for (auto& command : static_cast<vsg::StateGroup*>(node)->stateCommands)
+                {
+                    if (_calculator.blended(command)) return false;
+                }
+                return true;
+            }
+            return false;
+        }
+
+        TileKey tileOf(const Bounds& bounds) const
+        {
+            TileKey key;
+            for (int axis = 0; axis < 3; axis++) key[axis] = static_cast<int>(std::floor(bounds.center(axis) / _tileSize));
+            return key;
+        }
+
+        double _tileSize;
+        BoundsCalculator _calculator;
+        const std::set<vsg::Node*>* _staticTransforms;
+        std::map<TileKey, Bounds> _tileBounds;
+    };
+
+    // tiles are written to a directory next to the scene file named after it
+    std::string tileDirectoryName(const std::string& sceneFileName)
+    {
+        auto sep = sceneFileName.find_last_of("/\\");
+        std::string name = sep == std::string::npos ? sceneFileName : sceneFileName.substr(sep + 1);
+        auto ext = name.find_last_of('.');
+        return (ext == std::string::npos ? name : name.substr(0, ext)) + "_tiles";
+    }
+
+    std::string extensionOf(const std::string& sceneFileName)
+    {
+        auto ext = sceneFileName.find_last_of('.');
+        auto sep = sceneFileName.find_last_of("/\\");
+        if (ext == std::string::npos || (sep != std::string::npos && ext < sep)) return ".vsgb";
+        return sceneFileName.substr(ext);
+    }
+} // namespace
+
+std::vector<SceneTile> unity2vsg::splitIntoTiles(vsg::Group* root, double tileSize, const std::set<vsg::GraphicsPipeline*>& blendedPipelines,
+                                                 const std::set<vsg::Node*>* staticTransforms)
+{
+    std::vector<SceneTile> tiles;
+    if (!root || tileSize <= 0.0) return tiles;
+
+    // the root's own transform stays where it is, tiles are split in its space
+    SceneTiler tiler(tileSize, blendedPipelines, staticTransforms);
+    std::map<TileKey, vsg::Group::Children> parts;
+    for (auto& child : root->children)
+    {
+        for (auto& part : tiler.split(child, vsg::dmat4())) parts[part.first].push_back(part.second);
+    }
+
+    root->children = parts[unpaged];
+
+    for (auto& part : parts)
+    {
+        if (part.first == unpaged) continue;
+
+        SceneTile tile;
+        tile.cell = part.first;
+        tile.bounds = tiler.tileBounds(part.first);
+        tile.root = vsg::Group::create();
+        tile.root->children = part.second;
+        tiles.push_back(tile);
+    }
+    return tiles;
+}
+
+std::vector<TilePage> unity2vsg::tileScene(vsg::Group* root, double tileSize, double minimumScreenHeightRatio, const std::string& sceneFileName,
+                                           const std::set<vsg::GraphicsPipeline*>& blendedPipelines)
+{
+    std::vector<TilePage> pages;
+
+    std::string directory = tileDirectoryName(sceneFileName);
+    std::string extension = extensionOf(sceneFileName);
+    for (auto& tile : splitIntoTiles(root, tileSize, blendedPipelines))
+    {
+        TilePage page;
+        page.fileName = directory + "/" + std::to_string(tile.cell[0]) + "_" + std::to_string(tile.cell[1]) + "_" + std::to_string(tile.cell[2]) + extension;
+        page.root = tile.root;
+        pages.push_back(page);
+
+        // nothing is drawn for the tile until it's close enough to be loaded
+        auto pagedLOD = vsg::PagedLOD::create();
+        pagedLOD->bound = tile.bounds.sphere();
+        pagedLOD->filename = page.fileName;
+        pagedLOD->children[0].minimumScreenHeightRatio = minimumScreenHeightRatio;
+        pagedLOD->children[1].minimumScreenHeightRatio = 0.0;
+        root->addChild(pagedLOD);
+    }
+    return pages;
+}
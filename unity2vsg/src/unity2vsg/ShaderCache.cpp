@@ -0,0 +1,306 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/ShaderCache.h>
+
+#include <unity2vsg/DebugLog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace unity2vsg;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // bump when the compiler setup changes in a way that makes existing entries invalid
+    const uint32_t CACHE_VERSION = 1;
+
+    // entry file layout, EntryHeader followed by wordCount spirv words
+    struct EntryHeader
+    {
+        char magic[8] = {'v', 's', 'g', 's', 'p', 'i', 'r', 'v'};
+        uint32_t version = CACHE_VERSION;
+        uint32_t wordCount = 0;
+        uint64_t checksum = 0;
+    };
+
+    uint64_t fnv1a(const void* data, size_t size, uint64_t hash)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    const uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325ull;
+
+    inline uint64_t rotl64(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t fmix64(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xFF51AFD7ED558CCDull;
+        k ^= k >> 33;
+        k *= 0xC4CEB9FE1A85EC53ull;
+        k ^= k >> 33;
+        return k;
+    }
+
+    // MurmurHash3 x64 128, the halves are mixed into each other every block so the key is a true 128 bit hash
+    void murmur3_128(const void* data, size_t size, uint64_t& h1, uint64_t& h2)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        const uint64_t c1 = 0x87C37B91114253D5ull;
+        const uint64_t c2 = 0x4CF5AD432745937Full;
+
+        size_t blocks = size / 16;
+        for (size_t i = 0; i < blocks; i++)
+        {
+            uint64_t k1, k2;
+            std::memcpy(&k1, bytes + i * 16, sizeof(uint64_t));
+            std::memcpy(&k2, bytes + i * 16 + 8, sizeof(uint64_t));
+
+            k1 *= c1;
+            k1 = rotl64(k1, 31);
+            k1 *= c2;
+            h1 ^= k1;
+            h1 = rotl64(h1, 27);
+            h1 += h2;
+            h1 = h1 * 5 + 0x52DCE729;
+
+            k2 *= c2;
+            k2 = rotl64(k2, 33);
+            k2 *= c1;
+            h2 ^= k2;
+            h2 = rotl64(h2, 31);
+            h2 += h1;
+            h2 = h2 * 5 + 0x38495AB5;
+        }
+
+        const uint8_t* tail = bytes + blocks * 16;
+        uint64_t k1 = 0;
+        uint64_t k2 = 0;
+        size_t remaining = size & 15;
+        for (size_t i = remaining; i > 8; i--) k2 ^= static_cast<uint64_t>(tail[i - 1]) << ((i - 9) * 8);
+        for (size_t i = std::min<size_t>(remaining, 8); i > 0; i--) k1 ^= static_cast<uint64_t>(tail[i - 1]) << ((i - 1) * 8);
+        if (remaining > 8)
+        {
+            k2 *= c2;
+            k2 = rotl64(k2, 33);
+            k2 *= c1;
+            h2 ^= k2;
+        }
+        if (remaining > 0)
+        {
+            k1 *= c1;
+            k1 = rotl64(k1, 31);
+            k1 *= c2;
+            h1 ^= k1;
+        }
+
+        h1 ^= size;
+        h2 ^= size;
+        h1 += h2;
+        h2 += h1;
+        h1 = fmix64(h1);
+        h2 = fmix64(h2);
+        h1 += h2;
+        h2 += h1;
+    }
+} // namespace
+
+ShaderCache::ShaderCache(const std::string& directory, uint64_t maxSize) :
+    _directory(directory),
+    _maxSize(maxSize),
+    _valid(false),
+    _hits(0),
+    _misses(0),
+    _writes(0),
+    _evictions(0)
+{
+    std::error_code ec;
+    fs::create_directories(_directory, ec);
+    _valid = fs::is_directory(_directory, ec);
+    if (!_valid) DebugLog("ShaderCache Error: Unable to create cache directory '" + _directory + "', shaders will not be cached.");
+}
+
+std::string ShaderCache::createKey(VkShaderStageFlagBits stage, const std::string& source, uint32_t optimization, bool stripDebugInfo)
+{
+    // a 128 bit hash of the options followed by the source, so collisions across a large catalogue aren't a concern
+    uint32_t options[4] = {CACHE_VERSION, static_cast<uint32_t>(stage), optimization, stripDebugInfo ? 1u : 0u};
+
+    std::string keySource(reinterpret_cast<const char*>(options), sizeof(options));
+    keySource += source;
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    murmur3_128(keySource.data(), keySource.size(), a, b);
+
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(16) << a << std::setw(16) << b;
+    return ss.str();
+}
+
+std::string ShaderCache::entryFileName(const std::string& key) const
+{
+    return (fs::path(_directory) / (key + ".spv")).string();
+}
+
+bool ShaderCache::read(const std::string& key, vsg::ShaderModule::SPIRV& spirv)
+{
+    if (!_valid) return false;
+
+    std::string fileName = entryFileName(key);
+    std::ifstream fin(fileName, std::ios::binary);
+    if (!fin.is_open())
+    {
+        _misses++;
+        return false;
+    }
+
+    EntryHeader expected;
+    EntryHeader header;
+    fin.read(reinterpret_cast<char*>(&header), sizeof(EntryHeader));
+
+    bool ok = fin.good() && std::equal(header.magic, header.magic + 8, expected.magic) && header.version == CACHE_VERSION && header.wordCount > 0;
+    if (ok)
+    {
+        spirv.resize(header.wordCount);
+        fin.read(reinterpret_cast<char*>(spirv.data()), header.wordCount * sizeof(uint32_t));
+        ok = fin.good() && fnv1a(spirv.data(), spirv.size() * sizeof(uint32_t), FNV_OFFSET_BASIS) == header.checksum;
+    }
+    fin.close();
+
+    std::error_code ec;
+    if (!ok)
+    {
+        // corrupt or from another version, remove it so it gets rewritten
+        DebugLog("ShaderCache Warning: Discarding invalid cache entry '" + fileName + "'.");
+        fs::remove(fileName, ec);
+        spirv.clear();
+        _misses++;
+        return false;
+    }
+
+    // refresh the time so the entry counts as recently used when trimming
+    fs::last_write_time(fileName, fs::file_time_type::clock::now(), ec);
+
+    _hits++;
+    return true;
+}
+
+void ShaderCache::write(const std::string& key, const vsg::ShaderModule::SPIRV& spirv)
+{
+    if (!_valid || spirv.empty()) return;
+
+    EntryHeader header;
+    header.wordCount = static_cast<uint32_t>(spirv.size());
+    header.checksum = fnv1a(spirv.data(), spirv.size() * sizeof(uint32_t), FNV_OFFSET_BASIS);
+
+    // write to a uniquely named temporary then rename it into place, rename replaces atomically so concurrent
+    // writers of the same entry simply race to put identical content in place
+    static std::atomic<uint32_t> s_counter(0);
+    std::random_device random;
+    std::string fileName = entryFileName(key);
+    std::string tempFileName = fileName + "." + std::to_string(random()) + "." + std::to_string(s_counter++) + ".tmp";
+
+    {
+        std::ofstream fout(tempFileName, std::ios::binary);
+        if (!fout.is_open()) return;
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(EntryHeader));
+        fout.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+        if (!fout.good())
+        {
+            fout.close();
+            std::error_code ec;
+            fs::remove(tempFileName, ec);
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tempFileName, fileName, ec);
+    if (ec)
+    {
+        fs::remove(tempFileName, ec);
+        return;
+    }
+
+    _writes++;
+}
+
+void ShaderCache::trim()
+{
+    if (!_valid || _maxSize == 0) return;
+
+    struct Entry
+    {
+        fs::path path;
+        uint64_t size;
+        fs::file_time_type time;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t totalSize = 0;
+
+    std::error_code ec;
+    for (auto& file : fs::directory_iterator(_directory, ec))
+    {
+        if (file.path().extension() != ".spv") continue;
+
+        std::error_code fileError;
+        Entry entry{file.path(), file.file_size(fileError), file.last_write_time(fileError)};
+        if (fileError) continue; // removed by another process while we were looking
+
+        totalSize += entry.size;
+        entries.push_back(entry);
+    }
+
+    if (totalSize <= _maxSize) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+
+    for (auto& entry : entries)
+    {
+        if (totalSize <= _maxSize) break;
+        if (fs::remove(entry.path, ec)) _evictions++;
+        totalSize -= entry.size;
+    }
+}
+
+std::string ShaderCache::statistics() const
+{
+    uint32_t hits = _hits;
+    uint32_t misses = _misses;
+    uint32_t lookups = hits + misses;
+
+    std::ostringstream ss;
+    ss << "ShaderCache: " << hits << " hits, " << misses << " misses";
+    if (lookups > 0) ss << " (" << (hits * 100 / lookups) << "% hit rate)";
+    ss << ", " << _writes << " writes, " << _evictions << " evictions";
+    return ss.str();
+}
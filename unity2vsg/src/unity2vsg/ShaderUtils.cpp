@@ -1,12 +1,18 @@
 #include <unity2vsg/ShaderUtils.h>
 
+#include <unity2vsg/DebugLog.h>
+#include <unity2vsg/GLSLPreprocessor.h>
+
 #include <glslang/SPIRV/GlslangToSpv.h>
 #include <glslang/Public/ShaderLang.h>
 
 #include "glsllang/ResourceLimits.h"
 
 #include <algorithm>
+#include <filesystem>
 #include <iomanip>
+#include <map>
+#include <mutex>
 
 using namespace unity2vsg;
 
@@ -60,134 +66,146 @@ std::vector<std::string> createPSCDefineStrings(const uint32_t& shaderModeMask,
 
 // insert defines string after the version in source
 
-std::string processGLSLShaderSource(const std::string& source, const std::vector<std::string>& defines)
+// feature toggles available as specialization constants
+
+const std::vector<SpecializedFeature>& unity2vsg::specializedShaderFeatures()
 {
-    // trim leading spaces/tabs
-    auto trimLeading = [](std::string& str) {
-        size_t startpos = str.find_first_not_of(" \t");
-        if (std::string::npos != startpos)
-        {
-            str = str.substr(startpos);
-        }
-    };
+    // ids start at 100 to stay clear of the constants materials pass in from unity, bindings match the standard shader
+    static const std::vector<SpecializedFeature> s_features = {
+        {"VSG_LIGHTING", 100, -1},
+        {"VSG_NORMAL_MAP", 101, 5},
+        {"VSG_DIFFUSE_MAP", 102, 0},
+        {"VSG_OPACITY_MAP", 103, 1},
+        {"VSG_BILLBOARD", 104, -1}};
+    return s_features;
+}
 
-    // trim trailing spaces/tabs/newlines
-    auto trimTrailing = [](std::string& str) {
-        size_t endpos = str.find_last_not_of(" \t\n");
-        if (endpos != std::string::npos)
-        {
-            str = str.substr(0, endpos + 1);
-        }
-    };
+// includes are read through the same cache as the shaders themselves
+bool readGLSLInclude(const std::string& filename, std::string& source)
+{
+    uint64_t hash;
+    return readGLSLSource(filename, source, hash);
+}
 
-    // sanitise line by triming leading and trailing characters
-    auto sanitise = [&trimLeading, &trimTrailing](std::string& str) {
-        trimLeading(str);
-        trimTrailing(str);
-    };
+std::string processGLSLShaderSource(const std::string& source, const std::vector<std::string>& defines, const std::string& filename = std::string())
+{
+    return preprocessGLSLSource(source, defines, filename, readGLSLInclude);
+}
+
+// cached raw glsl sources
 
-    // return true if str starts with match string
-    auto startsWith = [](const std::string& str, const std::string& match) {
-        return str.compare(0, match.length(), match) == 0;
+bool unity2vsg::readGLSLSource(const std::string& filename, std::string& source, uint64_t& hash)
+{
+    struct SourceEntry
+    {
+        std::filesystem::file_time_type modified;
+        std::string source;
+        uint64_t hash;
     };
 
-    // returns the string between the start and end character
-    auto stringBetween = [](const std::string& str, const char& startChar, const char& endChar) {
-        auto start = str.find_first_of(startChar);
-        if (start == std::string::npos) return std::string();
+    // shared by every export in the session, only the modification time decides when a file is read again
+    static std::map<std::string, SourceEntry> s_sources;
+    static std::mutex s_mutex;
 
-        auto end = str.find_first_of(endChar, start);
-        if (end == std::string::npos) return std::string();
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(filename, ec);
 
-        if ((end - start) - 1 == 0) return std::string();
+    std::lock_guard<std::mutex> lock(s_mutex);
 
-        return str.substr(start + 1, (end - start) - 1);
-    };
+    auto itr = s_sources.find(filename);
+    if (!ec && itr != s_sources.end() && itr->second.modified == modified)
+    {
+        source = itr->second.source;
+        hash = itr->second.hash;
+        return true;
+    }
 
-    auto split = [](const std::string& str, const char& seperator) {
-        std::vector<std::string> elements;
+    std::string sourceBuffer;
+    if (!vsg::readFile(sourceBuffer, filename))
+    {
+        DEBUG_OUTPUT << "readGLSLSource: Failed to read file '" << filename << std::endl;
+        return false;
+    }
 
-        std::string::size_type prev_pos = 0, pos = 0;
+    // fnv-1a
+    uint64_t sourceHash = 0xCBF29CE484222325ull;
+    for (unsigned char c : sourceBuffer)
+    {
+        sourceHash ^= c;
+        sourceHash *= 0x100000001B3ull;
+    }
 
-        while ((pos = str.find(seperator, pos)) != std::string::npos)
+    s_sources[filename] = SourceEntry{modified, sourceBuffer, sourceHash};
+
+    source = sourceBuffer;
+    hash = sourceHash;
+    return true;
+}
+
+bool unity2vsg::hashGLSLIncludes(const std::string& source, const std::string& filename, uint64_t& hash)
+{
+    bool readable = true;
+    auto hashingReader = [&](const std::string& includeFile, std::string& includeSource) {
+        uint64_t includeHash;
+        if (!readGLSLSource(includeFile, includeSource, includeHash))
         {
-            auto substring = str.substr(prev_pos, pos - prev_pos);
-            elements.push_back(substring);
-            prev_pos = ++pos;
+            readable = false;
+            return false;
         }
+        hash = (hash ^ includeHash) * 0x100000001B3ull;
+        return true;
+    };
 
-        elements.push_back(str.substr(prev_pos, pos - prev_pos));
+    importedGLSLDefines(source, filename, hashingReader);
+    return readable;
+}
 
-        return elements;
-    };
+// canonical define set for a variant
 
-    auto addLine = [](std::ostringstream& ss, const std::string& line) {
-        ss << line << "\n";
-    };
+std::vector<std::string> unity2vsg::createCanonicalDefines(const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines)
+{
+    std::vector<std::string> defines;
+    for (auto define : createPSCDefineStrings(shaderModeMask, geometryAttrbutes, customDefines))
+    {
+        size_t start = define.find_first_not_of(" \t");
+        if (start == std::string::npos) continue;
+        size_t end = define.find_last_not_of(" \t\n\r");
+        defines.push_back(define.substr(start, end - start + 1));
+    }
 
-    std::istringstream iss(source);
-    std::ostringstream headerstream;
-    std::ostringstream sourcestream;
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+    return defines;
+}
 
-    const std::string versionmatch = "#version";
-    const std::string importdefinesmatch = "#pragma import_defines";
+// reduce a define set to the defines the source actually imports
 
-    std::vector<std::string> finaldefines;
+std::vector<std::string> unity2vsg::filterImportedDefines(const std::string& source, const std::vector<std::string>& defines, const std::string& filename)
+{
+    auto imported = importedGLSLDefines(source, filename, readGLSLInclude);
 
-    for (std::string line; std::getline(iss, line);)
+    std::vector<std::string> filtered;
+    for (auto& define : defines)
     {
-        std::string sanitisedline = line;
-        sanitise(sanitisedline);
-
-        // is it the version
-        if (startsWith(sanitisedline, versionmatch))
-        {
-            addLine(headerstream, line);
-        }
-        // is it the defines import
-        else if (startsWith(sanitisedline, importdefinesmatch))
-        {
-            // get the import defines between ()
-            auto csv = stringBetween(sanitisedline, '(', ')');
-            auto importedDefines = split(csv, ',');
-
-            addLine(headerstream, line);
-
-            // loop the imported defines and see if it's also requested in defines, if so insert a define line
-            for (auto importedDef : importedDefines)
-            {
-                auto sanitiesedImportDef = importedDef;
-                sanitise(sanitiesedImportDef);
-
-                auto finditr = std::find(defines.begin(), defines.end(), sanitiesedImportDef);
-                if (finditr != defines.end())
-                {
-                    addLine(headerstream, "#define " + sanitiesedImportDef);
-                }
-            }
-        }
-        else
-        {
-            // standard source line
-            addLine(sourcestream, line);
-        }
+        if (std::find(imported.begin(), imported.end(), define) != imported.end()) filtered.push_back(define);
     }
+    return filtered;
+}
 
-    return headerstream.str() + sourcestream.str();
+std::string unity2vsg::preprocessGLSLShader(const std::string& source, const std::vector<std::string>& defines, const std::string& filename)
+{
+    return processGLSLShaderSource(source, defines, filename);
 }
 
 // read a glsl file and inject defines based on shadermodemask and geometryatts
 std::string unity2vsg::readGLSLShader(const std::string& filename, const uint32_t& shaderModeMask, const uint32_t& geometryAttrbutes, const std::vector<std::string>& customDefines)
 {
     std::string sourceBuffer;
-    if (!vsg::readFile(sourceBuffer, filename))
-    {
-        DEBUG_OUTPUT << "readGLSLShader: Failed to read file '" << filename << std::endl;
-        return std::string();
-    }
+    uint64_t hash;
+    if (!readGLSLSource(filename, sourceBuffer, hash)) return std::string();
 
-    auto defines = createPSCDefineStrings(shaderModeMask, geometryAttrbutes, customDefines);
-    std::string formatedSource = processGLSLShaderSource(sourceBuffer, defines);
+    auto defines = createCanonicalDefines(shaderModeMask, geometryAttrbutes, customDefines);
+    std::string formatedSource = processGLSLShaderSource(sourceBuffer, defines, filename);
     return formatedSource;
 }
 
@@ -398,3 +416,133 @@ std::string unity2vsg::createFbxFragmentSource(const uint32_t& shaderModeMask, c
 
     return formatedSource;
 }
+
+// per thread glslang setup, InitializeProcess is reference counted so it's safe to pair per thread
+
+void unity2vsg::initializeShaderCompilerThread()
+{
+    glslang::InitializeProcess();
+}
+
+void unity2vsg::finalizeShaderCompilerThread()
+{
+    glslang::FinalizeProcess();
+}
+
+// compile glsl source to spirv using glslang
+
+bool unity2vsg::compileGLSLToSPIRV(VkShaderStageFlagBits stage, const std::string& source, uint32_t optimization, bool stripDebugInfo, vsg::ShaderModule::SPIRV& spirv)
+{
+    static std::once_flag s_initialized;
+    std::call_once(s_initialized, []() { glslang::InitializeProcess(); });
+
+    EShLanguage language;
+    switch (stage)
+    {
+    case VK_SHADER_STAGE_VERTEX_BIT: language = EShLangVertex; break;
+    case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: language = EShLangTessControl; break;
+    case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: language = EShLangTessEvaluation; break;
+    case VK_SHADER_STAGE_GEOMETRY_BIT: language = EShLangGeometry; break;
+    case VK_SHADER_STAGE_FRAGMENT_BIT: language = EShLangFragment; break;
+    case VK_SHADER_STAGE_COMPUTE_BIT: language = EShLangCompute; break;
+    default:
+        DebugLog("ShaderUtils Error: Unsupported shader stage for SPIR-V compilation");
+        return false;
+    }
+
+    const char* str = source.c_str();
+    glslang::TShader shader(language);
+    shader.setStrings(&str, 1);
+    shader.setEnvInput(glslang::EShSourceGlsl, language, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, glslang::EShTargetVulkan_1_0);
+    shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+
+    EShMessages messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+    if (!shader.parse(&glslang::DefaultTBuiltInResource, 450, false, messages))
+    {
+        DebugLog("ShaderUtils Error: Failed to compile shader\n" + std::string(shader.getInfoLog()) + std::string(shader.getInfoDebugLog()));
+        return false;
+    }
+
+    glslang::TProgram program;
+    program.addShader(&shader);
+    if (!program.link(messages))
+    {
+        DebugLog("ShaderUtils Error: Failed to link shader\n" + std::string(program.getInfoLog()) + std::string(program.getInfoDebugLog()));
+        return false;
+    }
+
+    glslang::SpvOptions spvOptions;
+    spvOptions.generateDebugInfo = !stripDebugInfo;
+    spvOptions.disableOptimizer = optimization == SHADER_OPTIMIZATION_NONE;
+    spvOptions.optimizeSize = optimization == SHADER_OPTIMIZATION_SIZE;
+
+    spv::SpvBuildLogger logger;
+    spirv.clear();
+    glslang::GlslangToSpv(*program.getIntermediate(language), spirv, &logger, &spvOptions);
+
+    std::string messagesLog = logger.getAllMessages();
+    if (!messagesLog.empty()) DebugLog("ShaderUtils Warning: " + messagesLog);
+
+    if (spirv.empty())
+    {
+        DebugLog("ShaderUtils Error: SPIR-V generation produced no code");
+        return false;
+    }
+
+    if (stripDebugInfo) stripSPIRVDebugInfo(spirv);
+
+    return true;
+}
+
+// strip debug instructions from a spirv binary
+
+void unity2vsg::stripSPIRVDebugInfo(vsg::ShaderModule::SPIRV& spirv)
+{
+    // spirv opcodes of the debug instructions, these have no effect on the semantics of the module
+    auto isDebugInstruction = [](uint32_t opcode) {
+        switch (opcode)
+        {
+        case 2:   // OpSourceContinued
+        case 3:   // OpSource
+        case 4:   // OpSourceExtension
+        case 5:   // OpName
+        case 6:   // OpMemberName
+        case 7:   // OpString
+        case 8:   // OpLine
+        case 317: // OpNoLine
+        case 330: // OpModuleProcessed
+            return true;
+        default:
+            return false;
+        }
+    };
+
+    const size_t headerSize = 5;
+    if (spirv.size() <= headerSize) return;
+
+    size_t write = headerSize;
+    size_t read = headerSize;
+    while (read < spirv.size())
+    {
+        uint32_t wordCount = spirv[read] >> 16;
+        uint32_t opcode = spirv[read] & 0xFFFF;
+        if (wordCount == 0 || read + wordCount > spirv.size()) break; // malformed, leave the rest untouched
+
+        if (!isDebugInstruction(opcode))
+        {
+            if (write != read) std::copy(spirv.begin() + read, spirv.begin() + read + wordCount, spirv.begin() + write);
+            write += wordCount;
+        }
+        read += wordCount;
+    }
+
+    // copy any trailing words we couldn't parse
+    if (read < spirv.size())
+    {
+        std::copy(spirv.begin() + read, spirv.end(), spirv.begin() + write);
+        write += spirv.size() - read;
+    }
+
+    spirv.resize(write);
+}
@@ -0,0 +1,285 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/StateSorting.h>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <typeinfo>
+
+using namespace unity2vsg;
+
+namespace
+{
+    bool isDraw(vsg::Object& object)
+    {
+        return dynamic_cast<vsg::VertexIndexDraw*>(&object) || dynamic_cast<vsg::Geometry*>(&object) ||
+               dynamic_cast<vsg::Draw*>(&object) || dynamic_cast<vsg::DrawIndexed*>(&object);
+    }
+
+    // tracks the pipeline and descriptor set each draw needs against the ones last bound
+    class StateChangeCounter : public vsg::Visitor
+    {
+    public:
+        StateChangeCount count;
+
+        void apply(vsg::Object& object) override
+        {
+            vsg::Object* pipeline = _pipeline;
+            vsg::Object* descriptorSet = _descriptorSet;
+
+            // binds in a commands node are recorded straight away and last until the end of the node
+            if (dynamic_cast<vsg::BindGraphicsPipeline*>(&object))
+            {
+                _pipeline = &object;
+                bind(_pipeline, _boundPipeline, count.pipelines);
+            }
+            else if (dynamic_cast<vsg::BindDescriptorSet*>(&object))
+            {
+                _descriptorSet = &object;
+                bind(_descriptorSet, _boundDescriptorSet, count.descriptorSets);
+            }
+            else if (isDraw(object))
+            {
+                if (_pipeline) bind(_pipeline, _boundPipeline, count.pipelines);
+                if (_descriptorSet) bind(_descriptorSet, _boundDescriptorSet, count.descriptorSets);
+            }
+
+            object.traverse(*this);
+
+            if (dynamic_cast<vsg::Commands*>(&object))
+            {
+                _pipeline = pipeline;
+                _descriptorSet = descriptorSet;
+            }
+        }
+
+        void apply(vsg::StateGroup& stategroup) override
+        {
+            vsg::Object* pipeline = _pipeline;
+            vsg::Object* descriptorSet = _descriptorSet;
+
+            for (auto& command : stategroup.stateCommands)
+            {
+                if (dynamic_cast<vsg::BindGraphicsPipeline*>(command.get())) _pipeline = command.get();
+                else if (dynamic_cast<vsg::BindDescriptorSet*>(command.get())) _descriptorSet = command.get();
+            }
+
+            stategroup.traverse(*this);
+
+            _pipeline = pipeline;
+            _descriptorSet = descriptorSet;
+        }
+
+    private:
+        static void bind(vsg::Object* state, vsg::Object*& bound, uint32_t& changes)
+        {
+            if (state == bound) return;
+            bound = state;
+            changes++;
+        }
+
+        vsg::Object* _pipeline = nullptr;
+        vsg::Object* _descriptorSet = nullptr;
+        vsg::Object* _boundPipeline = nullptr;
+        vsg::Object* _boundDescriptorSet = nullptr;
+    };
+
+    // the first pipeline and descriptor set a subgraph binds and whether any of its pipelines blend
+    class FirstStateVisitor : public vsg::Visitor
+    {
+    public:
+        explicit FirstStateVisitor(const std::set<vsg::GraphicsPipeline*>& blendedPipelines) :
+            _blendedPipelines(blendedPipelines) {}
+
+        vsg::Object* pipeline = nullptr;
+        vsg::Object* descriptorSet = nullptr;
+        bool blended = false;
+
+        void apply(vsg::Object& object) override
+        {
+            state(&object);
+            object.traverse(*this);
+        }
+
+        void apply(vsg::StateGroup& stategroup) override
+        {
+            for (auto& command : stategroup.stateCommands) state(command.get());
+            stategroup.traverse(*this);
+        }
+
+    private:
+        void state(vsg::Object* object)
+        {
+            if (auto bindPipeline = dynamic_cast<vsg::BindGraphicsPipeline*>(object))
+            {
+                if (!pipeline) pipeline = object;
+                if (_blendedPipelines.find(bindPipeline->pipeline.get()) != _blendedPipelines.end()) blended = true;
+            }
+            else if (!descriptorSet && dynamic_cast<vsg::BindDescriptorSet*>(object))
+            {
+                descriptorSet = object;
+            }
+        }
+
+        const std::set<vsg::GraphicsPipeline*>& _blendedPipelines;
+    };
+
+    class StateSorter : public vsg::Visitor
+    {
+    public:
+        explicit StateSorter(const std::set<vsg::GraphicsPipeline*>& blendedPipelines) :
+            _blendedPipelines(blendedPipelines) {}
+
+        void apply(vsg::Object& object) override
+        {
+            object.traverse(*this);
+        }
+
+        // children are sorted before their parent so each level orders subgraphs by the state they start with once sorted
+        void apply(vsg::Group& group) override
+        {
+            group.traverse(*this);
+            mergeStateGroups(group);
+            sortChildren(group);
+        }
+
+    private:
+        // opaque before blended, then pipelines and descriptor sets in the order they're first seen. subgraphs with no state sort first
+        using StateKey = std::tuple<bool, size_t, size_t>;
+
+        StateKey stateKey(vsg::Node* node)
+        {
+            FirstStateVisitor firstState(_blendedPipelines);
+            node->accept(firstState);
+
+            auto order = [](std::map<vsg::Object*, size_t>& orders, vsg::Object* state) -> size_t {
+                if (!state) return 0;
+                auto itr = orders.find(state);
+                if (itr != orders.end()) return itr->second;
+                size_t index = orders.size() + 1;
+                orders[state] = index;
+                return index;
+            };
+
+            // blended subgraphs all share one key so the stable sort keeps their relative order
+            if (firstState.blended) return StateKey(true, 0, 0);
+            return StateKey(false, order(_pipelineOrders, firstState.pipeline), order(_descriptorSetOrders, firstState.descriptorSet));
+        }
+
+        void sortChildren(vsg::Group& group)
+        {
+            if (group.children.size() < 2) return;
+
+            std::vector<std::pair<StateKey, vsg::ref_ptr<vsg::Node>>> keyed;
+            for (auto& child : group.children) keyed.emplace_back(stateKey(child.get()), child);
+
+            std::stable_sort(keyed.begin(), keyed.end(), [](const std::pair<StateKey, vsg::ref_ptr<vsg::Node>>& lhs, const std::pair<StateKey, vsg::ref_ptr<vsg::Node>>& rhs) {
+                return lhs.first < rhs.first;
+            });
+
+            for (size_t i = 0; i < keyed.size(); i++) group.children[i] = keyed[i].second;
+        }
+
+        // a plain stategroup binding an opaque pipeline first that can be merged with its siblings binding the same pipeline
+        vsg::StateGroup* mergeableStateGroup(vsg::Node* node)
+        {
+            if (typeid(*node) != typeid(vsg::StateGroup)) return nullptr;
+
+            auto stategroup = static_cast<vsg::StateGroup*>(node);
+            if (stategroup->getAuxiliary() || stategroup->stateCommands.empty()) return nullptr;
+
+            auto bindPipeline = dynamic_cast<vsg::BindGraphicsPipeline*>(stategroup->stateCommands.front().get());
+            if (!bindPipeline || _blendedPipelines.find(bindPipeline->pipeline.get()) != _blendedPipelines.end()) return nullptr;
+
+            return stategroup;
+        }
+
+        // sibling stategroups binding the same pipeline become one stategroup binding it, holding a stategroup for each distinct set of
+        // remaining state with the children of every stategroup that had it
+        void mergeStateGroups(vsg::Group& group)
+        {
+            std::map<vsg::StateCommand*, size_t> pipelineCounts;
+            for (auto& child : group.children)
+            {
+                if (auto stategroup = mergeableStateGroup(child.get())) pipelineCounts[stategroup->stateCommands.front().get()]++;
+            }
+
+            vsg::Group::Children children;
+            std::map<vsg::StateCommand*, vsg::ref_ptr<vsg::StateGroup>> pipelineGroups;
+            std::map<std::vector<vsg::StateCommand*>, vsg::ref_ptr<vsg::StateGroup>> stateGroups;
+            std::vector<vsg::StateGroup*> createdGroups;
+
+            for (auto& child : group.children)
+            {
+                auto stategroup = mergeableStateGroup(child.get());
+                if (!stategroup || pipelineCounts[stategroup->stateCommands.front().get()] < 2)
+                {
+                    children.push_back(child);
+                    continue;
+                }
+
+                auto& bindPipeline = stategroup->stateCommands.front();
+                auto& pipelineGroup = pipelineGroups[bindPipeline.get()];
+                if (!pipelineGroup)
+                {
+                    pipelineGroup = vsg::StateGroup::create();
+                    pipelineGroup->add(bindPipeline);
+                    children.push_back(pipelineGroup);
+                    createdGroups.push_back(pipelineGroup.get());
+                }
+
+                if (stategroup->stateCommands.size() == 1)
+                {
+                    for (auto& grandchild : stategroup->children) pipelineGroup->addChild(grandchild);
+                    continue;
+                }
+
+                std::vector<vsg::StateCommand*> stateKey;
+                for (auto& command : stategroup->stateCommands) stateKey.push_back(command.get());
+
+                auto& stateGroup = stateGroups[stateKey];
+                if (!stateGroup)
+                {
+                    stateGroup = vsg::StateGroup::create();
+                    for (size_t i = 1; i < stategroup->stateCommands.size(); i++) stateGroup->add(stategroup->stateCommands[i]);
+                    pipelineGroup->addChild(stateGroup);
+                    createdGroups.push_back(stateGroup.get());
+                }
+                for (auto& grandchild : stategroup->children) stateGroup->addChild(grandchild);
+            }
+
+            if (createdGroups.empty()) return;
+
+            group.children = children;
+            for (auto createdGroup : createdGroups) sortChildren(*createdGroup);
+        }
+
+        const std::set<vsg::GraphicsPipeline*>& _blendedPipelines;
+        std::map<vsg::Object*, size_t> _pipelineOrders;
+        std::map<vsg::Object*, size_t> _descriptorSetOrders;
+    };
+} // namespace
+
+StateChangeCount unity2vsg::countStateChanges(vsg::Node* root)
+{
+    StateChangeCounter counter;
+    root->accept(counter);
+    return counter.count;
+}
+
+void unity2vsg::sortStateGroups(vsg::Node* root, const std::set<vsg::GraphicsPipeline*>& blendedPipelines)
+{
+    StateSorter sorter(blendedPipelines);
+    root->accept(sorter);
+}
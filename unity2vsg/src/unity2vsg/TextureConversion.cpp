@@ -0,0 +1,265 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/TextureConversion.h>
+
+#include <unity2vsg/DebugLog.h>
+
+#include <algorithm>
+#include <cstring>
+
+// the ssse3 kernels are compiled for that target whatever the build's flags and only run on cpus that report it
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <tmmintrin.h>
+#define UNITY2VSG_SSSE3
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define UNITY2VSG_TARGET_SSSE3
+#else
+#define UNITY2VSG_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
+using namespace unity2vsg;
+
+namespace
+{
+    //
+    // kernels, each converts count texels from src to dst, dst is always 4 components
+    //
+
+#if defined(UNITY2VSG_SSSE3)
+    bool cpuHasSSSE3()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 9)) != 0;
+#else
+        return __builtin_cpu_supports("ssse3");
+#endif
+    }
+
+    const bool hasSSSE3 = cpuHasSSSE3();
+
+    // the ssse3 halves of the kernels below, each returns the number of texels it converted
+    template<int R, int G, int B>
+    UNITY2VSG_TARGET_SSSE3 size_t expand3x8SSSE3(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        // 4 texels per iteration, the 16 byte load reads 4 bytes past the 12 we use so stop 6 texels short of the end
+        const __m128i shuffle = _mm_setr_epi8(R, G, B, -1, 3 + R, 3 + G, 3 + B, -1, 6 + R, 6 + G, 6 + B, -1, 9 + R, 9 + G, 9 + B, -1);
+        const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+        size_t i = 0;
+        for (; i + 6 <= count; i += 4)
+        {
+            __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+            texels = _mm_or_si128(_mm_shuffle_epi8(texels, shuffle), alpha);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), texels);
+        }
+        return i;
+    }
+
+    template<int R, int G, int B, int A>
+    UNITY2VSG_TARGET_SSSE3 size_t swizzle4x8SSSE3(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        const __m128i shuffle = _mm_setr_epi8(R, G, B, A, 4 + R, 4 + G, 4 + B, 4 + A, 8 + R, 8 + G, 8 + B, 8 + A, 12 + R, 12 + G, 12 + B, 12 + A);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_shuffle_epi8(texels, shuffle));
+        }
+        return i;
+    }
+#endif
+
+    // expand 3 byte texels to 4 bytes, order gives the source byte for the destination r, g and b
+    template<int R, int G, int B>
+    void expand3x8(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(UNITY2VSG_SSSE3)
+        if (hasSSSE3) i = expand3x8SSSE3<R, G, B>(src, dst, count);
+#endif
+        for (; i < count; i++)
+        {
+            const uint8_t* s = src + i * 3;
+            uint8_t* d = dst + i * 4;
+            d[0] = s[R];
+            d[1] = s[G];
+            d[2] = s[B];
+            d[3] = 255;
+        }
+    }
+
+    // reorder 4 byte texels, order gives the source byte for the destination r, g, b and a
+    template<int R, int G, int B, int A>
+    void swizzle4x8(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        size_t i = 0;
+#if defined(UNITY2VSG_SSSE3)
+        if (hasSSSE3) i = swizzle4x8SSSE3<R, G, B, A>(src, dst, count);
+#endif
+        for (; i < count; i++)
+        {
+            const uint8_t* s = src + i * 4;
+            uint8_t* d = dst + i * 4;
+            d[0] = s[R];
+            d[1] = s[G];
+            d[2] = s[B];
+            d[3] = s[A];
+        }
+    }
+
+    // alpha only textures sample as white with the source alpha
+    void alpha8(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        uint32_t* d = reinterpret_cast<uint32_t*>(dst);
+        for (size_t i = 0; i < count; i++)
+        {
+            d[i] = 0x00FFFFFFu | (static_cast<uint32_t>(src[i]) << 24);
+        }
+    }
+
+    void r5g6b5(const uint8_t* src, uint8_t* dst, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            uint16_t texel;
+            std::memcpy(&texel, src + i * 2, sizeof(uint16_t));
+            uint32_t r = (texel >> 11) & 0x1F;
+            uint32_t g = (texel >> 5) & 0x3F;
+            uint32_t b = texel & 0x1F;
+            uint8_t* d = dst + i * 4;
+            d[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+            d[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+            d[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+            d[3] = 255;
+        }
+    }
+
+    // append an alpha of one to 3 component texels of T
+    template<typename T>
+    void expand3(const uint8_t* src, uint8_t* dst, size_t count, T one)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            std::memcpy(dst + i * 4 * sizeof(T), src + i * 3 * sizeof(T), 3 * sizeof(T));
+            std::memcpy(dst + (i * 4 + 3) * sizeof(T), &one, sizeof(T));
+        }
+    }
+
+    uint32_t sourceTexelSize(ImageSourceFormat format)
+    {
+        switch (format)
+        {
+        case IMAGE_SOURCE_FORMAT_R8G8B8:
+        case IMAGE_SOURCE_FORMAT_B8G8R8: return 3;
+        case IMAGE_SOURCE_FORMAT_A8R8G8B8:
+        case IMAGE_SOURCE_FORMAT_B8G8R8A8: return 4;
+        case IMAGE_SOURCE_FORMAT_A8: return 1;
+        case IMAGE_SOURCE_FORMAT_R5G6B5_PACK16: return 2;
+        case IMAGE_SOURCE_FORMAT_R16G16B16_SFLOAT: return 6;
+        case IMAGE_SOURCE_FORMAT_R32G32B32_SFLOAT: return 12;
+        default: break;
+        }
+        return 0;
+    }
+
+    // the size in bytes of the texels a source format must be converted into
+    uint32_t destinationTexelSize(ImageSourceFormat format)
+    {
+        switch (format)
+        {
+        case IMAGE_SOURCE_FORMAT_R16G16B16_SFLOAT: return 8;
+        case IMAGE_SOURCE_FORMAT_R32G32B32_SFLOAT: return 16;
+        default: break;
+        }
+        return 4;
+    }
+} // namespace
+
+bool unity2vsg::requiresFormatConversion(const ImageData& data)
+{
+    return data.sourceFormat != IMAGE_SOURCE_FORMAT_NATIVE;
+}
+
+vsg::ref_ptr<vsg::ubyteArray> unity2vsg::convertImageData(const ImageData& source, ImageData& converted)
+{
+    uint32_t srcTexelSize = sourceTexelSize(source.sourceFormat);
+    uint32_t dstTexelSize = destinationTexelSize(source.sourceFormat);
+    if (srcTexelSize == 0 || source.pixels.data == nullptr || source.pixels.length <= 0)
+    {
+        DebugLog("GraphBuilder Error: Unable to convert texture, unknown source format or no pixel data");
+        return {};
+    }
+
+    if (GetSizeInfoForFormat(source.format).blockSize != dstTexelSize * 8)
+    {
+        DebugLog("GraphBuilder Error: Unable to convert texture, destination format does not match source format");
+        return {};
+    }
+
+    // texels are converted independently so the whole mip chain can be treated as one run of texels
+    size_t count = static_cast<size_t>(source.pixels.length) / srcTexelSize;
+    auto pixels = vsg::ubyteArray::create(static_cast<uint32_t>(count * dstTexelSize));
+
+    const uint8_t* src = source.pixels.data;
+    uint8_t* dst = pixels->data();
+
+    switch (source.sourceFormat)
+    {
+    case IMAGE_SOURCE_FORMAT_R8G8B8: expand3x8<0, 1, 2>(src, dst, count); break;
+    case IMAGE_SOURCE_FORMAT_B8G8R8: expand3x8<2, 1, 0>(src, dst, count); break;
+    case IMAGE_SOURCE_FORMAT_A8R8G8B8: swizzle4x8<1, 2, 3, 0>(src, dst, count); break;
+    case IMAGE_SOURCE_FORMAT_B8G8R8A8: swizzle4x8<2, 1, 0, 3>(src, dst, count); break;
+    case IMAGE_SOURCE_FORMAT_A8: alpha8(src, dst, count); break;
+    case IMAGE_SOURCE_FORMAT_R5G6B5_PACK16: r5g6b5(src, dst, count); break;
+    case IMAGE_SOURCE_FORMAT_R16G16B16_SFLOAT: expand3<uint16_t>(src, dst, count, 0x3C00); break; // half 1.0
+    case IMAGE_SOURCE_FORMAT_R32G32B32_SFLOAT: expand3<float>(src, dst, count, 1.0f); break;
+    default: break;
+    }
+
+    converted = source;
+    converted.sourceFormat = IMAGE_SOURCE_FORMAT_NATIVE;
+    converted.pixels.data = dst;
+    converted.pixels.length = static_cast<int>(pixels->dataSize());
+
+    return pixels;
+}
+
+bool unity2vsg::averageImageColor(const ImageData& data, vsg::vec4& color)
+{
+    bool bgra = false;
+    switch (data.format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB: break;
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB: bgra = true; break;
+    default: return false;
+    }
+
+    size_t count = static_cast<size_t>(data.width) * static_cast<size_t>(data.height) * static_cast<size_t>(std::max(data.depth, 1));
+    if (count == 0 || !data.pixels.data || static_cast<size_t>(data.pixels.length) < count * 4) return false;
+
+    uint64_t sums[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t* texel = data.pixels.data + i * 4;
+        for (int c = 0; c < 4; c++) sums[c] += texel[c];
+    }
+
+    float scale = 1.0f / (255.0f * static_cast<float>(count));
+    color = vsg::vec4(static_cast<float>(sums[bgra ? 2 : 0]) * scale, static_cast<float>(sums[1]) * scale, static_cast<float>(sums[bgra ? 0 : 2]) * scale, static_cast<float>(sums[3]) * scale);
+    return true;
+}
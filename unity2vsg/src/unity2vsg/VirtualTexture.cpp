@@ -0,0 +1,281 @@
+/* <editor-fold desc="MIT License">
+
+Copyright(c) 2019 Thomas Hogarth
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+</editor-fold> */
+
+#include <unity2vsg/VirtualTexture.h>
+
+#include <unity2vsg/DebugLog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace unity2vsg;
+
+namespace
+{
+    // tile store layout
+    //   TileStoreHeader
+    //   uint64_t offsets[tileCount + 1], byte offset of each tile from the start of the file, last entry is the end of the file
+    //   tile data, each tile is (pageSize + 2 * border)^2 texels in the format of the texture it was cut from
+    struct TileStoreHeader
+    {
+        char magic[8] = {'v', 's', 'g', 'v', 't', 'i', 'l', 'e'};
+        uint32_t version = 1;
+        uint32_t tileCount = 0;
+    };
+
+    // interleave the bits of x and y so pages close together in 2D are written close together in the store
+    uint64_t mortonCode(uint32_t x, uint32_t y)
+    {
+        auto spread = [](uint64_t v) {
+            v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+            v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+            v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+            v = (v | (v << 2)) & 0x3333333333333333ull;
+            v = (v | (v << 1)) & 0x5555555555555555ull;
+            return v;
+        };
+        return spread(x) | (spread(y) << 1);
+    }
+} // namespace
+
+VirtualTextureBuilder::VirtualTextureBuilder(uint32_t minSize, uint32_t pageSize, uint32_t pageBorder) :
+    _minSize(minSize),
+    _pageSize(std::max(pageSize, 1u)),
+    _pageBorder(pageBorder)
+{
+}
+
+std::string VirtualTextureBuilder::tileStoreFileName(const std::string& sceneFileName)
+{
+    auto ext = sceneFileName.find_last_of('.');
+    auto sep = sceneFileName.find_last_of("/\\");
+    if (ext == std::string::npos || (sep != std::string::npos && ext < sep)) return sceneFileName + ".vsgt";
+    return sceneFileName.substr(0, ext) + ".vsgt";
+}
+
+bool VirtualTextureBuilder::computeLevels(const ImageData& data, std::vector<Level>& levels, uint32_t& tailLevel, size_t& tailOffset) const
+{
+    VkFormatSizeInfo sizeInfo = GetSizeInfoForFormat(data.format);
+    uint32_t texelSize = sizeInfo.blockSize / 8;
+
+    levels.clear();
+    size_t offset = 0;
+    for (uint32_t m = 0; m < static_cast<uint32_t>(std::max(data.mipmapCount, 1)); m++)
+    {
+        uint32_t width = std::max(static_cast<uint32_t>(data.width) >> m, 1u);
+        uint32_t height = std::max(static_cast<uint32_t>(data.height) >> m, 1u);
+
+        if (width <= _pageSize && height <= _pageSize)
+        {
+            tailLevel = m;
+            tailOffset = offset;
+            return !levels.empty();
+        }
+
+        Level level;
+        level.width = width;
+        level.height = height;
+        level.pagesX = (width + _pageSize - 1) / _pageSize;
+        level.pagesY = (height + _pageSize - 1) / _pageSize;
+        level.offset = offset;
+        level.firstTile = 0;
+        levels.push_back(level);
+
+        offset += static_cast<size_t>(width) * height * texelSize;
+    }
+
+    // no level small enough to stay resident
+    return false;
+}
+
+bool VirtualTextureBuilder::requiresVirtualTexture(const ImageData& data) const
+{
+    if (_minSize == 0 || data.depth != 1) return false;
+    if (static_cast<uint32_t>(std::max(data.width, data.height)) < _minSize) return false;
+
+    // only uncompressed formats can be paged, compressed blocks would need block aligned pages and borders
+    VkFormatSizeInfo sizeInfo = GetSizeInfoForFormat(data.format);
+    if (sizeInfo.layout.blockWidth != 1 || sizeInfo.layout.blockHeight != 1 || sizeInfo.blockSize % 8 != 0) return false;
+
+    std::vector<Level> levels;
+    uint32_t tailLevel = 0;
+    size_t tailOffset = 0;
+    if (!computeLevels(data, levels, tailLevel, tailOffset))
+    {
+        DebugLog("VirtualTextureBuilder Warning: Texture " + std::to_string(data.id) + " has no mipmap small enough to stay resident, exporting it as a regular texture.");
+        return false;
+    }
+    return tailOffset < static_cast<size_t>(data.pixels.length);
+}
+
+vsg::ref_ptr<vsg::Objects> VirtualTextureBuilder::add(const ImageData& data, ImageData& mipTail)
+{
+    PagedTexture texture;
+    texture.source = data;
+    texture.texelSize = GetSizeInfoForFormat(data.format).blockSize / 8;
+
+    uint32_t tailLevel = 0;
+    size_t tailOffset = 0;
+    if (!computeLevels(data, texture.levels, tailLevel, tailOffset)) return {};
+
+    // the resident mip tail is just a view of the end of the source pixels
+    mipTail = data;
+    mipTail.pixels.data = data.pixels.data + tailOffset;
+    mipTail.pixels.length = data.pixels.length - static_cast<int>(tailOffset);
+    mipTail.width = std::max(data.width >> tailLevel, 1);
+    mipTail.height = std::max(data.height >> tailLevel, 1);
+    mipTail.mipmapCount = std::max(data.mipmapCount - static_cast<int>(tailLevel), 1);
+
+    // the same image can be bound by several descriptors, only page it once
+    auto itr = _textureIndices.find(data.id);
+    if (itr != _textureIndices.end()) return _textures[itr->second].info;
+
+    auto info = vsg::Objects::create();
+    info->setValue("format", static_cast<int>(data.format));
+    info->setValue("width", data.width);
+    info->setValue("height", data.height);
+    info->setValue("pageSize", static_cast<int>(_pageSize));
+    info->setValue("pageBorder", static_cast<int>(_pageBorder));
+    info->setValue("pagedLevels", static_cast<int>(texture.levels.size()));
+    info->setValue("defines", std::string("VSG_VIRTUAL_TEXTURE,VSG_VT_PAGE_SIZE=") + std::to_string(_pageSize) + ",VSG_VT_PAGE_BORDER=" + std::to_string(_pageBorder) + ",VSG_VT_PAGED_LEVELS=" + std::to_string(texture.levels.size()));
+
+    // assign tile indices in morton order per level, the page tables map a page x, y to its tile in the store
+    for (auto& level : texture.levels)
+    {
+        level.firstTile = _tileCount;
+
+        level.pageOrder.reserve(static_cast<size_t>(level.pagesX) * level.pagesY);
+        for (uint32_t y = 0; y < level.pagesY; y++)
+        {
+            for (uint32_t x = 0; x < level.pagesX; x++) level.pageOrder.emplace_back(x, y);
+        }
+        std::sort(level.pageOrder.begin(), level.pageOrder.end(), [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
+            return mortonCode(a.first, a.second) < mortonCode(b.first, b.second);
+        });
+
+        auto pageTable = vsg::uintArray2D::create(level.pagesX, level.pagesY);
+        for (uint32_t i = 0; i < level.pageOrder.size(); i++)
+        {
+            pageTable->set(level.pageOrder[i].first, level.pageOrder[i].second, _tileCount + i);
+        }
+        info->addChild(pageTable);
+
+        _tileCount += static_cast<uint32_t>(level.pageOrder.size());
+    }
+
+    texture.info = info;
+    _textureIndices[data.id] = _textures.size();
+    _textures.push_back(texture);
+
+    return info;
+}
+
+void VirtualTextureBuilder::copyTile(const PagedTexture& texture, const Level& level, uint32_t pageX, uint32_t pageY, std::vector<uint8_t>& buffer) const
+{
+    const uint32_t tileSize = _pageSize + 2 * _pageBorder;
+    const size_t texelSize = texture.texelSize;
+    const size_t rowSize = static_cast<size_t>(level.width) * texelSize;
+    const uint8_t* src = texture.source.pixels.data + level.offset;
+    const bool repeat = texture.source.wrapMode == VK_SAMPLER_ADDRESS_MODE_REPEAT;
+
+    // border texels outside the image either wrap or clamp to match how the sampler would address them
+    auto address = [repeat](int64_t coord, uint32_t size) {
+        if (repeat) return static_cast<uint32_t>(((coord % size) + size) % size);
+        return static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(coord, 0), size - 1));
+    };
+
+    const int64_t x0 = static_cast<int64_t>(pageX) * _pageSize - _pageBorder;
+    const int64_t y0 = static_cast<int64_t>(pageY) * _pageSize - _pageBorder;
+
+    // the span of the tile row that lies inside the image can be copied in one go
+    const int64_t spanBegin = std::max<int64_t>(x0, 0);
+    const int64_t spanEnd = std::min<int64_t>(x0 + tileSize, level.width);
+
+    uint8_t* dst = buffer.data();
+    for (uint32_t ty = 0; ty < tileSize; ty++)
+    {
+        const uint8_t* srcRow = src + address(y0 + ty, level.height) * rowSize;
+
+        for (int64_t x = x0; x < spanBegin; x++, dst += texelSize)
+        {
+            std::memcpy(dst, srcRow + address(x, level.width) * texelSize, texelSize);
+        }
+        if (spanEnd > spanBegin)
+        {
+            size_t spanSize = static_cast<size_t>(spanEnd - spanBegin) * texelSize;
+            std::memcpy(dst, srcRow + spanBegin * texelSize, spanSize);
+            dst += spanSize;
+        }
+        for (int64_t x = std::max(spanEnd, x0); x < x0 + tileSize; x++, dst += texelSize)
+        {
+            std::memcpy(dst, srcRow + address(x, level.width) * texelSize, texelSize);
+        }
+    }
+}
+
+bool VirtualTextureBuilder::writeTileStore(const std::string& fileName)
+{
+    std::ofstream fout(fileName, std::ios::out | std::ios::binary);
+    if (!fout.is_open())
+    {
+        DebugLog("VirtualTextureBuilder Error: Failed to open tile store '" + fileName + "' for writing.");
+        return false;
+    }
+
+    const uint32_t tileSize = _pageSize + 2 * _pageBorder;
+
+    TileStoreHeader header;
+    header.tileCount = _tileCount;
+    fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // tiles are written in tile index order so the offsets can be computed up front
+    std::vector<uint64_t> offsets;
+    offsets.reserve(_tileCount + 1);
+    uint64_t offset = sizeof(header) + sizeof(uint64_t) * (static_cast<uint64_t>(_tileCount) + 1);
+    for (auto& texture : _textures)
+    {
+        uint64_t tileBytes = static_cast<uint64_t>(tileSize) * tileSize * texture.texelSize;
+        for (auto& level : texture.levels)
+        {
+            for (size_t i = 0; i < level.pageOrder.size(); i++)
+            {
+                offsets.push_back(offset);
+                offset += tileBytes;
+            }
+        }
+    }
+    offsets.push_back(offset);
+    fout.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+    std::string storeName = fileName.substr(fileName.find_last_of("/\\") + 1);
+
+    std::vector<uint8_t> buffer;
+    for (auto& texture : _textures)
+    {
+        buffer.resize(static_cast<size_t>(tileSize) * tileSize * texture.texelSize);
+        for (auto& level : texture.levels)
+        {
+            for (auto& page : level.pageOrder)
+            {
+                copyTile(texture, level, page.first, page.second, buffer);
+                fout.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+            }
+        }
+
+        texture.info->setValue("tileStore", storeName);
+    }
+
+    DebugLog("VirtualTextureBuilder: Wrote " + std::to_string(_tileCount) + " pages for " + std::to_string(_textures.size()) + " virtual textures to '" + storeName + "'.");
+
+    return fout.good();
+}
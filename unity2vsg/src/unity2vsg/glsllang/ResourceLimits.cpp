@@ -0,0 +1,153 @@
+//
+// Copyright (C) 2016 Google, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//    Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//    Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//    Neither the name of Google Inc. nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT HOLDERS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "ResourceLimits.h"
+
+namespace glslang {
+
+// the limits match the glslang standalone defaults, members are assigned by name rather than aggregate initialised
+// so the table keeps compiling against glslang versions that have added members since
+static TBuiltInResource CreateDefaultTBuiltInResource()
+{
+    TBuiltInResource resources = {};
+
+    resources.maxLights = 32;
+    resources.maxClipPlanes = 6;
+    resources.maxTextureUnits = 32;
+    resources.maxTextureCoords = 32;
+    resources.maxVertexAttribs = 64;
+    resources.maxVertexUniformComponents = 4096;
+    resources.maxVaryingFloats = 64;
+    resources.maxVertexTextureImageUnits = 32;
+    resources.maxCombinedTextureImageUnits = 80;
+    resources.maxTextureImageUnits = 32;
+    resources.maxFragmentUniformComponents = 4096;
+    resources.maxDrawBuffers = 32;
+    resources.maxVertexUniformVectors = 128;
+    resources.maxVaryingVectors = 8;
+    resources.maxFragmentUniformVectors = 16;
+    resources.maxVertexOutputVectors = 16;
+    resources.maxFragmentInputVectors = 15;
+    resources.minProgramTexelOffset = -8;
+    resources.maxProgramTexelOffset = 7;
+    resources.maxClipDistances = 8;
+    resources.maxComputeWorkGroupCountX = 65535;
+    resources.maxComputeWorkGroupCountY = 65535;
+    resources.maxComputeWorkGroupCountZ = 65535;
+    resources.maxComputeWorkGroupSizeX = 1024;
+    resources.maxComputeWorkGroupSizeY = 1024;
+    resources.maxComputeWorkGroupSizeZ = 64;
+    resources.maxComputeUniformComponents = 1024;
+    resources.maxComputeTextureImageUnits = 16;
+    resources.maxComputeImageUniforms = 8;
+    resources.maxComputeAtomicCounters = 8;
+    resources.maxComputeAtomicCounterBuffers = 1;
+    resources.maxVaryingComponents = 60;
+    resources.maxVertexOutputComponents = 64;
+    resources.maxGeometryInputComponents = 64;
+    resources.maxGeometryOutputComponents = 128;
+    resources.maxFragmentInputComponents = 128;
+    resources.maxImageUnits = 8;
+    resources.maxCombinedImageUnitsAndFragmentOutputs = 8;
+    resources.maxCombinedShaderOutputResources = 8;
+    resources.maxImageSamples = 0;
+    resources.maxVertexImageUniforms = 0;
+    resources.maxTessControlImageUniforms = 0;
+    resources.maxTessEvaluationImageUniforms = 0;
+    resources.maxGeometryImageUniforms = 0;
+    resources.maxFragmentImageUniforms = 8;
+    resources.maxCombinedImageUniforms = 8;
+    resources.maxGeometryTextureImageUnits = 16;
+    resources.maxGeometryOutputVertices = 256;
+    resources.maxGeometryTotalOutputComponents = 1024;
+    resources.maxGeometryUniformComponents = 1024;
+    resources.maxGeometryVaryingComponents = 64;
+    resources.maxTessControlInputComponents = 128;
+    resources.maxTessControlOutputComponents = 128;
+    resources.maxTessControlTextureImageUnits = 16;
+    resources.maxTessControlUniformComponents = 1024;
+    resources.maxTessControlTotalOutputComponents = 4096;
+    resources.maxTessEvaluationInputComponents = 128;
+    resources.maxTessEvaluationOutputComponents = 128;
+    resources.maxTessEvaluationTextureImageUnits = 16;
+    resources.maxTessEvaluationUniformComponents = 1024;
+    resources.maxTessPatchComponents = 120;
+    resources.maxPatchVertices = 32;
+    resources.maxTessGenLevel = 64;
+    resources.maxViewports = 16;
+    resources.maxVertexAtomicCounters = 0;
+    resources.maxTessControlAtomicCounters = 0;
+    resources.maxTessEvaluationAtomicCounters = 0;
+    resources.maxGeometryAtomicCounters = 0;
+    resources.maxFragmentAtomicCounters = 8;
+    resources.maxCombinedAtomicCounters = 8;
+    resources.maxAtomicCounterBindings = 1;
+    resources.maxVertexAtomicCounterBuffers = 0;
+    resources.maxTessControlAtomicCounterBuffers = 0;
+    resources.maxTessEvaluationAtomicCounterBuffers = 0;
+    resources.maxGeometryAtomicCounterBuffers = 0;
+    resources.maxFragmentAtomicCounterBuffers = 1;
+    resources.maxCombinedAtomicCounterBuffers = 1;
+    resources.maxAtomicCounterBufferSize = 16384;
+    resources.maxTransformFeedbackBuffers = 4;
+    resources.maxTransformFeedbackInterleavedComponents = 64;
+    resources.maxCullDistances = 8;
+    resources.maxCombinedClipAndCullDistances = 8;
+    resources.maxSamples = 4;
+    resources.maxMeshOutputVerticesNV = 256;
+    resources.maxMeshOutputPrimitivesNV = 512;
+    resources.maxMeshWorkGroupSizeX_NV = 32;
+    resources.maxMeshWorkGroupSizeY_NV = 1;
+    resources.maxMeshWorkGroupSizeZ_NV = 1;
+    resources.maxTaskWorkGroupSizeX_NV = 32;
+    resources.maxTaskWorkGroupSizeY_NV = 1;
+    resources.maxTaskWorkGroupSizeZ_NV = 1;
+    resources.maxMeshViewCountNV = 4;
+
+    resources.limits.nonInductiveForLoops = true;
+    resources.limits.whileLoops = true;
+    resources.limits.doWhileLoops = true;
+    resources.limits.generalUniformIndexing = true;
+    resources.limits.generalAttributeMatrixVectorIndexing = true;
+    resources.limits.generalVaryingIndexing = true;
+    resources.limits.generalSamplerIndexing = true;
+    resources.limits.generalVariableIndexing = true;
+    resources.limits.generalConstantMatrixVectorIndexing = true;
+
+    return resources;
+}
+
+const TBuiltInResource DefaultTBuiltInResource = CreateDefaultTBuiltInResource();
+
+}  // end namespace glslang
@@ -12,13 +12,31 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include <unity2vsg/unity2vsg.h>
 
+#include <unity2vsg/ChunkedCompression.h>
+#include <unity2vsg/CullHierarchy.h>
 #include <unity2vsg/DebugLog.h>
 #include <unity2vsg/GraphicsPipelineBuilder.h>
+#include <unity2vsg/HierarchicalLOD.h>
+#include <unity2vsg/HierarchyFlattening.h>
+#include <unity2vsg/LeafStream.h>
+#include <unity2vsg/PotentiallyVisibleSet.h>
+#include <unity2vsg/SceneTiling.h>
+#include <unity2vsg/ShaderCache.h>
 #include <unity2vsg/ShaderUtils.h>
+#include <unity2vsg/SPIRVReflection.h>
+#include <unity2vsg/StateSorting.h>
+#include <unity2vsg/TextureConversion.h>
+#include <unity2vsg/ThreadPool.h>
+#include <unity2vsg/VirtualTexture.h>
 
 #include <vsg/all.h>
 #include <vsg/core/Objects.h>
 
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <sstream>
+
 using namespace unity2vsg;
 
 vsg::ref_ptr<vsg::Data> getData(vsg::ref_ptr<vsg::ImageInfo>& imageInfo)
@@ -37,6 +55,12 @@ public:
         objects = new vsg::Objects;
     }
 
+    // arrays shared between draws are only added once
+    void add(vsg::ref_ptr<vsg::Data> data)
+    {
+        if (data && _collected.insert(data.get()).second) objects->addChild(data);
+    }
+
     void apply(vsg::Object& object) override
     {
         if (typeid(object) == typeid(vsg::DescriptorImage))
@@ -46,7 +70,7 @@ public:
             {
                 if (auto data = getData(imageInfo))
                 {
-                    objects->addChild(data);
+                    add(data);
                 }
             }
         }
@@ -56,25 +80,25 @@ public:
 
     void apply(vsg::Geometry& geometry) override
     {
-        for (auto& data : geometry.arrays)
+        for (auto& array : geometry.arrays)
         {
-            objects->addChild(data);
+            add(array->data);
         }
         if (geometry.indices)
         {
-            objects->addChild(geometry.indices);
+            add(geometry.indices->data);
         }
     }
 
     void apply(vsg::VertexIndexDraw& vid) override
     {
-        for (auto& data : vid.arrays)
+        for (auto& array : vid.arrays)
         {
-            objects->addChild(data);
+            add(array->data);
         }
         if (vid.indices)
         {
-            objects->addChild(vid.indices);
+            add(vid.indices->data);
         }
     }
 
@@ -82,7 +106,7 @@ public:
     {
         for (auto& array : bvb.arrays)
         {
-            objects->addChild(array);
+            add(array->data);
         }
     }
 
@@ -90,7 +114,7 @@ public:
     {
         if (bib.indices)
         {
-            objects->addChild(bib.indices);
+            add(bib.indices->data);
         }
     }
 
@@ -103,6 +127,9 @@ public:
 
         stategroup.traverse(*this);
     }
+
+protected:
+    std::set<vsg::Data*> _collected;
 };
 
 class LeafDataRelease : public vsg::Visitor
@@ -178,13 +205,113 @@ public:
     }
 };
 
+// points stategroups and commands at the state command chosen to replace each one, so pipelines and descriptor sets that
+// became the same when rebuilt are bound by the same command and state sorting can merge what they draw
+class ReplaceStateCommands : public vsg::Visitor
+{
+public:
+    std::map<vsg::StateCommand*, vsg::ref_ptr<vsg::StateCommand>> replacements;
+
+    void apply(vsg::Object& object) override
+    {
+        object.traverse(*this);
+    }
+
+    void apply(vsg::StateGroup& stategroup) override
+    {
+        for (auto& command : stategroup.stateCommands)
+        {
+            replace(command);
+        }
+
+        if (auto depthOnly = stategroup.getObject("depthOnly")) depthOnly->accept(*this);
+
+        stategroup.traverse(*this);
+    }
+
+    void apply(vsg::Commands& commands) override
+    {
+        for (auto& command : commands.children)
+        {
+            replace(command);
+        }
+    }
+
+protected:
+    template<typename T>
+    void replace(vsg::ref_ptr<T>& command)
+    {
+        auto itr = replacements.find(dynamic_cast<vsg::StateCommand*>(command.get()));
+        if (itr != replacements.end()) command = itr->second;
+    }
+};
+
+// a pipeline of precompiled shaders to be rebuilt from reflecting its stages, the material bindings it was built from
+struct PendingReflection
+{
+    std::string id;
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+};
+
+// a descriptor set bound with a pipeline pending reflection, and the ids of its descriptors
+struct PendingDescriptorSet
+{
+    std::string id;
+    vsg::ref_ptr<vsg::BindDescriptorSet> bindDescriptorSet;
+    vsg::GraphicsPipeline* pipeline;
+};
+
+// the vertex arrays of a command drawn with a pipeline pending reflection, and the location of each array
+struct PendingVertexArrays
+{
+    vsg::ref_ptr<vsg::Object> command;
+    vsg::BufferInfoList* arrays;
+    vsg::GraphicsPipeline* pipeline;
+    std::vector<uint32_t> locations;
+};
+
 class GraphBuilder : public vsg::Object
 {
 public:
-    GraphBuilder()
+    GraphBuilder(const ExportSettingsData& settings) :
+        _settings(settings)
     {
         _root = vsg::MatrixTransform::create();
         pushNodeToStack(_root);
+
+        _pipelineBuilder = vsg::GraphicsPipelineBuilder::create();
+
+        if (_settings.virtualTextureMinSize > 0)
+        {
+            _virtualTextures = new VirtualTextureBuilder(_settings.virtualTextureMinSize, _settings.virtualTexturePageSize, _settings.virtualTexturePageBorder);
+        }
+
+        if (_settings.precompileShaders != 0 && _settings.shaderCacheDirectory != nullptr && _settings.shaderCacheDirectory[0] != '\0')
+        {
+            _shaderCache = new ShaderCache(_settings.shaderCacheDirectory, static_cast<uint64_t>(std::max(_settings.shaderCacheMaxSize, 0)) * 1024 * 1024);
+        }
+        _settings.shaderCacheDirectory = nullptr; // only valid for the duration of BeginExport
+
+        // baking and tiling rewrite and move leaf data when the export ends, by which time streamed data is already written
+        if (_settings.streamLeafData != 0)
+        {
+            if (_settings.bakeStaticTransforms != 0 || _settings.tileSize > 0.0f)
+            {
+                DebugLog("GraphBuilder Warning: Baking static transforms and tiled output are disabled when streaming leaf data");
+                _settings.bakeStaticTransforms = 0;
+                _settings.tileSize = 0.0f;
+            }
+
+            _leafStream = new LeafStreamWriter();
+            if (!_leafStream->valid()) _leafStream = nullptr;
+        }
+
+        // tiles share the textures of the root's stategroups but are written to their own files, which can't reference the root's leaf file
+        if (_settings.packLeafData != 0 && _settings.tileSize > 0.0f)
+        {
+            DebugLog("GraphBuilder Warning: Packed leaf data is disabled for tiled output");
+            _settings.packLeafData = 0;
+        }
     }
 
     //
@@ -209,6 +336,7 @@ public:
                           data.matrix.data[12], data.matrix.data[13], data.matrix.data[14], data.matrix.data[15]);
 
         auto transform = vsg::MatrixTransform::create(matrix);
+        if (data.isStatic != 0) _flattenInputs.staticTransforms.insert(transform.get());
 
         if (!addChildToHead(transform))
         {
@@ -280,60 +408,57 @@ public:
             DebugLog("GraphBuilder Error: Current head is not a group");
         }
         pushNodeToStack(commands);
+
+        // commands under a stategroup with a depth only variant get a twin there holding their depth only commands
+        if (auto depthParent = getDepthOnlyNode(getParentOfHead()))
+        {
+            auto depthCommands = vsg::Commands::create();
+            dynamic_cast<vsg::Group*>(depthParent)->addChild(depthCommands);
+            _depthOnlyNodes[commands.get()] = depthCommands;
+        }
     }
 
     void addVertexIndexDraw(const VertexIndexDrawData& data)
     {
         vsg::ref_ptr<vsg::Node> geomNode;
+        auto key = std::make_pair(data.id, activePendingReflection());
 
-        if (_vertexIndexDrawCache.find(data.id) != _vertexIndexDrawCache.end())
+        if (_vertexIndexDrawCache.find(key) != _vertexIndexDrawCache.end())
         {
-            geomNode = _vertexIndexDrawCache[data.id];
+            geomNode = _vertexIndexDrawCache[key];
         }
         else
         {
             auto geometry = vsg::VertexIndexDraw::create();
 
             // vertex inputs
-            auto inputarrays = vsg::DataList{createVsgArray<vsg::vec3>(data.verticies.data, data.verticies.length)}; // always have verticies
-
-            if (data.normals.length > 0) inputarrays.push_back(createVsgArray<vsg::vec3>(data.normals.data, data.normals.length));
-            if (data.tangents.length > 0) inputarrays.push_back(createVsgArray<vsg::vec4>(data.tangents.data, data.tangents.length));
-            if (data.colors.length > 0) inputarrays.push_back(createVsgArray<vsg::vec4>(data.colors.data, data.colors.length));
-            if (data.uv0.length > 0) inputarrays.push_back(createVsgArray<vsg::vec2>(data.uv0.data, data.uv0.length));
-            if (data.uv1.length > 0) inputarrays.push_back(createVsgArray<vsg::vec2>(data.uv1.data, data.uv1.length));
-
-            geometry->assignArrays(inputarrays);
-
-            if (data.use32BitIndicies == 0)
-            {
-                // for now convert the int32 array indicies to uint16
-                vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(data.triangles.length));
-                for (int32_t i = 0; i < data.triangles.length; i++)
-                {
-                    indiciesushort->set(i, static_cast<uint16_t>(data.triangles.data[i]));
-                }
-
-                geometry->assignIndices(indiciesushort);
-            }
-            else
-            {
-                vsg::ref_ptr<vsg::uintArray> indiciesuint(new vsg::uintArray(data.triangles.length));
-                for (int32_t i = 0; i < data.triangles.length; i++)
-                {
-                    indiciesuint->set(i, static_cast<uint32_t>(data.triangles.data[i]));
-                }
-
-                geometry->assignIndices(indiciesuint);
-            }
+            std::vector<uint32_t> locations;
+            geometry->assignArrays(createVertexArrays(data, locations));
+            if (key.second) _pendingVertexArrays.push_back({geometry, &geometry->arrays, key.second, locations});
 
+            geometry->assignIndices(getOrCreateIndices(data));
             geometry->indexCount = data.triangles.length;
             geometry->instanceCount = 1;
 
-            _vertexIndexDrawCache[data.id] = geometry;
+            _vertexIndexDrawCache[key] = geometry;
             geomNode = geometry;
         }
 
+        if (auto depthParent = getDepthOnlyNode(getHead()))
+        {
+            auto& depthGeometry = _depthOnlyVertexIndexDrawCache[data.id];
+            if (!depthGeometry)
+            {
+                auto geometry = dynamic_cast<vsg::VertexIndexDraw*>(geomNode.get());
+                depthGeometry = vsg::VertexIndexDraw::create();
+                depthGeometry->assignArrays(vsg::DataList{getOrCreateVertexPositions(data)});
+                depthGeometry->assignIndices(geometry->indices->data);
+                depthGeometry->indexCount = geometry->indexCount;
+                depthGeometry->instanceCount = geometry->instanceCount;
+            }
+            dynamic_cast<vsg::Group*>(depthParent)->addChild(depthGeometry);
+        }
+
         if (!addChildToHead(geomNode))
         {
             DebugLog("GraphBuilder Error: Current head is not a group");
@@ -355,7 +480,7 @@ public:
     // Commands
     //
 
-    vsg::ref_ptr<vsg::ShaderModule> getOrCreateShaderModule(VkShaderStageFlagBits stage, std::string shaderSourceFile, uint32_t inputAtts, uint32_t shaderMode, std::string customDefStr)
+    vsg::ref_ptr<vsg::ShaderModule> getOrCreateShaderModule(VkShaderStageFlagBits stage, std::string shaderSourceFile, uint32_t inputAtts, uint32_t shaderMode, std::string customDefStr, std::map<uint32_t, uint32_t>& featureConstants, bool& bindless)
     {
         auto split = [](const std::string& str, const char& seperator) {
             std::vector<std::string> elements;
@@ -374,47 +499,147 @@ public:
             return elements;
         };
 
-        std::string shaderkey = std::to_string((int)stage) + "," + shaderSourceFile + "," + std::to_string(inputAtts) + "," + customDefStr;
         std::vector<std::string> customdefs = customDefStr.empty() ? std::vector<std::string>() : split(customDefStr, ',');
+        std::vector<std::string> defines = createCanonicalDefines(shaderMode, inputAtts, customdefs);
+
+        // file sources come from the session wide source cache, the fbx sources are generated so only their defines vary
+        std::string source;
+        uint64_t sourceHash = 0;
+        bool sourceRead = true;
+        if (!shaderSourceFile.empty() && !readGLSLSource(shaderSourceFile, source, sourceHash))
+        {
+            DebugLog("GraphBuilder Error: Failed to read shader source '" + shaderSourceFile + "'");
+            sourceRead = false;
+        }
+
+        // the includes are part of the content the variant is keyed on
+        if (sourceRead && !shaderSourceFile.empty() && !hashGLSLIncludes(source, shaderSourceFile, sourceHash))
+        {
+            DebugLog("GraphBuilder Error: Failed to read an include of shader source '" + shaderSourceFile + "'");
+            sourceRead = false;
+        }
+
+        if (!shaderSourceFile.empty())
+        {
+            const std::string specialized = "VSG_SPECIALIZED";
+            auto insertPos = std::lower_bound(defines.begin(), defines.end(), specialized);
+            if (_settings.specializeShaderFeatures != 0 && (insertPos == defines.end() || *insertPos != specialized)) defines.insert(insertPos, specialized);
+
+            const std::string bindlessDefine = "VSG_BINDLESS";
+            insertPos = std::lower_bound(defines.begin(), defines.end(), bindlessDefine);
+            if (_settings.bindlessTextureCapacity > 0 && (insertPos == defines.end() || *insertPos != bindlessDefine)) defines.insert(insertPos, bindlessDefine);
+
+            // defines the source doesn't import can't change its preprocessed output, drop them so they don't create variants
+            std::vector<std::string> requested = defines;
+            defines = filterImportedDefines(source, defines, shaderSourceFile);
+
+            // shaders importing VSG_BINDLESS read their textures and uniforms through the shared bindless set, its texture array
+            // is sized to the capacity so it isn't runtime sized
+            if (std::binary_search(defines.begin(), defines.end(), bindlessDefine))
+            {
+                bindless = true;
+                featureConstants[BINDLESS_TEXTURE_CAPACITY_CONSTANT] = static_cast<uint32_t>(_settings.bindlessTextureCapacity);
+            }
+
+            // shaders that import VSG_SPECIALIZED read their feature toggles from specialization constants, so the toggles are
+            // taken out of the defines and every combination of them shares the one module
+            if (std::binary_search(defines.begin(), defines.end(), specialized))
+            {
+                for (auto& feature : specializedShaderFeatures())
+                {
+                    featureConstants[feature.constantID] = std::binary_search(requested.begin(), requested.end(), std::string(feature.define)) ? 1 : 0;
+                    defines.erase(std::remove(defines.begin(), defines.end(), feature.define), defines.end());
+                }
+            }
+        }
+
+        // variants are keyed on the content of their source and their canonical define set, so the same file reached by
+        // different paths or the same defines in a different order share a module
+        std::string shaderkey = std::to_string((int)stage) + "," + (shaderSourceFile.empty() ? std::string("fbx") : std::to_string(sourceHash)) + ",";
+        for (auto& define : defines) shaderkey += define + ";";
 
         vsg::ref_ptr<vsg::ShaderModule> shaderModule;
 
-        if (_shaderModulesCache.find(shaderkey) != _shaderModulesCache.end())
+        // a source or include that couldn't be read leaves nothing to key on, so its variant is neither shared nor cached
+        if (sourceRead && _shaderModulesCache.find(shaderkey) != _shaderModulesCache.end())
         {
             shaderModule = _shaderModulesCache[shaderkey];
         }
         else
         {
-            if (!shaderSourceFile.empty())
+            // the module is filled in by a task on the shader threads, pipelines can reference it straight away and
+            // waitForShaders joins the tasks before anything reads the source or code
+            shaderModule = vsg::ShaderModule::create(std::string());
+
+            if (!_shaderThreads)
             {
-                shaderModule = vsg::ShaderModule::create(readGLSLShader(shaderSourceFile, shaderMode, inputAtts, customdefs));
+                _shaderThreads = new ThreadPool(std::thread::hardware_concurrency(), initializeShaderCompilerThread, finalizeShaderCompilerThread);
             }
-            else
-            {
-                if (stage == VK_SHADER_STAGE_VERTEX_BIT)
+
+            bool precompile = _settings.precompileShaders != 0;
+            uint32_t optimization = static_cast<uint32_t>(_settings.shaderOptimization);
+            bool stripDebugInfo = _settings.shaderStripDebugInfo != 0;
+            vsg::ref_ptr<ShaderCache> shaderCache = sourceRead ? _shaderCache : vsg::ref_ptr<ShaderCache>();
+
+            auto buildShader = [=]() {
+                if (!shaderSourceFile.empty())
+                {
+                    shaderModule->source = preprocessGLSLShader(source, defines, shaderSourceFile);
+                }
+                else if (stage == VK_SHADER_STAGE_VERTEX_BIT)
                 {
-                    shaderModule = vsg::ShaderModule::create(createFbxVertexSource(shaderMode, inputAtts, customdefs));
+                    shaderModule->source = createFbxVertexSource(shaderMode, inputAtts, customdefs);
                 }
                 else
                 {
-                    shaderModule = vsg::ShaderModule::create(createFbxFragmentSource(shaderMode, inputAtts, customdefs));
+                    shaderModule->source = createFbxFragmentSource(shaderMode, inputAtts, customdefs);
                 }
-                _shaderModulesCache[shaderkey] = shaderModule;
-            }
+
+                // compile to spirv now so loading the exported file doesn't have to, the glsl source is kept alongside the code
+                if (!precompile) return;
+
+                vsg::ShaderModule::SPIRV spirv;
+                std::string cacheKey = shaderCache ? ShaderCache::createKey(stage, shaderModule->source, optimization, stripDebugInfo) : std::string();
+
+                if (shaderCache && shaderCache->read(cacheKey, spirv))
+                {
+                    shaderModule->code = spirv;
+                }
+                else if (compileGLSLToSPIRV(stage, shaderModule->source, optimization, stripDebugInfo, spirv))
+                {
+                    if (shaderCache) shaderCache->write(cacheKey, spirv);
+                    shaderModule->code = spirv;
+                }
+                else
+                {
+                    DebugLog("GraphBuilder Warning: Failed to precompile shader '" + shaderSourceFile + "' with defines '" + customDefStr + "', it will be compiled at load time");
+                }
+            };
+
+            auto task = _shaderThreads->run(buildShader).share();
+            _shaderTasks.push_back(task);
+
+            if (sourceRead) _shaderModulesCache[shaderkey] = shaderModule;
         }
 
         return shaderModule;
     }
 
-    vsg::ref_ptr<vsg::ShaderStage> createShaderStage(VkShaderStageFlagBits stage, vsg::ref_ptr<vsg::ShaderModule> shaderModule, UIntArray specializationConstants)
+    vsg::ref_ptr<vsg::ShaderStage> createShaderStage(VkShaderStageFlagBits stage, vsg::ref_ptr<vsg::ShaderModule> shaderModule, UIntArray specializationConstants, const std::map<uint32_t, uint32_t>& featureConstants)
     {
         auto shaderStage = vsg::ShaderStage::create(stage, "main", shaderModule);
+        _shaderStages.push_back(shaderStage);
 
         for(int i = 0; i<specializationConstants.length; ++i)
         {
             shaderStage->specializationConstants[static_cast<uint32_t>(i)] = vsg::uintValue::create(specializationConstants.data[i]);
         }
 
+        for (auto& constant : featureConstants)
+        {
+            shaderStage->specializationConstants[constant.first] = vsg::uintValue::create(constant.second);
+        }
+
         return shaderStage;
     }
 
@@ -429,7 +654,6 @@ public:
         }
         else
         {
-            vsg::ref_ptr<vsg::GraphicsPipelineBuilder> pipelinebuilder = vsg::GraphicsPipelineBuilder::create();
             vsg::ref_ptr<vsg::GraphicsPipelineBuilder::Traits> traits = vsg::GraphicsPipelineBuilder::Traits::create();
 
             // vertex input
@@ -475,35 +699,76 @@ public:
                 bindingSet[dslb.stageFlags].push_back(binding);
             }
 
-            traits->descriptorLayouts = {bindingSet};
-
             // setup shaders
             vsg::ShaderStages shaders;
+            std::map<uint32_t, uint32_t> featureConstants;
+            bool bindless = false;
+            bool billboard = false;
 
             for (int i = 0; i < data.shaderStages.stagesCount; i++)
             {
                 ShaderStageData& shaderStageData = data.shaderStages.stages[i];
                 std::string customDefs = std::string(shaderStageData.customDefines);
+                if (customDefs.find("VSG_BILLBOARD") != std::string::npos) billboard = true;
 
                 if ((shaderStageData.stages & VK_SHADER_STAGE_VERTEX_BIT) == VK_SHADER_STAGE_VERTEX_BIT)
                 {
                     std::string vertDefines = customDefs + ", VSG_VERTEX_CODE";
-                    auto vertShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_VERTEX_BIT, std::string(shaderStageData.source), inputshaderatts, shaderMode, vertDefines);
-                    shaders.push_back(createShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, shaderStageData.specializationData));
+                    std::map<uint32_t, uint32_t> vertFeatureConstants;
+                    auto vertShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_VERTEX_BIT, std::string(shaderStageData.source), inputshaderatts, shaderMode, vertDefines, vertFeatureConstants, bindless);
+                    shaders.push_back(createShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, shaderStageData.specializationData, vertFeatureConstants));
+                    featureConstants.insert(vertFeatureConstants.begin(), vertFeatureConstants.end());
                 }
                 if ((shaderStageData.stages & VK_SHADER_STAGE_FRAGMENT_BIT) == VK_SHADER_STAGE_FRAGMENT_BIT)
                 {
                     std::string fragDefines = customDefs + ", VSG_FRAGMENT_CODE";
-                    auto fragShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, std::string(shaderStageData.source), inputshaderatts, shaderMode, fragDefines);
-                    shaders.push_back(createShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule, shaderStageData.specializationData));
+                    std::map<uint32_t, uint32_t> fragFeatureConstants;
+                    auto fragShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, std::string(shaderStageData.source), inputshaderatts, shaderMode, fragDefines, fragFeatureConstants, bindless);
+                    shaders.push_back(createShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule, shaderStageData.specializationData, fragFeatureConstants));
+                    featureConstants.insert(fragFeatureConstants.begin(), fragFeatureConstants.end());
                 }
             }
 
             traits->shaderStages = shaders;
 
+            // bindless pipelines all share one set holding every texture and material record, the material's own bindings
+            // become indices in its record and the record's offset is pushed after the matrices. only the fragment shader reads the
+            // offset, and a stage can't be in two push constant ranges, so its range is the fragment stage's alone
+            if (bindless)
+            {
+                VkShaderStageFlags stages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+                bindingSet.clear();
+                bindingSet[stages] = {{BINDLESS_TEXTURES_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<uint32_t>(_settings.bindlessTextureCapacity)},
+                                      {BINDLESS_MATERIALS_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1}};
+                traits->pushConstantRanges.push_back({VK_SHADER_STAGE_FRAGMENT_BIT, BINDLESS_MATERIAL_OFFSET, sizeof(uint32_t)});
+            }
+
+            // specialized shaders declare the textures of every feature, give the ones this material doesn't have a placeholder binding
+            for (auto& feature : specializedShaderFeatures())
+            {
+                if (bindless) break;
+                if (feature.binding < 0 || featureConstants.find(feature.constantID) == featureConstants.end()) continue;
+
+                bool bound = false;
+                for (int32_t i = 0; i < data.descriptorBindings.length; i++)
+                {
+                    if (data.descriptorBindings.data[i].binding == static_cast<uint32_t>(feature.binding)) bound = true;
+                }
+                if (bound) continue;
+
+                bindingSet[VK_SHADER_STAGE_FRAGMENT_BIT].push_back({static_cast<uint32_t>(feature.binding), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1});
+            }
+
+            traits->descriptorLayouts = {bindingSet};
+
             // topology
             traits->primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
+            // culling and depth
+            traits->cullMode = static_cast<VkCullModeFlags>(data.cullMode);
+            traits->depthWrite = data.depthWrite == 1;
+            traits->depthCompareOp = static_cast<VkCompareOp>(data.depthCompareOp);
+
             // alpha blending
             if (data.useAlpha == 1)
             {
@@ -525,11 +790,29 @@ public:
                 traits->colorBlendAttachments.push_back(colorBlendAttachment);
             }
 
-            // create our graphics pipeline
-            pipelinebuilder->build(traits);
-
-            bindGraphicsPipeline = vsg::BindGraphicsPipeline::create(pipelinebuilder->getGraphicsPipeline());
+            // create our graphics pipeline, materials with equivalent traits get the same pipeline from the builder so share its bind command too
+            bindGraphicsPipeline = getOrCreateBindGraphicsPipeline(traits);
+            auto graphicsPipeline = bindGraphicsPipeline->pipeline.get();
             _bindGraphicsPipelineCache[idstr] = bindGraphicsPipeline;
+
+            if (bindless) _bindlessPipelines.insert(graphicsPipeline);
+            if (data.useAlpha == 1) _blendedPipelines.insert(graphicsPipeline);
+            if (billboard) _flattenInputs.unbakeablePipelines.insert(graphicsPipeline);
+
+            // with precompiled shaders the pipeline is rebuilt from reflecting its stages once every module has been built,
+            // until then it's built from the material's bindings like any other
+            if (!bindless && _settings.precompileShaders != 0 && _pendingReflections.find(graphicsPipeline) == _pendingReflections.end())
+            {
+                auto& pending = _pendingReflections[graphicsPipeline];
+                pending.id = idstr;
+                pending.bindings.assign(data.descriptorBindings.data, data.descriptorBindings.data + data.descriptorBindings.length);
+            }
+
+            // opaque pipelines that write depth get a depth only variant for depth prepasses and shadow passes
+            if (_settings.depthOnlyPipelines != 0 && data.useAlpha == 0 && data.depthWrite == 1 && _depthOnlyPipelines.find(graphicsPipeline) == _depthOnlyPipelines.end())
+            {
+                _depthOnlyPipelines[graphicsPipeline] = createDepthOnlyPipeline(data, billboard);
+            }
         }
 
         if (addToActiveStateGroup)
@@ -539,6 +822,17 @@ public:
                 DebugLog("GraphBuilder Error: No active StateGroup");
                 return false;
             }
+
+            // the depth only variant of the stategroup is attached to it as the "depthOnly" object, renderers drawing a depth
+            // prepass or shadow pass draw it in place of the stategroup's own children
+            auto depthPipeline = _depthOnlyPipelines.find(bindGraphicsPipeline->pipeline.get());
+            if (depthPipeline != _depthOnlyPipelines.end() && !getDepthOnlyNode(_activeStateGroup))
+            {
+                auto depthStateGroup = vsg::StateGroup::create();
+                depthStateGroup->add(depthPipeline->second);
+                _activeStateGroup->setObject("depthOnly", depthStateGroup);
+                _depthOnlyNodes[_activeStateGroup.get()] = depthStateGroup;
+            }
         }
         else
         {
@@ -563,54 +857,254 @@ public:
         }
         else
         {
-            if (data.use32BitIndicies == 0)
-            {
-                // for now convert the int32 array indicies to uint16
-                vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(data.triangles.length));
-                for (int32_t i = 0; i < data.triangles.length; i++)
-                {
-                    indiciesushort->set(i, static_cast<uint16_t>(data.triangles.data[i]));
-                }
-                cmd = vsg::BindIndexBuffer::create(indiciesushort);
-            }
-            else
-            {
-                vsg::ref_ptr<vsg::uintArray> indiciesuint(new vsg::uintArray(data.triangles.length));
-                for (int32_t i = 0; i < data.triangles.length; i++)
-                {
-                    indiciesuint->set(i, static_cast<uint32_t>(data.triangles.data[i]));
-                }
-
-                cmd = vsg::BindIndexBuffer::create(indiciesuint);
-            }
+            cmd = vsg::BindIndexBuffer::create(getOrCreateIndices(data));
             _bindIndexBufferCache[data.id] = cmd;
         }
         addCommandToHead(cmd);
+
+        if (auto depthCommands = getDepthOnlyNode(getHead())) dynamic_cast<vsg::Commands*>(depthCommands)->addChild(cmd);
     }
 
     void addBindVertexBuffersCommand(unity2vsg::VertexBuffersData data)
     {
         vsg::ref_ptr<vsg::Command> cmd;
+        auto key = std::make_pair(data.id, activePendingReflection());
 
-        if (_bindVertexBuffersCache.find(data.id) != _bindVertexBuffersCache.end())
+        if (_bindVertexBuffersCache.find(key) != _bindVertexBuffersCache.end())
         {
-            cmd = _bindVertexBuffersCache[data.id];
+            cmd = _bindVertexBuffersCache[key];
         }
         else
         {
-            auto inputarrays = vsg::DataList{createVsgArray<vsg::vec3>(data.verticies.data, data.verticies.length)}; // always have verticies
+            std::vector<uint32_t> locations;
+            auto bindVertexBuffers = vsg::BindVertexBuffers::create(0, createVertexArrays(data, locations));
+            if (key.second) _pendingVertexArrays.push_back({bindVertexBuffers, &bindVertexBuffers->arrays, key.second, locations});
+            cmd = bindVertexBuffers;
+            _bindVertexBuffersCache[key] = cmd;
+        }
 
-            if (data.normals.length > 0) inputarrays.push_back(createVsgArray<vsg::vec3>(data.normals.data, data.normals.length));
-            if (data.tangents.length > 0) inputarrays.push_back(createVsgArray<vsg::vec4>(data.tangents.data, data.tangents.length));
-            if (data.colors.length > 0) inputarrays.push_back(createVsgArray<vsg::vec4>(data.colors.data, data.colors.length));
-            if (data.uv0.length > 0) inputarrays.push_back(createVsgArray<vsg::vec2>(data.uv0.data, data.uv0.length));
-            if (data.uv1.length > 0) inputarrays.push_back(createVsgArray<vsg::vec2>(data.uv1.data, data.uv1.length));
+        addCommandToHead(cmd);
 
-            cmd = vsg::BindVertexBuffers::create(0, inputarrays);
-            _bindVertexBuffersCache[data.id] = cmd;
+        if (auto depthCommands = getDepthOnlyNode(getHead()))
+        {
+            auto& depthCmd = _depthOnlyBindVertexBuffersCache[data.id];
+            if (!depthCmd) depthCmd = vsg::BindVertexBuffers::create(0, vsg::DataList{getOrCreateVertexPositions(data)});
+            dynamic_cast<vsg::Commands*>(depthCommands)->addChild(depthCmd);
         }
+    }
 
-        addCommandToHead(cmd);
+    // the vertex arrays of a mesh in location order, along with the location of each. the arrays are cached on the mesh id so a mesh
+    // unity has let go of the arrays for is still drawn from what was converted
+    template<typename T>
+    vsg::DataList createVertexArrays(const T& data, std::vector<uint32_t>& locations)
+    {
+        auto& cached = _vertexArraysCache[data.id];
+        if (cached.first.empty())
+        {
+            cached.first = createMeshVertexArrays(data, cached.second);
+            if (tracksLeafData())
+            {
+                for (auto& array : cached.first) _meshArrayIds[array.get()] = data.id;
+            }
+        }
+        locations = cached.second;
+        return cached.first;
+    }
+
+    template<typename T>
+    vsg::DataList createMeshVertexArrays(const T& data, std::vector<uint32_t>& locations)
+    {
+        auto inputarrays = vsg::DataList{getOrCreateVertexPositions(data)}; // always have verticies
+        locations = {0};
+
+        if (data.normals.length > 0)
+        {
+            inputarrays.push_back(createExternalArray<vsg::vec3>(data.normals.data, data.normals.length));
+            _flattenInputs.normalArrays.insert(inputarrays.back().get());
+            locations.push_back(1);
+        }
+        if (data.tangents.length > 0)
+        {
+            inputarrays.push_back(createExternalArray<vsg::vec4>(data.tangents.data, data.tangents.length));
+            _flattenInputs.tangentArrays.insert(inputarrays.back().get());
+            locations.push_back(2);
+        }
+        if (data.colors.length > 0)
+        {
+            inputarrays.push_back(createExternalArray<vsg::vec4>(data.colors.data, data.colors.length));
+            locations.push_back(3);
+        }
+        if (data.uv0.length > 0)
+        {
+            inputarrays.push_back(createExternalArray<vsg::vec2>(data.uv0.data, data.uv0.length));
+            locations.push_back(4);
+        }
+        if (data.uv1.length > 0)
+        {
+            inputarrays.push_back(createExternalArray<vsg::vec2>(data.uv1.data, data.uv1.length));
+            locations.push_back(5);
+        }
+
+        return inputarrays;
+    }
+
+    // an array of memory owned by unity, streaming lets go of these once written rather than freeing them
+    template<typename T>
+    vsg::ref_ptr<vsg::Array<T>> createExternalArray(T* ptr, uint32_t length)
+    {
+        auto array = createVsgArray<T>(ptr, length);
+        if (tracksLeafData()) _externalData.insert(array.get());
+        return array;
+    }
+
+    // the position stream of a mesh, shared by every draw of the mesh so depth only draws reference the same 12 byte per vertex array
+    template<typename T>
+    vsg::ref_ptr<vsg::Data> getOrCreateVertexPositions(const T& data)
+    {
+        auto& positions = _vertexPositionsCache[data.id];
+        if (positions) return positions;
+
+        // positions streaming leaves in place are read when the export ends, after unity may have let go of the mesh
+        if (_leafStream && keepLeafGeometry())
+        {
+            vsg::ref_ptr<vsg::vec3Array> copy(new vsg::vec3Array(data.verticies.length));
+            std::memcpy(copy->dataPointer(), data.verticies.data, copy->dataSize());
+            positions = copy;
+        }
+        else
+        {
+            positions = createExternalArray<vsg::vec3>(data.verticies.data, data.verticies.length);
+        }
+
+        if (tracksLeafData()) _meshArrayIds[positions.get()] = data.id;
+        return positions;
+    }
+
+    // the indices of a mesh, converted to 16 bit unless the mesh uses 32 bit indices and shared by every draw of the mesh
+    template<typename T>
+    vsg::ref_ptr<vsg::Data> getOrCreateIndices(const T& data)
+    {
+        auto& indices = _indicesCache[data.id];
+        if (indices) return indices;
+
+        if (data.use32BitIndicies == 0)
+        {
+            // for now convert the int32 array indicies to uint16
+            vsg::ref_ptr<vsg::ushortArray> indiciesushort(new vsg::ushortArray(data.triangles.length));
+            for (int32_t i = 0; i < data.triangles.length; i++)
+            {
+                indiciesushort->set(i, static_cast<uint16_t>(data.triangles.data[i]));
+            }
+            indices = indiciesushort;
+        }
+        else
+        {
+            vsg::ref_ptr<vsg::uintArray> indiciesuint(new vsg::uintArray(data.triangles.length));
+            for (int32_t i = 0; i < data.triangles.length; i++)
+            {
+                indiciesuint->set(i, static_cast<uint32_t>(data.triangles.data[i]));
+            }
+            indices = indiciesuint;
+        }
+
+        if (tracksLeafData()) _meshArrayIds[indices.get()] = data.id;
+        return indices;
+    }
+
+    // build a pipeline from traits, equivalent pipelines share one bind command. the traits of each distinct pipeline are kept
+    // so it can be rebuilt once its shader modules are collapsed
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> getOrCreateBindGraphicsPipeline(vsg::ref_ptr<vsg::GraphicsPipelineBuilder::Traits> traits)
+    {
+        _pipelineBuilder->build(traits);
+        auto graphicsPipeline = _pipelineBuilder->getGraphicsPipeline();
+
+        auto& bindGraphicsPipeline = _bindGraphicsPipelines[graphicsPipeline];
+        if (!bindGraphicsPipeline)
+        {
+            bindGraphicsPipeline = vsg::BindGraphicsPipeline::create(graphicsPipeline);
+            _pipelineTraits.emplace_back(bindGraphicsPipeline, traits);
+        }
+        return bindGraphicsPipeline;
+    }
+
+    // a pipeline drawing only the depth of meshes, position is its one vertex input and it has no fragment stage or color writes
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> createDepthOnlyPipeline(const PipelineData& data, bool billboard)
+    {
+        auto traits = vsg::GraphicsPipelineBuilder::Traits::create();
+        traits->vertexAttributeDescriptions[VK_VERTEX_INPUT_RATE_VERTEX] = {{{0, VK_FORMAT_R32G32B32_SFLOAT}}};
+
+        std::map<uint32_t, uint32_t> featureConstants;
+        bool bindless = false;
+        auto vertShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_VERTEX_BIT, std::string(), VERTEX, 0, billboard ? "VSG_BILLBOARD" : "", featureConstants, bindless);
+        traits->shaderStages = {createShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, UIntArray{nullptr, 0}, featureConstants)};
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+        colorBlendAttachment.blendEnable = VK_FALSE;
+        colorBlendAttachment.colorWriteMask = 0;
+        traits->colorBlendAttachments.push_back(colorBlendAttachment);
+
+        traits->primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        traits->cullMode = static_cast<VkCullModeFlags>(data.cullMode);
+        traits->depthWrite = true;
+        traits->depthCompareOp = static_cast<VkCompareOp>(data.depthCompareOp);
+
+        return getOrCreateBindGraphicsPipeline(traits);
+    }
+
+    // hlod proxies are drawn with the generated lit shaders sampling the cluster's atlas as their diffuse map
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> createProxyPipeline()
+    {
+        auto traits = vsg::GraphicsPipelineBuilder::Traits::create();
+        traits->vertexAttributeDescriptions[VK_VERTEX_INPUT_RATE_VERTEX] = {{{0, VK_FORMAT_R32G32B32_SFLOAT}}, {{1, VK_FORMAT_R32G32B32_SFLOAT}}, {{4, VK_FORMAT_R32G32_SFLOAT}}};
+
+        vsg::GraphicsPipelineBuilder::Traits::DescriptorBindingSet bindingSet;
+        bindingSet[VK_SHADER_STAGE_FRAGMENT_BIT].push_back({0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1});
+        traits->descriptorLayouts = {bindingSet};
+
+        uint32_t inputAtts = VERTEX | NORMAL | TEXCOORD0;
+        uint32_t shaderMode = LIGHTING | DIFFUSE_MAP;
+        std::map<uint32_t, uint32_t> featureConstants;
+        bool bindless = false;
+        auto vertShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_VERTEX_BIT, std::string(), inputAtts, shaderMode, "", featureConstants, bindless);
+        auto fragShaderModule = getOrCreateShaderModule(VK_SHADER_STAGE_FRAGMENT_BIT, std::string(), inputAtts, shaderMode, "", featureConstants, bindless);
+        traits->shaderStages = {createShaderStage(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule, UIntArray{nullptr, 0}, featureConstants),
+                                createShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule, UIntArray{nullptr, 0}, featureConstants)};
+
+        traits->primitiveTopology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+        return getOrCreateBindGraphicsPipeline(traits);
+    }
+
+    // the state a proxy is drawn under, its atlas is sampled without filtering so each material's texel stays a flat color
+    vsg::ref_ptr<vsg::StateGroup> createProxyState(vsg::ref_ptr<vsg::Data> atlas)
+    {
+        if (!_proxyPipeline) return {};
+
+        atlas->setLayout(GetSizeInfoForFormat(VK_FORMAT_R8G8B8A8_UNORM).layout);
+
+        auto sampler = vsg::Sampler::create();
+        sampler->minFilter = VK_FILTER_NEAREST;
+        sampler->magFilter = VK_FILTER_NEAREST;
+        sampler->mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampler->addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler->addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampler->addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+        auto layout = _proxyPipeline->pipeline->layout;
+        auto texture = vsg::DescriptorImage::create(vsg::ImageInfoList{vsg::ImageInfo::create(sampler, atlas)}, 0, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        auto descriptorSet = vsg::DescriptorSet::create(layout->setLayouts.front(), vsg::Descriptors{texture});
+
+        auto stategroup = vsg::StateGroup::create();
+        stategroup->add(_proxyPipeline);
+        stategroup->add(vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, descriptorSet));
+        return stategroup;
+    }
+
+    // the active pipeline if it's to be rebuilt from reflecting its shaders, what's drawn with it is fitted to it then
+    vsg::GraphicsPipeline* activePendingReflection() const
+    {
+        auto itr = _pendingReflections.find(_activeGraphicsPipeline.get());
+        return itr != _pendingReflections.end() ? itr->first : nullptr;
     }
 
     void addDrawIndexedCommand(unity2vsg::DrawIndexedData data)
@@ -627,6 +1121,8 @@ public:
             _drawIndexedCache[data.id] = cmd;
         }
         addCommandToHead(cmd);
+
+        if (auto depthCommands = getDepthOnlyNode(getHead())) dynamic_cast<vsg::Commands*>(depthCommands)->addChild(cmd);
     }
 
     void createBindDescriptorSetCommand(bool addToStateGroup)
@@ -657,17 +1153,37 @@ public:
                 fullid += "-";
         }
 
+        if (_bindlessPipelines.find(_activeGraphicsPipeline) != _bindlessPipelines.end())
+        {
+            addBindlessMaterialCommands(fullid, addToStateGroup);
+            recordMaterialColor(_bindlessMaterials[fullid]);
+            clearDescriptors();
+            return;
+        }
+
+        // sets are shared by the materials binding the same descriptors with the same set layout, sets bound with a pipeline that's
+        // to be rebuilt from reflection are kept to that pipeline until they're fitted to the layout it ends up with
+        auto setLayout = _activeGraphicsPipeline->layout->setLayouts.front();
+        auto pendingReflection = activePendingReflection();
+        auto key = std::make_pair(fullid, pendingReflection ? static_cast<const vsg::Object*>(pendingReflection) : setLayout.get());
+
         vsg::ref_ptr<vsg::BindDescriptorSet> bindDescriptorSet;
 
-        if (_bindDescriptorSetCache.find(fullid) != _bindDescriptorSetCache.end())
+        if (_bindDescriptorSetCache.find(key) != _bindDescriptorSetCache.end())
         {
-            bindDescriptorSet = _bindDescriptorSetCache[fullid];
+            bindDescriptorSet = _bindDescriptorSetCache[key];
         }
         else
         {
-            auto descriptorSet = vsg::DescriptorSet::create(_activeGraphicsPipeline->layout->setLayouts.front(), _descriptors);
+            vsg::Descriptors descriptors = _descriptors;
+            fitDescriptors(descriptors, *setLayout);
+
+            auto descriptorSet = vsg::DescriptorSet::create(setLayout, descriptors);
             bindDescriptorSet = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS, _activeGraphicsPipeline->layout, 0, descriptorSet);
-            _bindDescriptorSetCache[fullid] = bindDescriptorSet;
+            _bindDescriptorSetCache[key] = bindDescriptorSet;
+            recordMaterialColor(bindDescriptorSet);
+
+            if (pendingReflection) _pendingDescriptorSets.push_back({fullid, bindDescriptorSet, pendingReflection});
         }
 
         if (addToStateGroup)
@@ -685,11 +1201,152 @@ public:
             }
         }
 
+        clearDescriptors();
+    }
+
+    void clearDescriptors()
+    {
         _descriptors.clear();
         _descriptorObjectIds.clear();
+        _descriptorTextures.clear();
+        _descriptorBlockData.clear();
+        _descriptorColors.clear();
     }
 
-    //
+    // the color proxies draw a material with, the average color of its lowest bound texture tinted by its first color uniform
+    void recordMaterialColor(vsg::Object* command)
+    {
+        if (_settings.hlodClusterSize <= 0.0f || !command) return;
+
+        vsg::vec4 color(1.0f, 1.0f, 1.0f, 1.0f);
+
+        const std::pair<uint32_t, vsg::ref_ptr<vsg::DescriptorImage>>* lowest = nullptr;
+        for (auto& texture : _descriptorTextures)
+        {
+            if (!lowest || texture.first < lowest->first) lowest = &texture;
+        }
+        if (lowest)
+        {
+            auto itr = _textureColors.find(lowest->second.get());
+            if (itr != _textureColors.end()) color = itr->second;
+        }
+
+        if (!_descriptorColors.empty())
+        {
+            const vsg::vec4& tint = _descriptorColors.front();
+            color = vsg::vec4(color.x * tint.x, color.y * tint.y, color.z * tint.z, color.w * tint.w);
+        }
+
+        _hlodInputs.materialColors[command] = color;
+    }
+
+    // bind the shared bindless set and push the offset of the material's record, recording the material on first use
+    void addBindlessMaterialCommands(const std::string& fullid, bool addToStateGroup)
+    {
+        if (!_bindlessDescriptorSet)
+        {
+            // the descriptors are created by finalizeBindlessMaterials once every texture and material is known
+            _bindlessDescriptorSet = vsg::DescriptorSet::create(_activeGraphicsPipeline->layout->setLayouts.front(), vsg::Descriptors());
+            _bindBindlessDescriptorSet = vsg::BindDescriptorSet::create(VK_PIPELINE_BIND_POINT_GRAPHICS, _activeGraphicsPipeline->layout, 0, _bindlessDescriptorSet);
+            _bindlessImages.push_back(getOrCreatePlaceholderImage()); // index 0 is sampled by bindings the material has no texture for
+        }
+
+        vsg::ref_ptr<vsg::PushConstants> pushMaterial;
+
+        if (_bindlessMaterials.find(fullid) != _bindlessMaterials.end())
+        {
+            pushMaterial = _bindlessMaterials[fullid];
+        }
+        else
+        {
+            size_t carried = _descriptorTextures.size() + (_descriptorBlockData.empty() ? 0 : 1);
+            if (_descriptors.size() > carried)
+            {
+                DebugLog("GraphBuilder Warning: Bindless materials only carry textures and a packed uniform block, other uniforms of '" + fullid + "' are dropped");
+            }
+
+            std::vector<uint32_t> record(BINDLESS_TEXTURE_SLOTS, 0);
+            for (auto& texture : _descriptorTextures)
+            {
+                if (texture.first >= BINDLESS_TEXTURE_SLOTS)
+                {
+                    DebugLog("GraphBuilder Warning: Texture binding " + std::to_string(texture.first) + " is outside the bindless texture slots and is dropped");
+                    continue;
+                }
+                record[texture.first] = getOrCreateBindlessTextureIndex(texture.second);
+            }
+            for (float value : _descriptorBlockData)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(float));
+                record.push_back(bits);
+            }
+
+            uint32_t materialOffset = static_cast<uint32_t>(_bindlessMaterialData.size());
+            _bindlessMaterialData.insert(_bindlessMaterialData.end(), record.begin(), record.end());
+
+            pushMaterial = vsg::PushConstants::create(VK_SHADER_STAGE_FRAGMENT_BIT, BINDLESS_MATERIAL_OFFSET, vsg::uintValue::create(materialOffset));
+            _bindlessMaterials[fullid] = pushMaterial;
+        }
+
+        for (vsg::ref_ptr<vsg::StateCommand> command : {vsg::ref_ptr<vsg::StateCommand>(_bindBindlessDescriptorSet), vsg::ref_ptr<vsg::StateCommand>(pushMaterial)})
+        {
+            if (addToStateGroup)
+            {
+                if (!addStateCommandToActiveStateGroup(command)) DebugLog("GraphBuilder Error: No Active StateGroup");
+            }
+            else
+            {
+                if (!addCommandToHead(command)) DebugLog("GraphBuilder Error: Current head is not a Commands node");
+            }
+        }
+    }
+
+    // index of a texture's first image in the bindless texture array, array textures occupy consecutive indices. textures that
+    // don't fit in the capacity get the placeholder at index 0 so no index is outside the array
+    uint32_t getOrCreateBindlessTextureIndex(vsg::DescriptorImage* texture)
+    {
+        auto itr = _bindlessTextureIndices.find(texture);
+        if (itr != _bindlessTextureIndices.end()) return itr->second;
+
+        uint32_t index = static_cast<uint32_t>(_bindlessImages.size());
+        auto& imageInfos = _textureImageInfos[texture];
+        if (index + imageInfos.size() > static_cast<size_t>(_settings.bindlessTextureCapacity))
+        {
+            DebugLog("GraphBuilder Error: Texture doesn't fit in the bindless texture capacity of " + std::to_string(_settings.bindlessTextureCapacity) + ", materials using it sample the placeholder");
+            _bindlessTextureIndices[texture] = 0;
+            return 0;
+        }
+
+        _bindlessImages.insert(_bindlessImages.end(), imageInfos.begin(), imageInfos.end());
+        _bindlessTextureIndices[texture] = index;
+        return index;
+    }
+
+    // fill the shared bindless set now every texture and material record is known
+    void finalizeBindlessMaterials()
+    {
+        if (!_bindlessDescriptorSet) return;
+
+        // the layout declares a fixed number of textures, any the export doesn't use are the placeholder. textures past the
+        // capacity were given the placeholder's index as they were added
+        uint32_t capacity = static_cast<uint32_t>(_settings.bindlessTextureCapacity);
+        vsg::ImageInfoList images = _bindlessImages;
+        images.resize(capacity, _bindlessImages.front());
+
+        vsg::ref_ptr<vsg::uintArray> materials(new vsg::uintArray(static_cast<uint32_t>(_bindlessMaterialData.size())));
+        for (size_t i = 0; i < _bindlessMaterialData.size(); i++)
+        {
+            materials->set(i, _bindlessMaterialData[i]);
+        }
+
+        _bindlessDescriptorSet->descriptors = {vsg::DescriptorImage::create(images, BINDLESS_TEXTURES_BINDING, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
+                                               vsg::DescriptorBuffer::create(materials, BINDLESS_MATERIALS_BINDING, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)};
+
+        DebugLog("GraphBuilder: " + std::to_string(_bindlessMaterials.size()) + " bindless materials sharing " + std::to_string(_bindlessImages.size()) + " textures");
+    }
+
+    //
     // Descriptors
     //
 
@@ -747,18 +1404,21 @@ public:
 
                 // 1 component
                 case VK_FORMAT_R16_UNORM:
+                case VK_FORMAT_R16_SFLOAT:
                 {
                     texdata = vsg::ref_ptr<vsg::Data>(new vsg::ushortArray2D(data.width, data.height, reinterpret_cast<uint16_t*>(data.pixels.data)));
                     break;
                 }
                 // 2 component
                 case VK_FORMAT_R16G16_UNORM:
+                case VK_FORMAT_R16G16_SFLOAT:
                 {
                     texdata = vsg::ref_ptr<vsg::Data>(new vsg::usvec2Array2D(data.width, data.height, reinterpret_cast<vsg::usvec2*>(data.pixels.data)));
                     break;
                 }
                 // 4 component
                 case VK_FORMAT_R16G16B16A16_UNORM:
+                case VK_FORMAT_R16G16B16A16_SFLOAT:
                 {
                     texdata = vsg::ref_ptr<vsg::Data>(new vsg::usvec4Array2D(data.width, data.height, reinterpret_cast<vsg::usvec4*>(data.pixels.data)));
                     break;
@@ -769,6 +1429,8 @@ public:
 
                 // 1 component
                 case VK_FORMAT_R32_UINT:
+                case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+                case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
                 {
                     texdata = vsg::ref_ptr<vsg::Data>(new vsg::uintArray2D(data.width, data.height, reinterpret_cast<uint32_t*>(data.pixels.data)));
                     break;
@@ -786,6 +1448,28 @@ public:
                     break;
                 }
 
+                //
+                // float32 formats
+
+                // 1 component
+                case VK_FORMAT_R32_SFLOAT:
+                {
+                    texdata = vsg::ref_ptr<vsg::Data>(new vsg::floatArray2D(data.width, data.height, reinterpret_cast<float*>(data.pixels.data)));
+                    break;
+                }
+                // 2 component
+                case VK_FORMAT_R32G32_SFLOAT:
+                {
+                    texdata = vsg::ref_ptr<vsg::Data>(new vsg::vec2Array2D(data.width, data.height, reinterpret_cast<vsg::vec2*>(data.pixels.data)));
+                    break;
+                }
+                // 4 component
+                case VK_FORMAT_R32G32B32A32_SFLOAT:
+                {
+                    texdata = vsg::ref_ptr<vsg::Data>(new vsg::vec4Array2D(data.width, data.height, reinterpret_cast<vsg::vec4*>(data.pixels.data)));
+                    break;
+                }
+
                 default: break;
                 }
             }
@@ -850,17 +1534,74 @@ public:
         else
         {
             vsg::ImageInfoList imageInfos;
+            vsg::vec4 averageColor;
+            bool averaged = false;
             for (int i = 0; i < data.descriptorCount; i++)
             {
-                vsg::ref_ptr<vsg::Data> texdata = createDataForTexture(data.images[i]);
+                // an image bound by several textures is converted once, unity may have let go of its pixels since
+                auto& cachedImage = _imageCache[data.images[i].id];
+                if (useCache && cachedImage.imageInfo)
+                {
+                    imageInfos.push_back(cachedImage.imageInfo);
+                    if (i == 0)
+                    {
+                        averaged = cachedImage.averaged;
+                        averageColor = cachedImage.averageColor;
+                    }
+                    continue;
+                }
+
+                ImageData imageData = data.images[i];
+                vsg::ref_ptr<vsg::Objects> virtualTexture;
+                vsg::ref_ptr<vsg::ubyteArray> convertedPixels;
+
+                // formats vulkan can't sample directly are converted on the cpu
+                if (requiresFormatConversion(imageData))
+                {
+                    ImageData converted;
+                    convertedPixels = convertImageData(imageData, converted);
+                    if (!convertedPixels.valid()) return {};
+                    imageData = converted;
+                }
+
+                // proxies of hlod clusters are drawn with the average color of a material's texture, every image is averaged as it
+                // could come first in another texture
+                if (_settings.hlodClusterSize > 0.0f) cachedImage.averaged = averageImageColor(imageData, cachedImage.averageColor);
+                if (i == 0)
+                {
+                    averaged = cachedImage.averaged;
+                    averageColor = cachedImage.averageColor;
+                }
+
+                // large textures are paged out to the tile store leaving only their mip tail resident
+                if (_virtualTextures && _virtualTextures->requiresVirtualTexture(imageData))
+                {
+                    ImageData mipTail;
+                    virtualTexture = _virtualTextures->add(imageData, mipTail);
+                    if (virtualTexture) imageData = mipTail;
+                }
+
+                vsg::ref_ptr<vsg::Data> texdata = createDataForTexture(imageData);
                 if (!texdata.valid()) return {};
 
-                vsg::ref_ptr<vsg::Sampler> sampler = createSamplerForTextureData(data.images[i]);
+                if (virtualTexture) texdata->setObject("virtualTexture", virtualTexture);
+
+                // the tile store is cut from the source pixels when the export ends, so converted pixels that were paged stay with the
+                // virtual texture rather than the resident mip tail
+                if (convertedPixels) _convertedPixels[virtualTexture ? static_cast<vsg::Object*>(virtualTexture.get()) : texdata.get()] = convertedPixels;
+                if (tracksLeafData()) _externalData.insert(texdata.get());
+
+                vsg::ref_ptr<vsg::Sampler> sampler = createSamplerForTextureData(imageData);
 
                 imageInfos.push_back(vsg::ImageInfo::create(sampler, texdata));
+                if (useCache) cachedImage.imageInfo = imageInfos.back();
             }
 
             texture = vsg::DescriptorImage::create(imageInfos, data.binding, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+            if (averaged) _textureColors[texture.get()] = averageColor;
+
+            // bindless materials add the images to the shared texture array instead of binding the texture
+            if (_settings.bindlessTextureCapacity > 0) _textureImageInfos[texture] = imageInfos;
 
             if (useCache) _textureCache[data.id] = texture;
         }
@@ -868,11 +1609,59 @@ public:
         return texture;
     }
 
+    // a 1x1 white image for a binding a specialized or bindless shader declares but the material has no texture for
+    vsg::ref_ptr<vsg::ImageInfo> getOrCreatePlaceholderImage()
+    {
+        if (_placeholderImage) return _placeholderImage;
+
+        auto pixels = vsg::ubvec4Array2D::create(1, 1);
+        pixels->set(0, 0, vsg::ubvec4(255, 255, 255, 255));
+        pixels->setLayout(GetSizeInfoForFormat(VK_FORMAT_R8G8B8A8_UNORM).layout);
+
+        _placeholderImage = vsg::ImageInfo::create(vsg::Sampler::create(), pixels);
+        return _placeholderImage;
+    }
+
+    // fit descriptors to the bindings of a set layout, leaving out the ones it has no binding for and giving the samplers it
+    // has that no descriptor fills a placeholder. materials sharing a pipeline can each provide different bindings of its layout
+    void fitDescriptors(vsg::Descriptors& descriptors, const vsg::DescriptorSetLayout& setLayout)
+    {
+        auto inLayout = [&setLayout](uint32_t binding) {
+            return std::any_of(setLayout.bindings.begin(), setLayout.bindings.end(), [binding](const VkDescriptorSetLayoutBinding& layoutBinding) { return layoutBinding.binding == binding; });
+        };
+        auto notInLayout = [&inLayout](const vsg::ref_ptr<vsg::Descriptor>& descriptor) { return !inLayout(descriptor->dstBinding); };
+        descriptors.erase(std::remove_if(descriptors.begin(), descriptors.end(), notInLayout), descriptors.end());
+
+        for (auto& layoutBinding : setLayout.bindings)
+        {
+            auto isBound = [&layoutBinding](const vsg::ref_ptr<vsg::Descriptor>& descriptor) { return descriptor->dstBinding == layoutBinding.binding; };
+            if (std::any_of(descriptors.begin(), descriptors.end(), isBound)) continue;
+
+            if (layoutBinding.descriptorType != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || layoutBinding.descriptorCount != 1)
+            {
+                DebugLog("GraphBuilder Error: Nothing provides binding " + std::to_string(layoutBinding.binding) + " of a descriptor set");
+                continue;
+            }
+            descriptors.push_back(getOrCreatePlaceholderTexture(layoutBinding.binding));
+        }
+    }
+
+    vsg::ref_ptr<vsg::DescriptorImage> getOrCreatePlaceholderTexture(uint32_t binding)
+    {
+        auto itr = _placeholderTextures.find(binding);
+        if (itr != _placeholderTextures.end()) return itr->second;
+
+        auto texture = vsg::DescriptorImage::create(vsg::ImageInfoList{getOrCreatePlaceholderImage()}, binding, 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        _placeholderTextures[binding] = texture;
+        return texture;
+    }
+
     void addTexture(const DescriptorImageData& data)
     {
         auto texture = createTexture(data);
         _descriptors.push_back(texture);
         _descriptorObjectIds.push_back(std::to_string(data.id));
+        _descriptorTextures.push_back({static_cast<uint32_t>(data.binding), texture});
     }
 
     //
@@ -907,6 +1696,7 @@ public:
         //vecval->value() = data.value;
         vecval->value() = vsg::vec4(data.value.data[0], data.value.data[1], data.value.data[2], data.value.data[3]);
         _descriptors.push_back(vsg::DescriptorBuffer::create(vecval, data.binding));
+        _descriptorColors.push_back(vecval->value());
         _descriptorObjectIds.push_back(std::to_string(data.id));
     }
 
@@ -924,6 +1714,19 @@ public:
         _descriptorObjectIds.push_back(std::to_string(data.id));
     }
 
+    void addDescriptorBuffer(DescriptorUniformBlockData data)
+    {
+        // copy the packed values, the native array is freed once the export ends
+        vsg::ref_ptr<vsg::floatArray> block(new vsg::floatArray(data.value.length));
+        for (int i = 0; i < data.value.length; i++)
+        {
+            block->at(i) = data.value.data[i];
+        }
+        _descriptors.push_back(vsg::DescriptorBuffer::create(block, data.binding));
+        _descriptorObjectIds.push_back(std::to_string(data.id));
+        _descriptorBlockData.assign(data.value.data, data.value.data + data.value.length);
+    }
+
     //
     // Helpers
     //
@@ -934,6 +1737,19 @@ public:
         return _nodeStack[_nodeStack.size() - 1];
     }
 
+    vsg::Node* getParentOfHead()
+    {
+        if (_nodeStack.size() < 2) return nullptr;
+        return _nodeStack[_nodeStack.size() - 2];
+    }
+
+    // the depth only twin of a node, null if it has none
+    vsg::Node* getDepthOnlyNode(vsg::Node* node)
+    {
+        auto itr = _depthOnlyNodes.find(node);
+        return itr != _depthOnlyNodes.end() ? itr->second.get() : nullptr;
+    }
+
     vsg::Group* getHeadAsGroup()
     {
         if (_nodeStack.size() == 0) return nullptr;
@@ -1011,27 +1827,517 @@ public:
 
     void popNodeFromStack()
     {
+        auto node = _nodeStack.back();
         _nodeStack.pop_back();
+
+        // nothing is added to a subgraph once its node ends, so its leaf data can be written out and released
+        if (_leafStream) releaseStreamedData(_leafStream->stream(node, keepLeafGeometry()));
+    }
+
+    // leaf data written to a leaf file, the arrays of unity's memory are tracked from the start of the export so they're let go of
+    bool tracksLeafData() const
+    {
+        return _settings.streamLeafData != 0 || _settings.packLeafData != 0;
+    }
+
+    // cull hierarchies, hlod clusters and potentially visible sets read vertex positions and indices when the export ends
+    bool keepLeafGeometry() const
+    {
+        return _settings.cullHierarchyLeafSize > 0 || _settings.hlodClusterSize > 0.0f || _settings.pvsCellSize > 0.0f;
+    }
+
+    // free the arrays streamed out, arrays of unity's memory only let go of it. the mesh caches hand out placeholders from now on
+    void releaseStreamedData(const LeafStreamWriter::Replacements& replacements)
+    {
+        for (auto& replacement : replacements)
+        {
+            vsg::Data* original = replacement.first.get();
+            if (_externalData.erase(original) > 0) releaseExternalData(original);
+            _convertedPixels.erase(original);
+            _flattenInputs.normalArrays.erase(original);
+            _flattenInputs.tangentArrays.erase(original);
+
+            auto meshArray = _meshArrayIds.find(original);
+            if (meshArray != _meshArrayIds.end())
+            {
+                auto replace = [&replacement](vsg::ref_ptr<vsg::Data>& data) {
+                    if (data == replacement.first) data = replacement.second;
+                };
+
+                int id = meshArray->second;
+                if (_vertexPositionsCache.count(id)) replace(_vertexPositionsCache[id]);
+                if (_indicesCache.count(id)) replace(_indicesCache[id]);
+                if (_vertexArraysCache.count(id))
+                {
+                    for (auto& array : _vertexArraysCache[id].first) replace(array);
+                }
+                _meshArrayIds.erase(meshArray);
+            }
+        }
+    }
+
+    // let go of an array of unity's memory, unity frees the memory it allocated for the export once the pointer is taken back
+    void releaseExternalData(vsg::Data* data)
+    {
+        if (data->dataPointer()) _releasedData.push_back(data->dataPointer());
+        data->dataRelease();
+    }
+
+    // hand back up to capacity pointers to unity's memory let go of since last taken
+    uint32_t takeReleasedData(void** pointers, uint32_t capacity)
+    {
+        uint32_t count = std::min(capacity, static_cast<uint32_t>(_releasedData.size()));
+        std::copy(_releasedData.end() - count, _releasedData.end(), pointers);
+        _releasedData.resize(_releasedData.size() - count);
+        return count;
+    }
+
+    // block until every queued shader module has been built
+    void waitForShaders()
+    {
+        for (auto& task : _shaderTasks)
+        {
+            try
+            {
+                task.get();
+            }
+            catch (const std::exception& e)
+            {
+                DebugLog("GraphBuilder Error: Exception while building shader, " + std::string(e.what()));
+            }
+        }
+        _shaderTasks.clear();
+    }
+
+    // reflect the precompiled stages of a pipeline, their modules must have been built. collects the stages accessing each set 0
+    // binding and the vertex input locations the vertex stage reads, false if any stage has no spirv to reflect
+    bool reflectShaderStages(const vsg::ShaderStages& shaderStages, std::map<uint32_t, std::pair<SPIRVDescriptorBinding, VkShaderStageFlags>>& bindings, uint32_t& vertexLocations)
+    {
+        for (auto& shaderStage : shaderStages)
+        {
+            SPIRVReflection reflection;
+            if (shaderStage->module->code.empty() || !reflectSPIRV(shaderStage->module->code, reflection)) return false;
+
+            for (auto& binding : reflection.descriptorBindings)
+            {
+                if (binding.set != 0 || !binding.used) continue;
+                auto& entry = bindings[binding.binding];
+                entry.first = binding;
+                entry.second |= shaderStage->stage;
+            }
+
+            if (shaderStage->stage != VK_SHADER_STAGE_VERTEX_BIT) continue;
+            for (auto& input : reflection.inputs)
+            {
+                if (input.used) vertexLocations |= 1u << input.location;
+            }
+        }
+        return true;
+    }
+
+    // set a pipeline's layout and vertex inputs from reflecting its stages. bindings the material provides that no stage reads
+    // are dropped, samplers a stage reads that the material doesn't provide are kept for a placeholder and vertex streams the
+    // vertex stage doesn't read are left out. false leaving the traits as they are if the stages can't be reflected
+    bool reflectPipeline(const PendingReflection& pending, vsg::GraphicsPipelineBuilder::Traits& traits, uint32_t& vertexLocations)
+    {
+        std::map<uint32_t, std::pair<SPIRVDescriptorBinding, VkShaderStageFlags>> reflectedBindings;
+        vertexLocations = 1u; // position is always kept
+        if (!reflectShaderStages(traits.shaderStages, reflectedBindings, vertexLocations)) return false;
+
+        vsg::GraphicsPipelineBuilder::Traits::DescriptorBindingSet bindingSet;
+        for (auto& dslb : pending.bindings)
+        {
+            auto itr = reflectedBindings.find(dslb.binding);
+            if (itr == reflectedBindings.end())
+            {
+                DebugLog("GraphBuilder: Binding " + std::to_string(dslb.binding) + " of pipeline '" + pending.id + "' is unused by its shaders and is dropped");
+                continue;
+            }
+            bindingSet[itr->second.second].push_back({dslb.binding, dslb.descriptorType, dslb.descriptorCount});
+            reflectedBindings.erase(itr);
+        }
+
+        for (auto& entry : reflectedBindings)
+        {
+            const SPIRVDescriptorBinding& binding = entry.second.first;
+            if (binding.type != VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || binding.count != 1)
+            {
+                DebugLog("GraphBuilder Error: Shaders of pipeline '" + pending.id + "' read binding " + std::to_string(binding.binding) + " which the material doesn't provide");
+                continue;
+            }
+            bindingSet[entry.second.second].push_back({binding.binding, binding.type, 1});
+        }
+        traits.descriptorLayouts = {bindingSet};
+
+        auto& inputAttributes = traits.vertexAttributeDescriptions[VK_VERTEX_INPUT_RATE_VERTEX];
+        vsg::GraphicsPipelineBuilder::Traits::InputAttributeDescriptions readAttributes;
+        for (auto& attribute : inputAttributes)
+        {
+            if (vertexLocations & (1u << attribute.front().first)) readAttributes.push_back(attribute);
+        }
+        inputAttributes = readAttributes;
+        return true;
+    }
+
+    // leave the vertex arrays at locations a reflected pipeline doesn't read out of what's drawn with it, the arrays left out
+    // are added to pruned
+    void pruneVertexArrays(vsg::BufferInfoList& arrays, const std::vector<uint32_t>& locations, uint32_t vertexLocations, vsg::DataList& pruned)
+    {
+        vsg::BufferInfoList kept;
+        for (size_t i = 0; i < arrays.size(); i++)
+        {
+            if (i >= locations.size() || (vertexLocations & (1u << locations[i])))
+                kept.push_back(arrays[i]);
+            else if (arrays[i]->data)
+                pruned.push_back(arrays[i]->data);
+        }
+        arrays.swap(kept);
+    }
+
+    // free the pruned arrays no other draw of their mesh reads, arrays of unity's memory are let go of rather than freed. arrays
+    // already streamed out were replaced, the replacement is freed as usual
+    void releasePrunedArrays(vsg::DataList& pruned)
+    {
+        // nothing converts a mesh once pipelines are rebuilt, so the cache no longer holds on to arrays
+        _vertexArraysCache.clear();
+
+        std::map<vsg::Data*, unsigned int> prunedCounts;
+        for (auto& data : pruned) ++prunedCounts[data.get()];
+
+        for (auto& prunedCount : prunedCounts)
+        {
+            // still drawn from unless only the pruned list references it
+            vsg::Data* data = prunedCount.first;
+            if (data->referenceCount() > prunedCount.second) continue;
+
+            if (!tracksLeafData() || _externalData.erase(data) > 0) releaseExternalData(data);
+            _flattenInputs.normalArrays.erase(data);
+            _flattenInputs.tangentArrays.erase(data);
+            _meshArrayIds.erase(data);
+        }
+        pruned.clear();
+    }
+
+    // point every stage whose module built to the same spirv (or the same source if not precompiled) at a single module
+    void collapseShaderModules()
+    {
+        auto hashModule = [](const vsg::ShaderModule* shaderModule) {
+            // fnv-1a
+            uint64_t hash = 0xCBF29CE484222325ull;
+            auto hashBytes = [&hash](const void* data, size_t size) {
+                for (size_t i = 0; i < size; i++)
+                {
+                    hash ^= static_cast<const unsigned char*>(data)[i];
+                    hash *= 0x100000001B3ull;
+                }
+            };
+            hashBytes(shaderModule->code.data(), shaderModule->code.size() * sizeof(uint32_t));
+            if (shaderModule->code.empty()) hashBytes(shaderModule->source.data(), shaderModule->source.size());
+            return hash;
+        };
+
+        auto sameModule = [](const vsg::ShaderModule* lhs, const vsg::ShaderModule* rhs) {
+            if (!lhs->code.empty() || !rhs->code.empty()) return lhs->code == rhs->code;
+            return lhs->source == rhs->source;
+        };
+
+        std::map<uint64_t, std::vector<vsg::ref_ptr<vsg::ShaderModule>>> uniqueModules;
+        std::map<vsg::ShaderModule*, vsg::ref_ptr<vsg::ShaderModule>> replacements;
+
+        for (auto& entry : _shaderModulesCache)
+        {
+            auto& shaderModule = entry.second;
+            auto& bucket = uniqueModules[hashModule(shaderModule)];
+
+            auto itr = std::find_if(bucket.begin(), bucket.end(), [&](const vsg::ref_ptr<vsg::ShaderModule>& unique) { return sameModule(unique, shaderModule); });
+            if (itr == bucket.end())
+            {
+                bucket.push_back(shaderModule);
+            }
+            else
+            {
+                replacements[shaderModule] = *itr;
+                shaderModule = *itr;
+            }
+        }
+
+        if (replacements.empty()) return;
+
+        for (auto& shaderStage : _shaderStages)
+        {
+            auto itr = replacements.find(shaderStage->module);
+            if (itr != replacements.end()) shaderStage->module = itr->second;
+        }
+
+        DebugLog("GraphBuilder: Collapsed " + std::to_string(_shaderModulesCache.size()) + " shader variants into " + std::to_string(_shaderModulesCache.size() - replacements.size()) + " modules");
+    }
+
+    // rebuild every pipeline from its traits now the shader modules are built and collapsing has settled them. pipelines of
+    // precompiled shaders are fitted to what reflecting their stages reads, along with the descriptor sets and vertex arrays
+    // drawn with them. pipelines that end up the same are bound by one command, and the pipelines recorded while building follow
+    void rebuildPipelines()
+    {
+        std::map<vsg::GraphicsPipeline*, vsg::ref_ptr<vsg::GraphicsPipeline>> rebuilt;
+        std::map<vsg::GraphicsPipeline*, uint32_t> reflectedLocations;
+        std::map<vsg::GraphicsPipeline*, vsg::ref_ptr<vsg::BindGraphicsPipeline>> bindCommands;
+        ReplaceStateCommands replaceCommands;
+
+        // the builder keeps every pipeline it built alive, so the previous pipelines' addresses stay valid as keys
+        for (auto& entry : _pipelineTraits)
+        {
+            auto& bindGraphicsPipeline = entry.first;
+            auto pending = _pendingReflections.find(bindGraphicsPipeline->pipeline.get());
+            if (pending != _pendingReflections.end())
+            {
+                uint32_t vertexLocations = ~0u;
+                if (reflectPipeline(pending->second, *entry.second, vertexLocations)) reflectedLocations[pending->first] = vertexLocations;
+            }
+
+            _pipelineBuilder->build(entry.second);
+            auto graphicsPipeline = _pipelineBuilder->getGraphicsPipeline();
+
+            rebuilt[bindGraphicsPipeline->pipeline.get()] = graphicsPipeline;
+            bindGraphicsPipeline->pipeline = graphicsPipeline;
+
+            auto& bindCommand = bindCommands[graphicsPipeline.get()];
+            if (!bindCommand)
+                bindCommand = bindGraphicsPipeline;
+            else
+                replaceCommands.replacements[bindGraphicsPipeline.get()] = bindCommand;
+        }
+
+        // descriptor sets bound with a reflected pipeline take on its layout, and are shared with the sets of the same
+        // descriptors already fitted to that layout
+        for (auto& pending : _pendingDescriptorSets)
+        {
+            auto graphicsPipeline = rebuilt.find(pending.pipeline);
+            if (graphicsPipeline == rebuilt.end()) continue;
+
+            auto& layout = graphicsPipeline->second->layout;
+            auto setLayout = layout->setLayouts.front();
+            auto& bindDescriptorSet = pending.bindDescriptorSet;
+            if (bindDescriptorSet->layout != layout)
+            {
+                bindDescriptorSet->layout = layout;
+                bindDescriptorSet->descriptorSet->setLayout = setLayout;
+                fitDescriptors(bindDescriptorSet->descriptorSet->descriptors, *setLayout);
+            }
+
+            auto& shared = _bindDescriptorSetCache[std::make_pair(pending.id, static_cast<const vsg::Object*>(setLayout.get()))];
+            if (!shared)
+                shared = bindDescriptorSet;
+            else if (shared != bindDescriptorSet)
+                replaceCommands.replacements[bindDescriptorSet.get()] = shared;
+        }
+        _pendingDescriptorSets.clear();
+
+        vsg::DataList pruned;
+        for (auto& pending : _pendingVertexArrays)
+        {
+            auto vertexLocations = reflectedLocations.find(pending.pipeline);
+            if (vertexLocations != reflectedLocations.end()) pruneVertexArrays(*pending.arrays, pending.locations, vertexLocations->second, pruned);
+        }
+        _pendingVertexArrays.clear();
+        releasePrunedArrays(pruned);
+        _pendingReflections.clear();
+
+        auto remap = [&rebuilt](std::set<vsg::GraphicsPipeline*>& pipelines) {
+            std::set<vsg::GraphicsPipeline*> remapped;
+            for (auto pipeline : pipelines)
+            {
+                auto itr = rebuilt.find(pipeline);
+                remapped.insert(itr != rebuilt.end() ? itr->second.get() : pipeline);
+            }
+            pipelines.swap(remapped);
+        };
+        remap(_bindlessPipelines);
+        remap(_blendedPipelines);
+        remap(_flattenInputs.unbakeablePipelines);
+
+        if (!replaceCommands.replacements.empty())
+        {
+            _root->accept(replaceCommands);
+
+            auto proxy = replaceCommands.replacements.find(_proxyPipeline.get());
+            if (proxy != replaceCommands.replacements.end()) _proxyPipeline = vsg::ref_ptr<vsg::BindGraphicsPipeline>(dynamic_cast<vsg::BindGraphicsPipeline*>(proxy->second.get()));
+        }
+
+        DebugLog("GraphBuilder: Rebuilt " + std::to_string(_pipelineTraits.size()) + " pipelines into " + std::to_string(bindCommands.size()) + " after collapsing shader modules");
     }
 
     void writeFile(std::string fileName)
     {
-        LeafDataCollection leafDataCollection;
-        _root->accept(leafDataCollection);
-        _root->setObject("batch", leafDataCollection.objects);
+        // the proxy pipeline's shaders are generated with the rest
+        if (_settings.hlodClusterSize > 0.0f) _proxyPipeline = createProxyPipeline();
+
+        waitForShaders();
+        collapseShaderModules();
+        rebuildPipelines();
+        finalizeBindlessMaterials();
+
+        // written first so the virtual textures record their tile store before the scene and tiles referencing them are written
+        if (_virtualTextures && !_virtualTextures->empty())
+        {
+            _virtualTextures->writeTileStore(VirtualTextureBuilder::tileStoreFileName(fileName));
+        }
+
+        if (_settings.flattenHierarchy != 0 || _settings.bakeStaticTransforms != 0)
+        {
+            FlattenStats stats;
+            if (_settings.bakeStaticTransforms != 0) bakeStaticTransforms(_root, _flattenInputs, stats);
+            if (_settings.flattenHierarchy != 0) flattenHierarchy(_root, _flattenInputs.staticTransforms, stats);
+            DebugLog("GraphBuilder: Flattening removed " + std::to_string(stats.groupsRemoved) + " groups and " + std::to_string(stats.transformsRemoved) +
+                     " transforms, merged " + std::to_string(stats.transformsMerged) + " transforms and baked " + std::to_string(stats.transformsBaked) + " static transforms");
+        }
+
+        if (_settings.sortStateGroups != 0)
+        {
+            StateChangeCount before = countStateChanges(_root);
+            sortStateGroups(_root, _blendedPipelines);
+            StateChangeCount after = countStateChanges(_root);
+            DebugLog("GraphBuilder: State sorting changed pipeline binds from " + std::to_string(before.pipelines) + " to " + std::to_string(after.pipelines) +
+                     " and descriptor set binds from " + std::to_string(before.descriptorSets) + " to " + std::to_string(after.descriptorSets));
+        }
+
+        // clusters hold copies of the merged stategroups, and tiling keeps each cluster's lod whole
+        if (_settings.hlodClusterSize > 0.0f)
+        {
+            _hlodInputs.staticTransforms = &_flattenInputs.staticTransforms;
+            _hlodInputs.blendedPipelines = _blendedPipelines;
+            _hlodInputs.createProxyState = [this](vsg::ref_ptr<vsg::Data> atlas) { return createProxyState(atlas); };
+
+            HLODStats stats;
+            buildHierarchicalLODs(_root, _settings.hlodClusterSize, _settings.hlodScreenHeightRatio, static_cast<uint32_t>(std::max(_settings.hlodProxyResolution, 1)), _hlodInputs, stats);
+            DebugLog("GraphBuilder: Built " + std::to_string(stats.clusters) + " hlod clusters, simplifying " + std::to_string(stats.sourceTriangles) + " triangles to " +
+                     std::to_string(stats.proxyTriangles) + " proxy triangles");
+        }
+
+        // split into tiles after sorting so each tile holds copies of the merged stategroups
+        std::vector<TilePage> pages;
+        if (_settings.tileSize > 0.0f)
+        {
+            pages = tileScene(_root, _settings.tileSize, _settings.tileScreenHeightRatio, fileName, _blendedPipelines);
+            DebugLog("GraphBuilder: Split the scene into " + std::to_string(pages.size()) + " tiles");
+        }
+
+        // built last so the cullgroups partition the children of the sorted and merged stategroups
+        if (_settings.cullHierarchyLeafSize > 0)
+        {
+            CullHierarchyStats stats;
+            buildCullHierarchy(_root, static_cast<uint32_t>(_settings.cullHierarchyLeafSize), _blendedPipelines, stats);
+            for (auto& page : pages) buildCullHierarchy(page.root, static_cast<uint32_t>(_settings.cullHierarchyLeafSize), _blendedPipelines, stats);
+            DebugLog("GraphBuilder: Cull hierarchy partitioned " + std::to_string(stats.groupsPartitioned) + " groups with " + std::to_string(stats.cullGroupsAdded) +
+                     " cullgroups, at most " + std::to_string(stats.maxDepth) + " deep");
+        }
+
+        // the cullgroups of the hierarchy and the pagedlods of the tiles are what gets switched
+        if (_settings.pvsCellSize > 0.0f)
+        {
+            PVSStats stats;
+            buildPotentiallyVisibleSet(_root, _settings.pvsCellSize, static_cast<uint32_t>(std::max(_settings.pvsResolution, 1)), _blendedPipelines, &_flattenInputs.staticTransforms, stats);
+            double hidden = stats.cells > 0 && stats.targets > 0 ? 100.0 * static_cast<double>(stats.hiddenPairs) / (static_cast<double>(stats.cells) * stats.targets) : 0.0;
+            DebugLog("GraphBuilder: Potentially visible set of " + std::to_string(stats.cells) + " cells of size " + std::to_string(stats.cellSize) + " from " +
+                     std::to_string(stats.occluderTriangles) + " occluder triangles switches " + std::to_string(stats.switchedTargets) + " of " + std::to_string(stats.targets) +
+                     " targets, hiding " + std::to_string(hidden) + "% of them per cell");
+        }
+
+        // the rest of the leaf data, including what the passes above created, is streamed out before the scene references its placeholders.
+        // without streaming all of it is packed now, in the order it's drawn
+        if (!_leafStream && _settings.packLeafData != 0)
+        {
+            _leafStream = new LeafStreamWriter();
+            if (!_leafStream->valid()) _leafStream = nullptr;
+        }
+
+        if (_leafStream)
+        {
+            releaseStreamedData(_leafStream->finish(_root, fileName));
+            DebugLog("GraphBuilder: Wrote " + std::to_string(_leafStream->arraysWritten()) + " arrays (" + std::to_string(_leafStream->bytesWritten() / (1024 * 1024)) +
+                     "MB, " + std::to_string(_leafStream->bytesPadded() / 1024) + "KB of it alignment) of leaf data to " + LeafStreamWriter::leafFileName(fileName));
+        }
+
+        // leaf data written to the leaf file is only referenced by placeholders, so there's nothing to batch
+        if (!_leafStream)
+        {
+            LeafDataCollection leafDataCollection;
+            _root->accept(leafDataCollection);
+            _root->setObject("batch", leafDataCollection.objects);
+        }
 
         vsg::VSG io;
         io.write(_root, fileName);
+
+        // tiles aren't compressed, the pager reads them with vsg's own readers
+        if (_settings.compressionLevel > 0)
+        {
+            CompressionStats stats;
+            if (compressFile(fileName, _settings.compressionLevel, stats))
+            {
+                DebugLog("GraphBuilder: Compressed the scene from " + std::to_string(stats.uncompressedSize) + " to " + std::to_string(stats.compressedSize) + " bytes in " +
+                         std::to_string(stats.chunks) + " chunks");
+            }
+        }
+
+        // tiles are written relative to the scene file, which the pagedlods reference them by
+        auto sceneDirectory = std::filesystem::path(fileName).parent_path();
+        for (auto& page : pages)
+        {
+            auto pagePath = sceneDirectory / page.fileName;
+            std::error_code ec;
+            std::filesystem::create_directories(pagePath.parent_path(), ec);
+
+            LeafDataCollection pageDataCollection;
+            page.root->accept(pageDataCollection);
+            page.root->setObject("batch", pageDataCollection.objects);
+
+            if (!io.write(page.root, pagePath.string())) DebugLog("GraphBuilder Error: Failed to write tile " + pagePath.string());
+
+            _pages.push_back(page.root);
+        }
+
+        if (_shaderCache)
+        {
+            _shaderCache->trim();
+            DebugLog(_shaderCache->statistics());
+        }
     }
 
     void releaseObjects()
     {
         LeafDataRelease releaser;
         _root->accept(releaser);
+        for (auto& page : _pages) page->accept(releaser);
     }
 
+    ExportSettingsData _settings;
+
     vsg::ref_ptr<vsg::MatrixTransform> _root;
 
+    // tiles moved out of the root when writing tiled, their data is released along with the root's
+    std::vector<vsg::ref_ptr<vsg::Node>> _pages;
+
+    // pages large textures out to a tile store, null if virtual texturing is disabled
+    vsg::ref_ptr<VirtualTextureBuilder> _virtualTextures;
+
+    // compiled spirv shared between exports, null if precompiling is disabled or no cache directory is set
+    vsg::ref_ptr<ShaderCache> _shaderCache;
+
+    // shader modules are read, preprocessed and compiled on these threads, created on the first shader request
+    vsg::ref_ptr<ThreadPool> _shaderThreads;
+    std::vector<std::shared_future<void>> _shaderTasks;
+
+    // pixels of textures converted from formats vulkan can't sample, keyed by the texture data or virtual texture referencing them
+    std::map<vsg::Object*, vsg::ref_ptr<vsg::ubyteArray>> _convertedPixels;
+
+    // writes leaf data out as nodes end, null unless streaming. the arrays of unity's memory it has to let go of, and the mesh id of
+    // each cached mesh array so the caches can be pointed at its placeholder
+    vsg::ref_ptr<LeafStreamWriter> _leafStream;
+    std::set<vsg::Data*> _externalData;
+    std::map<vsg::Data*, int> _meshArrayIds;
+
+    // pointers to unity's memory let go of that unity hasn't taken back yet
+    std::vector<void*> _releasedData;
+
     // the stack of nodes added, last node is the current head being acted on
     std::vector<vsg::ref_ptr<vsg::Node>> _nodeStack;
 
@@ -1047,38 +2353,105 @@ public:
     // the unique ids of the of the descriptos list being built
     std::vector<std::string> _descriptorObjectIds;
 
+    // the textures by binding and the packed uniform block of the descriptors being built, bindless materials are recorded from these
+    std::vector<std::pair<uint32_t, vsg::ref_ptr<vsg::DescriptorImage>>> _descriptorTextures;
+    std::vector<float> _descriptorBlockData;
+
+    // the color uniforms of the descriptors being built, the first tints the material's color for hlod proxies
+    std::vector<vsg::vec4> _descriptorColors;
+
     // caches
 
-    std::map<int, vsg::ref_ptr<vsg::Command>> _bindVertexBuffersCache;
+    std::map<std::pair<int, vsg::GraphicsPipeline*>, vsg::ref_ptr<vsg::Command>> _bindVertexBuffersCache; // keyed on mesh id and the pipeline the arrays are fitted to if pending reflection
     std::map<int, vsg::ref_ptr<vsg::Command>> _bindIndexBufferCache;
     std::map<int, vsg::ref_ptr<vsg::Command>> _drawIndexedCache;
-    std::map<int, vsg::ref_ptr<vsg::VertexIndexDraw>> _vertexIndexDrawCache;
+    std::map<std::pair<int, vsg::GraphicsPipeline*>, vsg::ref_ptr<vsg::VertexIndexDraw>> _vertexIndexDrawCache;
+    std::map<int, vsg::ref_ptr<vsg::Data>> _vertexPositionsCache;
+    std::map<int, std::pair<vsg::DataList, std::vector<uint32_t>>> _vertexArraysCache; // the arrays of each mesh id and their locations
+    std::map<int, vsg::ref_ptr<vsg::Data>> _indicesCache;
 
     // map of shader modules to the masks used to create them
     std::map<std::string, vsg::ref_ptr<vsg::ShaderModule>> _shaderModulesCache;
 
+    // every shader stage created, so stages can be repointed when modules are collapsed
+    std::vector<vsg::ref_ptr<vsg::ShaderStage>> _shaderStages;
+
     // map of descriptorimage to the ImageData ID they represent
     std::map<int, vsg::ref_ptr<vsg::DescriptorImage>> _textureCache;
 
-    // map of bind descriptor set to IDs
-    std::map<std::string, vsg::ref_ptr<vsg::BindDescriptorSet>> _bindDescriptorSetCache;
+    // the image info of each ImageData ID converted and its average color if one was read
+    struct CachedImage
+    {
+        vsg::ref_ptr<vsg::ImageInfo> imageInfo;
+        bool averaged = false;
+        vsg::vec4 averageColor;
+    };
+    std::map<int, CachedImage> _imageCache;
+
+    // hlod clustering, the average color of each texture that could be read, the material colors and the pipeline proxies draw with
+    std::map<vsg::DescriptorImage*, vsg::vec4> _textureColors;
+    HLODInputs _hlodInputs;
+    vsg::ref_ptr<vsg::BindGraphicsPipeline> _proxyPipeline;
+
+    // the textures filling sampler bindings of a set layout no descriptor of a material fills, by binding
+    std::map<uint32_t, vsg::ref_ptr<vsg::DescriptorImage>> _placeholderTextures;
+    vsg::ref_ptr<vsg::ImageInfo> _placeholderImage;
+
+    // pipelines of precompiled shaders are rebuilt from reflecting their stages once the modules are built, rather than waiting
+    // on each module as its pipeline is added. the material bindings of each such pipeline, and the descriptor sets and vertex
+    // arrays drawn with it that are fitted to it then
+    std::map<vsg::GraphicsPipeline*, PendingReflection> _pendingReflections;
+    std::vector<PendingDescriptorSet> _pendingDescriptorSets;
+    std::vector<PendingVertexArrays> _pendingVertexArrays;
+
+    // bindless materials, the pipelines built from bindless shaders, the one set they share and the arrays that fill it, the
+    // images of each texture so they can be added to the array and the push constant selecting each material's record
+    std::set<vsg::GraphicsPipeline*> _bindlessPipelines;
+    vsg::ref_ptr<vsg::DescriptorSet> _bindlessDescriptorSet;
+    vsg::ref_ptr<vsg::BindDescriptorSet> _bindBindlessDescriptorSet;
+    vsg::ImageInfoList _bindlessImages;
+    std::vector<uint32_t> _bindlessMaterialData;
+    std::map<vsg::DescriptorImage*, vsg::ImageInfoList> _textureImageInfos;
+    std::map<vsg::DescriptorImage*, uint32_t> _bindlessTextureIndices;
+    std::map<std::string, vsg::ref_ptr<vsg::PushConstants>> _bindlessMaterials;
+
+    // map of bind descriptor set to IDs, and the set layout they're fitted to or the pipeline they're to be fitted to
+    std::map<std::pair<std::string, const vsg::Object*>, vsg::ref_ptr<vsg::BindDescriptorSet>> _bindDescriptorSetCache;
 
     // map of bind graphics piplelines to IDs
     std::map<std::string, vsg::ref_ptr<vsg::BindGraphicsPipeline>> _bindGraphicsPipelineCache;
 
+    // builds every pipeline in the export so equivalent pipelines and their layouts and states are shared, and the bind command for each distinct pipeline
+    vsg::ref_ptr<vsg::GraphicsPipelineBuilder> _pipelineBuilder;
+    std::map<vsg::GraphicsPipeline*, vsg::ref_ptr<vsg::BindGraphicsPipeline>> _bindGraphicsPipelines;
+    std::vector<std::pair<vsg::ref_ptr<vsg::BindGraphicsPipeline>, vsg::ref_ptr<vsg::GraphicsPipelineBuilder::Traits>>> _pipelineTraits;
+
+    // pipelines that blend, state sorting keeps the order of what they draw
+    std::set<vsg::GraphicsPipeline*> _blendedPipelines;
+
+    // the static transforms, direction vertex arrays and model matrix dependent pipelines flattening needs to bake transforms
+    FlattenInputs _flattenInputs;
+
+    // depth only variants, the depth only pipeline of each full pipeline that has one, the depth only twin of each stategroup and
+    // commands node drawn with one, and the position only draws and vertex bindings of each mesh
+    std::map<vsg::GraphicsPipeline*, vsg::ref_ptr<vsg::BindGraphicsPipeline>> _depthOnlyPipelines;
+    std::map<vsg::Node*, vsg::ref_ptr<vsg::Node>> _depthOnlyNodes;
+    std::map<int, vsg::ref_ptr<vsg::VertexIndexDraw>> _depthOnlyVertexIndexDrawCache;
+    std::map<int, vsg::ref_ptr<vsg::Command>> _depthOnlyBindVertexBuffersCache;
+
     std::string _saveFileName;
 };
 
 vsg::ref_ptr<GraphBuilder> _builder;
 
-void unity2vsg_BeginExport()
+void unity2vsg_BeginExport(unity2vsg::ExportSettingsData settings)
 {
     if (_builder.valid())
     {
         DebugLog("GraphBuilder Error: Export already in progress.");
         return;
     }
-    _builder = vsg::ref_ptr<GraphBuilder>(new GraphBuilder());
+    _builder = vsg::ref_ptr<GraphBuilder>(new GraphBuilder(settings));
 }
 
 void unity2vsg_EndExport(const char* saveFileName)
@@ -1089,6 +2462,12 @@ void unity2vsg_EndExport(const char* saveFileName)
     _builder = nullptr;
 }
 
+uint32_t unity2vsg_TakeReleasedData(void** pointers, uint32_t capacity)
+{
+    if (!_builder.valid()) return 0;
+    return _builder->takeReleasedData(pointers, capacity);
+}
+
 void unity2vsg_AddGroupNode()
 {
     _builder->addGroup();
@@ -1201,6 +2580,11 @@ void unity2vsg_AddDescriptorBufferVectorArray(unity2vsg::DescriptorVectorArrayUn
     _builder->addDescriptorBuffer(data);
 }
 
+void unity2vsg_AddDescriptorBufferBlock(unity2vsg::DescriptorUniformBlockData data)
+{
+    _builder->addDescriptorBuffer(data);
+}
+
 void unity2vsg_EndNode()
 {
     _builder->popNodeFromStack();
@@ -1210,8 +2594,26 @@ void unity2vsg_LaunchViewer(const char* filename, uint32_t useCamData, unity2vsg
 {
     try
     {
+        // tiles of a tiled export are found relative to the scene file
+        auto options = vsg::Options::create();
+        options->paths.push_back(std::filesystem::path(filename).parent_path().string());
+
         vsg::VSG io;
-        vsg::ref_ptr<vsg::Node> vsg_scene = io.read_cast<vsg::Node>(filename);
+        vsg::ref_ptr<vsg::Node> vsg_scene;
+
+        // compressed scenes are decompressed in memory and read from there
+        std::string contents;
+        if (unity2vsg::decompressFile(filename, contents))
+        {
+            unity2vsg::MemoryStreamBuffer buffer(&contents[0], contents.size());
+            std::istream stream(&buffer);
+            vsg_scene = io.read_cast<vsg::Node>(stream, options);
+            std::string().swap(contents);
+        }
+        else
+        {
+            vsg_scene = io.read_cast<vsg::Node>(filename, options);
+        }
 
         /*std::stringstream ss;
         ss << "cam pos: " << camdata.position.x << ", " << camdata.position.y << ", " << camdata.position.z << std::endl;
@@ -1222,11 +2624,23 @@ void unity2vsg_LaunchViewer(const char* filename, uint32_t useCamData, unity2vsg
 
         if (!vsg_scene.valid()) return;
 
+        // scenes exported with their leaf data streamed out or packed reference placeholders that are pointed at a mapping of the file
+        // beside them, falling back to reading copies. declared after the scene so the mapping is let go of first
+        vsg::ref_ptr<unity2vsg::MappedLeafData> leafData(new unity2vsg::MappedLeafData(vsg_scene, filename));
+        if (!leafData->valid()) unity2vsg::readStreamedLeafData(vsg_scene, filename);
+
+        // scenes exported with a potentially visible set only draw what can be seen from the cell the camera is in
+        vsg::ref_ptr<unity2vsg::PotentiallyVisibleSet> pvs(new unity2vsg::PotentiallyVisibleSet(vsg_scene));
+
         auto windowTraits = vsg::WindowTraits::create();
         windowTraits->windowTitle = "vsg export - " + std::string(filename);
         windowTraits->width = 800;
         windowTraits->height = 600;
 
+        // bindless materials index their texture array with a value read per draw
+        windowTraits->deviceFeatures = vsg::DeviceFeatures::create();
+        windowTraits->deviceFeatures->get().shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+
         // create the viewer and assign window(s) to it
         auto viewer = vsg::Viewer::create();
 
@@ -1280,6 +2694,8 @@ void unity2vsg_LaunchViewer(const char* filename, uint32_t useCamData, unity2vsg
             // pass any events into EventHandlers assigned to the Viewer
             viewer->handleEvents();
 
+            if (pvs->valid()) pvs->update(lookAt->eye);
+
             viewer->update();
 
             viewer->recordAndSubmit();